@@ -271,6 +271,8 @@ void DataStore::savePrefs(const NodePrefs& _prefs, double node_lat, double node_
 void DataStore::loadContacts(DataStoreHost* host) {
 File file = openRead(_getContactsChannelsFS(), "/contacts3");
     if (file) {
+      // RTT estimates are in a separate file (same order), so contacts3 stays readable by older firmware
+      File rtt_file = openRead(_getContactsChannelsFS(), "/contact_rtts");
       bool full = false;
       while (!full) {
         ContactInfo c;
@@ -292,9 +294,16 @@ File file = openRead(_getContactsChannelsFS(), "/contacts3");
 
         if (!success) break; // EOF
 
+        uint8_t rtt_rec[8];
+        if (rtt_file && rtt_file.read(rtt_rec, 8) == 8 && memcmp(rtt_rec, pub_key, 4) == 0) {
+          memcpy(&c.rtt.srtt, &rtt_rec[4], 2);
+          memcpy(&c.rtt.rttvar, &rtt_rec[6], 2);
+        }
+
         c.id = mesh::Identity(pub_key);
         if (!host->onContactLoaded(c)) full = true;
       }
+      if (rtt_file) rtt_file.close();
       file.close();
     }
 }
@@ -302,6 +311,7 @@ File file = openRead(_getContactsChannelsFS(), "/contacts3");
 void DataStore::saveContacts(DataStoreHost* host) {
   File file = openWrite(_getContactsChannelsFS(), "/contacts3");
   if (file) {
+    File rtt_file = openWrite(_getContactsChannelsFS(), "/contact_rtts");
     uint32_t idx = 0;
     ContactInfo c;
     uint8_t unused = 0;
@@ -322,8 +332,17 @@ void DataStore::saveContacts(DataStoreHost* host) {
 
       if (!success) break; // write failed
 
+      if (rtt_file) {
+        uint8_t rtt_rec[8];
+        memcpy(rtt_rec, c.id.pub_key, 4);
+        memcpy(&rtt_rec[4], &c.rtt.srtt, 2);
+        memcpy(&rtt_rec[6], &c.rtt.rttvar, 2);
+        rtt_file.write(rtt_rec, 8);
+      }
+
       idx++;  // advance to next contact
     }
+    if (rtt_file) rtt_file.close();
     file.close();
   }
 }
@@ -56,6 +56,7 @@
 #define CMD_SEND_ANON_REQ             57
 #define CMD_SET_AUTOADD_CONFIG        58
 #define CMD_GET_AUTOADD_CONFIG        59
+#define CMD_SEND_QUEUED_TXT_MSG       60   // same frame as CMD_SEND_TXT_MSG, but device does the retries
 
 // Stats sub-types for CMD_GET_STATS
 #define STATS_TYPE_CORE               0
@@ -115,6 +116,7 @@
 #define PUSH_CODE_CONTROL_DATA          0x8E   // v8+
 #define PUSH_CODE_CONTACT_DELETED       0x8F // used to notify client app of deleted contact when overwriting oldest
 #define PUSH_CODE_CONTACTS_FULL         0x90 // used to notify client app that contacts storage is full
+#define PUSH_CODE_SEND_FAILED           0x91 // a CMD_SEND_QUEUED_TXT_MSG got no ACK, after all retries
 
 #define ERR_CODE_UNSUPPORTED_CMD        1
 #define ERR_CODE_NOT_FOUND              2
@@ -252,7 +254,7 @@ int MyMesh::getInterferenceThreshold() const {
 
 int MyMesh::calcRxDelay(float score, uint32_t air_time) const {
   if (_prefs.rx_delay_base <= 0.0f) return 0;
-  return (int)((pow(_prefs.rx_delay_base, 0.85f - score) - 1.0) * air_time);
+  return rx_delays.calcRxDelay(_prefs.rx_delay_base, score, air_time);
 }
 
 uint8_t MyMesh::getExtraAckTransmitCount() const {
@@ -734,6 +736,8 @@ void MyMesh::onRawDataRecv(mesh::Packet *packet) {
 
 void MyMesh::onTraceRecv(mesh::Packet *packet, uint32_t tag, uint32_t auth_code, uint8_t flags,
                          const uint8_t *path_snrs, const uint8_t *path_hashes, uint8_t path_len) {
+  BaseChatMesh::onTraceRecv(packet, tag, auth_code, flags, path_snrs, path_hashes, path_len);   // path metrics
+
   uint8_t path_sz = flags & 0x03;  // NEW v1.11+
   if (12 + path_len + (path_len >> path_sz) + 1 > sizeof(out_frame)) {
     MESH_DEBUG_PRINTLN("onTraceRecv(), path_len is too long: %d", (uint32_t)path_len);
@@ -773,6 +777,20 @@ uint32_t MyMesh::calcDirectTimeoutMillisFor(uint32_t pkt_airtime_millis, uint8_t
 
 void MyMesh::onSendTimeout() {}
 
+void MyMesh::onMessageDelivered(const ContactInfo &contact, uint32_t msg_id, uint8_t attempts, uint32_t latency_millis) {
+  out_frame[0] = PUSH_CODE_SEND_CONFIRMED;
+  memcpy(&out_frame[1], &msg_id, 4);
+  memcpy(&out_frame[5], &latency_millis, 4);
+  out_frame[9] = attempts;
+  _serial->writeFrame(out_frame, 10);
+}
+
+void MyMesh::onMessageFailed(const ContactInfo &contact, uint32_t msg_id) {
+  out_frame[0] = PUSH_CODE_SEND_FAILED;
+  memcpy(&out_frame[1], &msg_id, 4);
+  _serial->writeFrame(out_frame, 5);
+}
+
 MyMesh::MyMesh(mesh::Radio &radio, mesh::RNG &rng, mesh::RTCClock &rtc, SimpleMeshTables &tables, DataStore& store, AbstractUITask* ui)
     : BaseChatMesh(radio, *new ArduinoMillis(), rng, rtc, *new StaticPoolPacketManager(16), tables),
       _serial(NULL), telemetry(MAX_PACKET_PAYLOAD - 4), _store(&store), _ui(ui) {
@@ -866,6 +884,7 @@ void MyMesh::begin(bool has_display) {
   _store->loadChannels(this);
 
   radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+  _radio->onParamsChanged();
   radio_set_tx_power(_prefs.tx_power_dbm);
 }
 
@@ -991,6 +1010,34 @@ void MyMesh::handleCmdFrame(size_t len) {
                         ? ERR_CODE_NOT_FOUND
                         : ERR_CODE_UNSUPPORTED_CMD); // unknown recipient, or unsuported TXT_TYPE_*
     }
+  } else if (cmd_frame[0] == CMD_SEND_QUEUED_TXT_MSG && len >= 14) {
+    int i = 1;
+    uint8_t txt_type = cmd_frame[i++];
+    i++;  // attempt (not used, device does the retries)
+    uint32_t msg_timestamp;
+    memcpy(&msg_timestamp, &cmd_frame[i], 4);
+    i += 4;
+    uint8_t *pub_key_prefix = &cmd_frame[i];
+    i += 6;
+    ContactInfo *recipient = lookupContactByPubKey(pub_key_prefix, 6);
+    if (recipient && txt_type == TXT_TYPE_PLAIN) {
+      char *text = (char *)&cmd_frame[i];
+      int tlen = len - i;
+      text[tlen] = 0; // ensure null
+      uint32_t msg_id;
+      if (queueOutboundMessage(*recipient, msg_timestamp, text, msg_id)) {
+        uint32_t est_timeout = 0;   // ie. wait for PUSH_CODE_SEND_CONFIRMED or PUSH_CODE_SEND_FAILED
+        out_frame[0] = RESP_CODE_SENT;
+        out_frame[1] = (recipient->out_path_len < 0) ? 1 : 0;
+        memcpy(&out_frame[2], &msg_id, 4);
+        memcpy(&out_frame[6], &est_timeout, 4);
+        _serial->writeFrame(out_frame, 10);
+      } else {
+        writeErrFrame(ERR_CODE_TABLE_FULL);
+      }
+    } else {
+      writeErrFrame(recipient == NULL ? ERR_CODE_NOT_FOUND : ERR_CODE_UNSUPPORTED_CMD);
+    }
   } else if (cmd_frame[0] == CMD_SEND_CHANNEL_TXT_MSG) { // send GroupChannel msg
     int i = 1;
     uint8_t txt_type = cmd_frame[i++]; // should be TXT_TYPE_PLAIN
@@ -1091,7 +1138,7 @@ void MyMesh::handleCmdFrame(size_t len) {
     uint8_t *pub_key = &cmd_frame[1];
     ContactInfo *recipient = lookupContactByPubKey(pub_key, PUB_KEY_SIZE);
     if (recipient) {
-      recipient->out_path_len = -1;
+      resetPathTo(*recipient);
       // recipient->lastmod = ??   shouldn't be needed, app already has this version of contact
       dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
       writeOKFrame();
@@ -1103,6 +1150,10 @@ void MyMesh::handleCmdFrame(size_t len) {
     ContactInfo *recipient = lookupContactByPubKey(pub_key, PUB_KEY_SIZE);
     uint32_t last_mod = getRTCClock()->getCurrentTime();  // fallback value if not present in cmd_frame
     if (recipient) {
+      int8_t path_len = cmd_frame[1 + 32 + 2];
+      if (path_len != recipient->out_path_len || (path_len > 0 && memcmp(recipient->out_path, &cmd_frame[1 + 32 + 3], path_len) != 0)) {
+        recipient->rtt.reset();   // round trips were of the old path
+      }
       updateContactFromFrame(*recipient, last_mod, cmd_frame, len);
       recipient->lastmod = last_mod;
       dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
@@ -1215,6 +1266,7 @@ void MyMesh::handleCmdFrame(size_t len) {
       savePrefs();
 
       radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+      _radio->onParamsChanged();
       MESH_DEBUG_PRINTLN("OK: CMD_SET_RADIO_PARAMS: f=%d, bw=%d, sf=%d, cr=%d", freq, bw, (uint32_t)sf,
                          (uint32_t)cr);
 
@@ -32,6 +32,7 @@
 #include <helpers/IdentityStore.h>
 #include <helpers/SimpleMeshTables.h>
 #include <helpers/StaticPoolPacketManager.h>
+#include <helpers/RxDelayTable.h>
 #include <target.h>
 
 /* ---------------------------------- CONFIGURATION ------------------------------------- */
@@ -145,6 +146,8 @@ protected:
   uint32_t calcFloodTimeoutMillisFor(uint32_t pkt_airtime_millis) const override;
   uint32_t calcDirectTimeoutMillisFor(uint32_t pkt_airtime_millis, uint8_t path_len) const override;
   void onSendTimeout() override;
+  void onMessageDelivered(const ContactInfo &contact, uint32_t msg_id, uint8_t attempts, uint32_t latency_millis) override;
+  void onMessageFailed(const ContactInfo &contact, uint32_t msg_id) override;
 
   // DataStoreHost methods
   bool onContactLoaded(const ContactInfo& contact) override { return addContact(contact); }
@@ -183,6 +186,7 @@ private:
 
   DataStore* _store;
   NodePrefs _prefs;
+  RxDelayTable rx_delays;
   uint32_t pending_login;
   uint32_t pending_status;
   uint32_t pending_telemetry, pending_discovery;   // pending _TELEMETRY_REQ
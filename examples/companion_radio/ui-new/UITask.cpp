@@ -29,8 +29,33 @@
   #define PRESS_LABEL "long press"
 #endif
 
+#define HOME_WATCH_MILLIS    1000   // how often HomeScreen checks its watched state
+#define HOME_BATT_MILLIS    10000   // how often battery is re-read for the indicator
+
+#define NO_TIMED_REFRESH   0xFFFFFFFF
+
 #include "icons.h"
 
+// returns millis until the text will change
+static int formatAgo(char* dest, int secs) {
+  if (secs < 0) secs = 0;
+  if (secs < 60) {
+    sprintf(dest, "%ds", secs);
+    return 1000;
+  }
+  if (secs < 60*60) {
+    sprintf(dest, "%dm", secs / 60);
+    return (60 - secs % 60) * 1000;
+  }
+  sprintf(dest, "%dh", secs / (60*60));
+  return (60*60 - secs % (60*60)) * 1000;
+}
+
+static uint32_t mixState(uint32_t h, uint32_t v) {
+  h ^= v;
+  return h * 16777619UL;
+}
+
 class SplashScreen : public UIScreen {
   UITask* _task;
   unsigned long dismiss_after;
@@ -65,7 +90,7 @@ public:
     display.setTextSize(1);
     display.drawTextCentered(display.width()/2, 42, FIRMWARE_BUILD_DATE);
 
-    return 1000;
+    return UI_RENDER_IDLE;   // static, until dismissed
   }
 
   void poll() override {
@@ -99,15 +124,22 @@ class HomeScreen : public UIScreen {
   uint8_t _page;
   bool _shutdown_init;
   AdvertPath recent[UI_RECENT_LIST_SIZE];
+  unsigned long next_watch, next_batt_read;
+  uint16_t _batt_mv;
+  int _rendered_batt;          // battery percent, as last rendered
+  uint32_t _rendered_state;    // calcPageState(), as last rendered
 
-
-  void renderBatteryIndicator(DisplayDriver& display, uint16_t batteryMilliVolts) {
+  static int toBattPercent(uint16_t batteryMilliVolts) {
     // Convert millivolts to percentage
     const int minMilliVolts = 3000; // Minimum voltage (e.g., 3.0V)
     const int maxMilliVolts = 4200; // Maximum voltage (e.g., 4.2V)
     int batteryPercentage = ((batteryMilliVolts - minMilliVolts) * 100) / (maxMilliVolts - minMilliVolts);
     if (batteryPercentage < 0) batteryPercentage = 0; // Clamp to 0%
     if (batteryPercentage > 100) batteryPercentage = 100; // Clamp to 100%
+    return batteryPercentage;
+  }
+
+  void renderBatteryIndicator(DisplayDriver& display, int batteryPercentage) {
 
     // battery icon
     int iconWidth = 24;
@@ -146,6 +178,8 @@ class HomeScreen : public UIScreen {
         sensors_nb ++;
       }
       sensors_scroll = sensors_nb > UI_RECENT_LIST_SIZE;
+      if (sensors_scroll) sensors_scroll_offset = (sensors_scroll_offset+1)%sensors_nb;
+      else sensors_scroll_offset = 0;
 #if AUTO_OFF_MILLIS > 0
       next_sensors_refresh = millis() + 5000; // refresh sensor values every 5 sec
 #else
@@ -154,15 +188,81 @@ class HomeScreen : public UIScreen {
     }
   }
 
+  // hash of everything the current page shows, so poll() can tell when it needs re-rendering
+  uint32_t calcPageState() {
+    uint32_t h = mixState(2166136261UL, _page);
+    if (_page == HomePage::FIRST) {
+      h = mixState(h, _task->getMsgCount());
+      h = mixState(h, _task->hasConnection());
+      h = mixState(h, the_mesh.getBLEPin());
+    #ifdef WIFI_SSID
+      h = mixState(h, (uint32_t) WiFi.localIP());
+    #endif
+    } else if (_page == HomePage::RECENT) {
+      the_mesh.getRecentlyHeard(recent, UI_RECENT_LIST_SIZE);
+      for (int i = 0; i < UI_RECENT_LIST_SIZE; i++) {
+        h = mixState(h, recent[i].recv_timestamp);
+        for (int j = 0; j < (int) sizeof(recent[i].name) && recent[i].name[j]; j++) h = mixState(h, recent[i].name[j]);
+      }
+    } else if (_page == HomePage::RADIO) {
+      h = mixState(h, (uint32_t) (_node_prefs->freq * 1000));
+      h = mixState(h, (uint32_t) (_node_prefs->bw * 1000));
+      h = mixState(h, _node_prefs->sf);
+      h = mixState(h, _node_prefs->cr);
+      h = mixState(h, _node_prefs->tx_power_dbm);
+      h = mixState(h, radio_driver.getNoiseFloor());
+    } else if (_page == HomePage::BLUETOOTH) {
+      h = mixState(h, _task->isSerialEnabled());
+#if ENV_INCLUDE_GPS == 1
+    } else if (_page == HomePage::GPS) {
+      h = mixState(h, _task->getGPSState());
+  #ifdef PIN_GPS_SWITCH
+      h = mixState(h, digitalRead(PIN_GPS_SWITCH));
+  #endif
+      LocationProvider* nmea = sensors.getLocationProvider();
+      if (nmea) {
+        h = mixState(h, nmea->isValid());
+        h = mixState(h, nmea->satellitesCount());
+        h = mixState(h, nmea->getLatitude() / 100);    // only to the 4 decimal places shown
+        h = mixState(h, nmea->getLongitude() / 100);
+        h = mixState(h, nmea->getAltitude() / 10);
+      }
+#endif
+    } else if (_page == HomePage::SHUTDOWN) {
+      h = mixState(h, _shutdown_init);
+    }
+    return h;
+  }
+
 public:
   HomeScreen(UITask* task, mesh::RTCClock* rtc, SensorManager* sensors, NodePrefs* node_prefs)
      : _task(task), _rtc(rtc), _sensors(sensors), _node_prefs(node_prefs), _page(0), 
-       _shutdown_init(false), sensors_lpp(200) {  }
+       _shutdown_init(false), sensors_lpp(200) {
+    next_watch = next_batt_read = 0;
+    _batt_mv = 0;
+    _rendered_batt = -1;
+    _rendered_state = 0;
+  }
 
   void poll() override {
     if (_shutdown_init && !_task->isButtonPressed()) {  // must wait for USR button to be released
       _task->shutdown();
     }
+    if (!_task->isDisplayOn() || millis() < next_watch) return;   // nothing to watch for
+    next_watch = millis() + HOME_WATCH_MILLIS;
+
+    if (millis() >= next_batt_read) {
+      _batt_mv = _task->getBattMilliVolts();
+      next_batt_read = millis() + HOME_BATT_MILLIS;
+      if (toBattPercent(_batt_mv) != _rendered_batt) invalidate();
+    }
+#if UI_SENSORS_PAGE == 1
+    if (_page == HomePage::SENSORS && millis() > next_sensors_refresh) {
+      refresh_sensors();
+      invalidate();
+    }
+#endif
+    if (calcPageState() != _rendered_state) invalidate();
   }
 
   int render(DisplayDriver& display) override {
@@ -176,7 +276,14 @@ public:
     display.print(filtered_name);
 
     // battery voltage
-    renderBatteryIndicator(display, _task->getBattMilliVolts());
+    if (_batt_mv == 0) {
+      _batt_mv = _task->getBattMilliVolts();
+      next_batt_read = millis() + HOME_BATT_MILLIS;
+    }
+    _rendered_batt = toBattPercent(_batt_mv);
+    renderBatteryIndicator(display, _rendered_batt);
+    _rendered_state = calcPageState();
+    int stale_millis = UI_RENDER_IDLE;
 
     // curr page indicator
     int y = 14;
@@ -219,14 +326,8 @@ public:
       for (int i = 0; i < UI_RECENT_LIST_SIZE; i++, y += 11) {
         auto a = &recent[i];
         if (a->name[0] == 0) continue;  // empty slot
-        int secs = _rtc->getCurrentTime() - a->recv_timestamp;
-        if (secs < 60) {
-          sprintf(tmp, "%ds", secs);
-        } else if (secs < 60*60) {
-          sprintf(tmp, "%dm", secs / 60);
-        } else {
-          sprintf(tmp, "%dh", secs / (60*60));
-        }
+        int stale = formatAgo(tmp, _rtc->getCurrentTime() - a->recv_timestamp);
+        if (stale < stale_millis) stale_millis = stale;
         
         int timestamp_width = display.getTextWidth(tmp);
         int max_name_width = display.width() - timestamp_width - 1;
@@ -309,7 +410,7 @@ public:
 #if UI_SENSORS_PAGE == 1
     } else if (_page == HomePage::SENSORS) {
       int y = 18;
-      refresh_sensors();
+      if (next_sensors_refresh == 0) refresh_sensors();
       char buf[30];
       char name[30];
       LPPReader r(sensors_lpp.getBuffer(), sensors_lpp.getSize());
@@ -375,8 +476,6 @@ public:
         display.print(buf);
         y = y + 12;
       }
-      if (sensors_scroll) sensors_scroll_offset = (sensors_scroll_offset+1)%sensors_nb;
-      else sensors_scroll_offset = 0;
 #endif
     } else if (_page == HomePage::SHUTDOWN) {
       display.setColor(DisplayDriver::GREEN);
@@ -388,7 +487,7 @@ public:
         display.drawTextCentered(display.width() / 2, 64 - 11, "hibernate:" PRESS_LABEL);
       }
     }
-    return 5000;   // next render after 5000 ms
+    return stale_millis;
   }
 
   bool handleInput(char c) override {
@@ -480,14 +579,7 @@ public:
 
     auto p = &unread[0];
 
-    int secs = _rtc->getCurrentTime() - p->timestamp;
-    if (secs < 60) {
-      sprintf(tmp, "%ds", secs);
-    } else if (secs < 60*60) {
-      sprintf(tmp, "%dm", secs / 60);
-    } else {
-      sprintf(tmp, "%dh", secs / (60*60));
-    }
+    int stale_millis = formatAgo(tmp, _rtc->getCurrentTime() - p->timestamp);
     display.setCursor(display.width() - display.getTextWidth(tmp) - 2, 0);
     display.print(tmp);
 
@@ -505,11 +597,10 @@ public:
     display.translateUTF8ToBlocks(filtered_msg, p->msg, sizeof(filtered_msg));
     display.printWordWrap(filtered_msg, display.width());
 
-#if AUTO_OFF_MILLIS==0 // probably e-ink
-    return 10000; // 10 s
-#else
-    return 1000;  // next render after 1000 ms
+#if AUTO_OFF_MILLIS==0 // probably e-ink, limit refresh rate
+    if (stale_millis < 10000) stale_millis = 10000;
 #endif
+    return stale_millis;
   }
 
   bool handleInput(char c) override {
@@ -585,6 +676,7 @@ void UITask::begin(DisplayDriver* display, SensorManager* sensors, NodePrefs* no
 void UITask::showAlert(const char* text, int duration_millis) {
   strcpy(_alert, text);
   _alert_expiry = millis() + duration_millis;
+  invalidate();
 }
 
 void UITask::notify(UIEventType t) {
@@ -635,8 +727,7 @@ void UITask::newMsg(uint8_t path_len, const char* from_name, const char* text, i
       _display->turnOn();
     }
     if (_display->isOn()) {
-    _auto_off = millis() + AUTO_OFF_MILLIS;  // extend the auto-off timer
-    _next_refresh = 100;  // trigger refresh
+      _auto_off = millis() + AUTO_OFF_MILLIS;  // extend the auto-off timer
     }
   }
 }
@@ -664,7 +755,7 @@ void UITask::userLedHandler() {
 
 void UITask::setCurrScreen(UIScreen* c) {
   curr = c;
-  _next_refresh = 100;
+  c->invalidate();
 }
 
 /*
@@ -767,9 +858,8 @@ void UITask::loop() {
 #endif
 
   if (c != 0 && curr) {
-    curr->handleInput(c);
+    if (curr->handleInput(c)) curr->invalidate();
     _auto_off = millis() + AUTO_OFF_MILLIS;   // extend auto-off timer
-    _next_refresh = 100;  // trigger refresh
   }
 
   userLedHandler();
@@ -781,9 +871,12 @@ void UITask::loop() {
   if (curr) curr->poll();
 
   if (_display != NULL && _display->isOn()) {
-    if (millis() >= _next_refresh && curr) {
+    // only render when something on screen changed, or time based content (eg. '5s ago') is stale
+    if (curr && (curr->getDirty() || millis() >= _next_refresh)) {
       _display->startFrame();
       int delay_millis = curr->render(*_display);
+      curr->clearDirty();
+      _render_count++;
       if (millis() < _alert_expiry) {  // render alert popup
         _display->setTextSize(1);
         int y = _display->height() / 3;
@@ -794,6 +887,8 @@ void UITask::loop() {
         _display->drawRect(p, y, _display->width() - p*2, y);
         _display->drawTextCentered(_display->width() / 2, y + p*3, _alert);
         _next_refresh = _alert_expiry;   // will need refresh when alert is dismissed
+      } else if (delay_millis == UI_RENDER_IDLE) {
+        _next_refresh = NO_TIMED_REFRESH;   // wait for an invalidate()
       } else {
         _next_refresh = millis() + delay_millis;
       }
@@ -840,10 +935,10 @@ char UITask::checkDisplayOn(char c) {
   if (_display != NULL) {
     if (!_display->isOn()) {
       _display->turnOn();   // turn display on and consume event
+      invalidate();
       c = 0;
     }
     _auto_off = millis() + AUTO_OFF_MILLIS;   // extend auto-off timer
-    _next_refresh = 0;  // trigger refresh
   }
   return c;
 }
@@ -899,7 +994,6 @@ void UITask::toggleGPS() {
         }
         the_mesh.savePrefs();
         showAlert(_node_prefs->gps_enabled ? "GPS: Enabled" : "GPS: Disabled", 800);
-        _next_refresh = 0;
         break;
       }
     }
@@ -918,6 +1012,5 @@ void UITask::toggleBuzzer() {
     _node_prefs->buzzer_quiet = buzzer.isQuiet();
     the_mesh.savePrefs();
     showAlert(buzzer.isQuiet() ? "Buzzer: OFF" : "Buzzer: ON", 800);
-    _next_refresh = 0;  // trigger refresh
   #endif
 }
@@ -36,6 +36,7 @@ class UITask : public AbstractUITask {
   char _alert[80];
   unsigned long _alert_expiry;
   int _msgcount;
+  uint32_t _render_count;
   unsigned long ui_started_at, next_batt_chck;
   int next_backlight_btn_check = 0;
 #ifdef PIN_STATUS_LED
@@ -67,6 +68,7 @@ public:
 
   UITask(mesh::MainBoard* board, BaseSerialInterface* serial) : AbstractUITask(board, serial), _display(NULL), _sensors(NULL) {
     next_batt_chck = _next_refresh = 0;
+    _render_count = 0;
     ui_started_at = 0;
     curr = NULL;
   }
@@ -76,6 +78,9 @@ public:
   void showAlert(const char* text, int duration_millis);
   int  getMsgCount() const { return _msgcount; }
   bool hasDisplay() const { return _display != NULL; }
+  bool isDisplayOn() const { return _display != NULL && _display->isOn(); }
+  void invalidate() { if (curr) curr->invalidate(); }   // current screen needs re-rendering
+  uint32_t getRenderCount() const { return _render_count; }   // for measuring redraw work
   bool isButtonPressed() const;
 
   void toggleBuzzer();
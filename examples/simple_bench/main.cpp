@@ -0,0 +1,366 @@
+#include <Arduino.h>   // needed for PlatformIO
+#include <Mesh.h>
+
+#include <helpers/ArduinoHelpers.h>
+#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/SimpleMeshTables.h>
+#include <helpers/RegionMap.h>
+#include <helpers/AdvertDataHelpers.h>
+#include <helpers/BaseSerialInterface.h>
+#include <Ed25519.h>
+#define ED25519_NO_SEED  1
+#include <ed_25519.h>
+
+/*
+  Micro-benchmarks of the core primitives, run on the actual MCU (no radio needed).
+  Results are printed to Serial, once, as a single JSON document, eg:
+
+    pio run -e Heltec_v3_bench -t upload && pio device monitor > bench_heltec_v3.json
+
+  Diff the results against a previous capture from the same board to spot regressions.
+
+  Also runs a self-test of the two Ed25519 verify implementations (ref10 ed25519_verify(), the default, and rweather
+  Ed25519::verify(), used with -D ED25519_RWEATHER_VERIFY): the RFC 8032 test vectors, agreement on random (and
+  corrupted) signatures, and the stack each one needs.
+*/
+
+/* ---------------------------------- CONFIGURATION ------------------------------------- */
+
+#ifndef BENCH_MIN_MILLIS
+  #define BENCH_MIN_MILLIS   400     // run each case for at least this long
+#endif
+
+#ifndef BENCH_STACK_PAINT_BYTES
+  #define BENCH_STACK_PAINT_BYTES   4096    // stack below setup() to check for use (must be less than the task's stack)
+#endif
+
+#define BENCH_BATCH   8    // calls per timing check (so micros() overhead is amortised)
+#define VERIFY_AGREE_ITERS   200
+
+/* -------------------------------------------------------------------------------------- */
+
+StdRNG fast_rng;
+
+static bool first_result = true;
+
+static void printResult(const char* name, int param, uint32_t iters, uint32_t elapsed_micros) {
+  Serial.print(first_result ? "\n    " : ",\n    ");
+  first_result = false;
+  Serial.printf("{\"name\": \"%s\", \"param\": %d, \"iters\": %u, \"ns_per_op\": %u}", name, param, iters,
+                  (uint32_t) ((uint64_t)elapsed_micros * 1000 / iters));
+}
+
+template<typename F>
+static void bench(const char* name, int param, F fn) {
+  uint32_t iters = 0, elapsed;
+  uint32_t start = micros();
+  do {
+    for (int i = 0; i < BENCH_BATCH; i++) fn();
+    iters += BENCH_BATCH;
+    elapsed = micros() - start;
+  } while (elapsed < BENCH_MIN_MILLIS*1000UL);
+
+  printResult(name, param, iters, elapsed);
+}
+
+static void fillPacket(mesh::Packet* pkt, uint8_t type, int payload_len, uint32_t seq) {
+  pkt->header = ROUTE_TYPE_FLOOD | (type << PH_TYPE_SHIFT);
+  pkt->path_len = 3;
+  pkt->path[0] = 0x11; pkt->path[1] = 0x22; pkt->path[2] = 0x33;
+  pkt->payload_len = payload_len;
+  for (int i = 0; i < payload_len; i++) pkt->payload[i] = (uint8_t)(i * 7);
+  memcpy(pkt->payload, &seq, 4);
+  pkt->invalidateFingerprint();
+}
+
+static void benchCrypto() {
+  static const int lengths[] = { 16, 64, 160 };
+  uint8_t secret[PUB_KEY_SIZE];
+  fast_rng.random(secret, sizeof(secret));
+
+  for (int n = 0; n < sizeof(lengths)/sizeof(lengths[0]); n++) {
+    int len = lengths[n];
+    uint8_t src[MAX_PACKET_PAYLOAD], enc[MAX_PACKET_PAYLOAD + 32], dec[MAX_PACKET_PAYLOAD + 32];
+    fast_rng.random(src, len);
+    int enc_len = mesh::Utils::encryptThenMAC(secret, enc, src, len);
+
+    bench("encryptThenMAC", len, [&]() { mesh::Utils::encryptThenMAC(secret, enc, src, len); });
+    bench("MACThenDecrypt", len, [&]() { mesh::Utils::MACThenDecrypt(secret, dec, enc, enc_len); });
+  }
+}
+
+static void benchPacket() {
+  static const int lengths[] = { 16, 64, 184 };
+  mesh::Packet pkt;
+  uint8_t raw[MAX_TRANS_UNIT + 1], hash[MAX_HASH_SIZE];
+
+  for (int n = 0; n < sizeof(lengths)/sizeof(lengths[0]); n++) {
+    int len = lengths[n];
+    fillPacket(&pkt, PAYLOAD_TYPE_GRP_TXT, len, 1);
+    uint8_t raw_len = pkt.writeTo(raw);
+
+    bench("Packet::calculatePacketHash", len, [&]() { pkt.calculatePacketHash(hash); });
+    bench("Packet::getFingerprint", len, [&]() { pkt.invalidateFingerprint(); pkt.getFingerprint(hash); });
+    bench("Packet::writeTo", len, [&]() { pkt.writeTo(raw); });
+    bench("Packet::readFrom", len, [&]() { pkt.readFrom(raw, raw_len); });
+  }
+}
+
+static void benchMeshTables() {
+  static const int fills[] = { 16, 64, MAX_PACKET_HASHES };
+  mesh::Packet pkt;
+
+  for (int n = 0; n < sizeof(fills)/sizeof(fills[0]); n++) {
+    SimpleMeshTables* tables = new SimpleMeshTables();
+    uint32_t seq = 0;
+    while (seq < fills[n]) {
+      fillPacket(&pkt, PAYLOAD_TYPE_GRP_TXT, 64, seq++);
+      tables->hasSeen(&pkt);
+    }
+    // 'pkt' is now the most recent entry, ie. a hit which scans 'fill' entries
+    bench("SimpleMeshTables::hasSeen(hit)", fills[n], [&]() { tables->hasSeen(&pkt); });
+
+    mesh::Packet other;
+    bench("SimpleMeshTables::hasSeen(miss)", fills[n], [&]() {
+      fillPacket(&other, PAYLOAD_TYPE_GRP_TXT, 64, 0x80000000 | seq++);
+      tables->hasSeen(&other);
+    });
+    delete tables;
+  }
+}
+
+static void benchPacketQueue() {
+  static const int depths[] = { 4, 16, 64 };
+  static mesh::Packet pool[64];
+
+  for (int n = 0; n < sizeof(depths)/sizeof(depths[0]); n++) {
+    int depth = depths[n];
+    PacketQueue* queue = new PacketQueue(depth);
+    for (int i = 0; i < depth - 1; i++) {
+      queue->add(&pool[i], i % 4, 1000 + i);
+    }
+    uint32_t now = 0;
+    bench("PacketQueue::add+get", depth, [&]() {
+      queue->add(&pool[depth - 1], 0, now);
+      queue->get(now);
+    });
+    delete queue;
+  }
+}
+
+// loopback through a serial interface's frame queue (frames/sec = 1e9 / ns_per_op)
+static void benchFrameRing() {
+  static const int lengths[] = { 16, 64, MAX_FRAME_SIZE };
+  FrameRing* ring = new FrameRing(SERIAL_SEND_QUEUE_BYTES);
+  uint8_t src[MAX_FRAME_SIZE], dest[MAX_FRAME_SIZE];
+  fast_rng.random(src, sizeof(src));
+
+  for (int n = 0; n < sizeof(lengths)/sizeof(lengths[0]); n++) {
+    int len = lengths[n];
+    while (ring->canFit(len) && ring->count() < 3) ring->push(src, len);   // part full, so copies wrap around end
+    bench("FrameRing::push+pop", len, [&]() {
+      ring->push(src, len);
+      ring->pop(dest);
+    });
+    ring->clear();
+  }
+  delete ring;
+}
+
+static void benchRegionMap() {
+  static const int counts[] = { 1, 8, MAX_REGION_ENTRIES };
+  TransportKeyStore* store = new TransportKeyStore();
+  mesh::Packet pkt;
+  fillPacket(&pkt, PAYLOAD_TYPE_GRP_TXT, 64, 1);
+  pkt.header = ROUTE_TYPE_TRANSPORT_FLOOD | (PAYLOAD_TYPE_GRP_TXT << PH_TYPE_SHIFT);
+  pkt.transport_codes[0] = pkt.transport_codes[1] = 0;   // (most likely) matches none, ie. worst case
+
+  for (int n = 0; n < sizeof(counts)/sizeof(counts[0]); n++) {
+    RegionMap* regions = new RegionMap(*store);
+    for (int i = 0; i < counts[n]; i++) {
+      char name[16];
+      sprintf(name, "region%d", i);
+      regions->putRegion(name, 0);
+    }
+    bench("RegionMap::findMatch", counts[n], [&]() { regions->findMatch(&pkt, REGION_DENY_FLOOD); });
+    delete regions;
+  }
+  delete store;
+}
+
+static void benchAdverts() {
+  uint8_t app_data[MAX_ADVERT_DATA_SIZE];
+  AdvertDataBuilder builder(ADV_TYPE_REPEATER, "Benchmark Repeater", -33.8688, 151.2093);
+  uint8_t app_data_len = builder.encodeTo(app_data);
+
+  bench("AdvertDataParser", app_data_len, [&]() {
+    AdvertDataParser parser(app_data, app_data_len);
+    if (!parser.isValid()) Serial.print("");   // don't let it be optimised away
+  });
+}
+
+static void benchIdentity() {
+  mesh::LocalIdentity self_id(&fast_rng), other_id(&fast_rng);
+  uint8_t message[PUB_KEY_SIZE + 4 + 32], sig[SIGNATURE_SIZE], secret[PUB_KEY_SIZE];
+  fast_rng.random(message, sizeof(message));
+  self_id.sign(sig, message, sizeof(message));
+
+  mesh::Identity id(self_id.pub_key);
+  bench("LocalIdentity::sign", sizeof(message), [&]() { self_id.sign(sig, message, sizeof(message)); });
+  bench("Identity::verify", sizeof(message), [&]() { id.verify(sig, message, sizeof(message)); });
+  bench("Ed25519::verify(rweather)", sizeof(message), [&]() { Ed25519::verify(sig, id.pub_key, message, sizeof(message)); });
+  bench("ed25519_verify(ref10)", sizeof(message), [&]() { ed25519_verify(sig, message, sizeof(message), id.pub_key); });
+  bench("LocalIdentity::calcSharedSecret", 0, [&]() { self_id.calcSharedSecret(secret, other_id.pub_key); });
+}
+
+/* ---------------------------------- SELF-TEST ------------------------------------- */
+
+// RFC 8032, section 7.1, TEST 1..3
+static const struct {
+  uint8_t pub_key[PUB_KEY_SIZE];
+  uint8_t msg_len;
+  uint8_t msg[2];
+  uint8_t sig[SIGNATURE_SIZE];
+} rfc8032_vectors[] = {
+  {
+    { 0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7, 0xd5, 0x4b, 0xfe, 0xd3, 0xc9, 0x64, 0x07, 0x3a,
+      0x0e, 0xe1, 0x72, 0xf3, 0xda, 0xa6, 0x23, 0x25, 0xaf, 0x02, 0x1a, 0x68, 0xf7, 0x07, 0x51, 0x1a },
+    0, { 0 },
+    { 0xe5, 0x56, 0x43, 0x00, 0xc3, 0x60, 0xac, 0x72, 0x90, 0x86, 0xe2, 0xcc, 0x80, 0x6e, 0x82, 0x8a,
+      0x84, 0x87, 0x7f, 0x1e, 0xb8, 0xe5, 0xd9, 0x74, 0xd8, 0x73, 0xe0, 0x65, 0x22, 0x49, 0x01, 0x55,
+      0x5f, 0xb8, 0x82, 0x15, 0x90, 0xa3, 0x3b, 0xac, 0xc6, 0x1e, 0x39, 0x70, 0x1c, 0xf9, 0xb4, 0x6b,
+      0xd2, 0x5b, 0xf5, 0xf0, 0x59, 0x5b, 0xbe, 0x24, 0x65, 0x51, 0x41, 0x43, 0x8e, 0x7a, 0x10, 0x0b }
+  },
+  {
+    { 0x3d, 0x40, 0x17, 0xc3, 0xe8, 0x43, 0x89, 0x5a, 0x92, 0xb7, 0x0a, 0xa7, 0x4d, 0x1b, 0x7e, 0xbc,
+      0x9c, 0x98, 0x2c, 0xcf, 0x2e, 0xc4, 0x96, 0x8c, 0xc0, 0xcd, 0x55, 0xf1, 0x2a, 0xf4, 0x66, 0x0c },
+    1, { 0x72 },
+    { 0x92, 0xa0, 0x09, 0xa9, 0xf0, 0xd4, 0xca, 0xb8, 0x72, 0x0e, 0x82, 0x0b, 0x5f, 0x64, 0x25, 0x40,
+      0xa2, 0xb2, 0x7b, 0x54, 0x16, 0x50, 0x3f, 0x8f, 0xb3, 0x76, 0x22, 0x23, 0xeb, 0xdb, 0x69, 0xda,
+      0x08, 0x5a, 0xc1, 0xe4, 0x3e, 0x15, 0x99, 0x6e, 0x45, 0x8f, 0x36, 0x13, 0xd0, 0xf1, 0x1d, 0x8c,
+      0x38, 0x7b, 0x2e, 0xae, 0xb4, 0x30, 0x2a, 0xee, 0xb0, 0x0d, 0x29, 0x16, 0x12, 0xbb, 0x0c, 0x00 }
+  },
+  {
+    { 0xfc, 0x51, 0xcd, 0x8e, 0x62, 0x18, 0xa1, 0xa3, 0x8d, 0xa4, 0x7e, 0xd0, 0x02, 0x30, 0xf0, 0x58,
+      0x08, 0x16, 0xed, 0x13, 0xba, 0x33, 0x03, 0xac, 0x5d, 0xeb, 0x91, 0x15, 0x48, 0x90, 0x80, 0x25 },
+    2, { 0xaf, 0x82 },
+    { 0x62, 0x91, 0xd6, 0x57, 0xde, 0xec, 0x24, 0x02, 0x48, 0x27, 0xe6, 0x9c, 0x3a, 0xbe, 0x01, 0xa3,
+      0x0c, 0xe5, 0x48, 0xa2, 0x84, 0x74, 0x3a, 0x44, 0x5e, 0x36, 0x80, 0xd7, 0xdb, 0x5a, 0xc3, 0xac,
+      0x18, 0xff, 0x9b, 0x53, 0x8d, 0x16, 0xf2, 0x90, 0xae, 0x67, 0xf7, 0x60, 0x98, 0x4d, 0xc6, 0x59,
+      0x4a, 0x7c, 0x15, 0xe9, 0x71, 0x6e, 0xd2, 0x8d, 0xc0, 0x27, 0xbe, 0xce, 0xea, 0x1e, 0xc4, 0x0a }
+  }
+};
+
+#define STACK_PAINT   0xA5
+
+// fills the stack just below the caller's frame with a known value
+static void __attribute__((noinline)) paintStack() {
+  volatile uint8_t area[BENCH_STACK_PAINT_BYTES];
+  for (int i = 0; i < BENCH_STACK_PAINT_BYTES; i++) area[i] = STACK_PAINT;
+}
+
+// how far into the painted area a call (made from the same caller) has reached
+static int __attribute__((noinline)) measureStack() {
+  volatile uint8_t area[BENCH_STACK_PAINT_BYTES];
+  int i = 0;
+  while (i < BENCH_STACK_PAINT_BYTES && area[i] == STACK_PAINT) i++;   // stack grows down, so [0] is deepest
+  return BENCH_STACK_PAINT_BYTES - i;
+}
+
+static void printSelfTest(const char* name, int param, bool rweather, bool ref10, bool pass) {
+  Serial.print(first_result ? "\n    " : ",\n    ");
+  first_result = false;
+  Serial.printf("{\"name\": \"%s\", \"param\": %d, \"rweather\": %d, \"ref10\": %d, \"pass\": %s}", name, param,
+                  rweather, ref10, pass ? "true" : "false");
+}
+
+static void selfTestVerify() {
+  for (int n = 0; n < sizeof(rfc8032_vectors)/sizeof(rfc8032_vectors[0]); n++) {
+    auto& v = rfc8032_vectors[n];
+    bool rw = Ed25519::verify(v.sig, v.pub_key, v.msg, v.msg_len);
+    bool r10 = ed25519_verify(v.sig, v.msg, v.msg_len, v.pub_key);
+    printSelfTest("rfc8032", n + 1, rw, r10, rw && r10);
+
+    uint8_t bad_sig[SIGNATURE_SIZE];
+    memcpy(bad_sig, v.sig, SIGNATURE_SIZE);
+    bad_sig[n*7 % SIGNATURE_SIZE] ^= 0x10;
+    rw = Ed25519::verify(bad_sig, v.pub_key, v.msg, v.msg_len);
+    r10 = ed25519_verify(bad_sig, v.msg, v.msg_len, v.pub_key);
+    printSelfTest("rfc8032(corrupt)", n + 1, rw, r10, !rw && !r10);
+  }
+
+  // random keys and messages, signed by LocalIdentity, then every other one corrupted
+  int rw_ok = 0, r10_ok = 0, mismatches = 0;
+  for (int n = 0; n < VERIFY_AGREE_ITERS; n++) {
+    mesh::LocalIdentity id(&fast_rng);
+    uint8_t message[MAX_PACKET_PAYLOAD], sig[SIGNATURE_SIZE];
+    int len = fast_rng.nextInt(0, sizeof(message) + 1);
+    fast_rng.random(message, len);
+    id.sign(sig, message, len);
+    if (n & 1) {
+      if (len > 0 && (n & 2)) {
+        message[fast_rng.nextInt(0, len)] ^= 1 << fast_rng.nextInt(0, 8);
+      } else {
+        sig[fast_rng.nextInt(0, SIGNATURE_SIZE)] ^= 1 << fast_rng.nextInt(0, 8);
+      }
+    }
+    bool rw = Ed25519::verify(sig, id.pub_key, message, len);
+    bool r10 = ed25519_verify(sig, message, len, id.pub_key);
+    if (rw == ((n & 1) == 0)) rw_ok++;
+    if (r10 == ((n & 1) == 0)) r10_ok++;
+    if (rw != r10) mismatches++;
+  }
+  printSelfTest("verify(random)", VERIFY_AGREE_ITERS, rw_ok, r10_ok, rw_ok == VERIFY_AGREE_ITERS && r10_ok == VERIFY_AGREE_ITERS && mismatches == 0);
+
+  // stack high-water of each (if it reaches BENCH_STACK_PAINT_BYTES, the real figure is higher)
+  auto& v = rfc8032_vectors[2];
+  paintStack();
+  bool rw = Ed25519::verify(v.sig, v.pub_key, v.msg, v.msg_len);
+  int rw_stack = measureStack();
+  paintStack();
+  bool r10 = ed25519_verify(v.sig, v.msg, v.msg_len, v.pub_key);
+  int r10_stack = measureStack();
+  printSelfTest("verify_stack_bytes", BENCH_STACK_PAINT_BYTES, rw_stack, r10_stack,
+                  rw && r10 && rw_stack < BENCH_STACK_PAINT_BYTES && r10_stack < BENCH_STACK_PAINT_BYTES);
+}
+
+/* -------------------------------------------------------------------------------------- */
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);    // allow time for monitor to connect
+
+  fast_rng.begin(12345);    // fixed seed, for repeatable inputs
+
+  Serial.print("{\n  \"platform\": \"");
+#if defined(NRF52_PLATFORM)
+  Serial.print("nrf52");
+#elif defined(RP2040_PLATFORM)
+  Serial.print("rp2040");
+#elif defined(STM32_PLATFORM)
+  Serial.print("stm32");
+#elif defined(ESP32)
+  Serial.print("esp32");
+#else
+  Serial.print("unknown");
+#endif
+  Serial.printf("\",\n  \"cpu_mhz\": %d,\n  \"min_millis\": %d,\n  \"results\": [", (int)(F_CPU / 1000000), BENCH_MIN_MILLIS);
+
+  benchCrypto();
+  benchPacket();
+  benchMeshTables();
+  benchPacketQueue();
+  benchFrameRing();
+  benchRegionMap();
+  benchAdverts();
+  benchIdentity();
+
+  Serial.print("\n  ],\n  \"self_test\": [");
+  first_result = true;
+  selfTestVerify();
+
+  Serial.print("\n  ]\n}\n");
+}
+
+void loop() {
+}
@@ -0,0 +1,148 @@
+#include "LinkEstimator.h"
+
+#if MAX_NEIGHBOURS
+
+LinkEstimator::LinkEstimator() {
+  memset(_links, 0, sizeof(_links));
+  memset(_sent, 0, sizeof(_sent));
+  _next_sent = 0;
+  _snr_floor = -12.5f;   // SF9
+  _avg_quality = -1.0f;
+}
+
+int LinkEstimator::findSlot(uint8_t hash) const {
+  int slot = -1;
+  for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+    if (_links[i].active && _links[i].hash == hash) {
+      if (slot >= 0) return -1;   // hash collision, ambiguous
+      slot = i;
+    }
+  }
+  return slot;
+}
+
+void LinkEstimator::setNeighbour(int slot, uint8_t hash) {
+  if (_links[slot].active && _links[slot].hash == hash) return;   // no change
+
+  memset(&_links[slot], 0, sizeof(_links[slot]));
+  _links[slot].hash = hash;
+  _links[slot].active = true;
+  for (int i = 0; i < LINK_TX_HISTORY; i++) {   // don't count TXs from before it was a neighbour
+    _sent[i].excluded |= (1ULL << slot);
+  }
+}
+
+void LinkEstimator::clearNeighbour(int slot) {
+  memset(&_links[slot], 0, sizeof(_links[slot]));
+  updateAvgQuality();
+}
+
+void LinkEstimator::onTxFlood(const mesh::Packet* pkt, unsigned long now) {
+  SentFlood& s = _sent[_next_sent];
+  if (s.sent_at) finalise(s);   // oldest, echo window (nearly) over anyway
+
+  uint8_t fp[MAX_HASH_SIZE];
+  pkt->getFingerprint(fp);
+  memcpy(&s.fingerprint, fp, 4);
+  s.path_len = pkt->path_len;
+  s.sent_at = now ? now : 1;
+  s.echoed = s.excluded = 0;
+  for (int i = 0; i < pkt->path_len; i++) {   // these have already forwarded it
+    int slot = findSlot(pkt->path[i]);
+    if (slot >= 0) s.excluded |= (1ULL << slot);
+  }
+  _next_sent = (_next_sent + 1) % LINK_TX_HISTORY;
+}
+
+void LinkEstimator::onRecv(const mesh::Packet* pkt, float snr, unsigned long now) {
+  if (!pkt->isRouteFlood() || pkt->path_len == 0) return;   // can't tell who transmitted it
+
+  int slot = findSlot(pkt->path[pkt->path_len - 1]);
+  if (slot < 0) return;   // not a (known) neighbour
+
+  LinkStats& l = _links[slot];
+  int16_t snr4 = (int16_t) (snr * 4);
+  l.rx_snr = l.n_rx == 0 ? snr4 : (l.rx_snr * 7 + snr4) / 8;
+  if (l.n_rx < 0xFFFF) l.n_rx++;
+
+  // is this a re-forward of one of ours?
+  uint8_t fp[MAX_HASH_SIZE];
+  uint32_t fingerprint;
+  pkt->getFingerprint(fp);
+  memcpy(&fingerprint, fp, 4);
+  for (int i = 0; i < LINK_TX_HISTORY; i++) {
+    SentFlood& s = _sent[i];
+    if (s.sent_at && s.fingerprint == fingerprint && pkt->path_len == s.path_len + 1
+        && (long)(now - s.sent_at) < LINK_ECHO_WINDOW_MILLIS) {
+      s.echoed |= (1ULL << slot);
+      break;
+    }
+  }
+}
+
+void LinkEstimator::finalise(SentFlood& s) {
+  for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+    LinkStats& l = _links[i];
+    if (!l.active || (s.excluded & (1ULL << i))) continue;
+
+    bool echoed = (s.echoed & (1ULL << i)) != 0;
+    int sample = echoed ? 255 : 0;
+    l.echo_ratio = l.n_chances == 0 ? sample : (l.echo_ratio * 7 + sample) / 8;
+    if (l.n_chances < 0xFFFF) l.n_chances++;
+    if (echoed && l.n_echoes < 0xFFFF) l.n_echoes++;
+  }
+  s.sent_at = 0;
+  updateAvgQuality();
+}
+
+void LinkEstimator::checkExpired(unsigned long now) {
+  for (int i = 0; i < LINK_TX_HISTORY; i++) {
+    if (_sent[i].sent_at && (long)(now - _sent[i].sent_at) >= LINK_ECHO_WINDOW_MILLIS) finalise(_sent[i]);
+  }
+}
+
+void LinkEstimator::updateAvgQuality() {
+  float total = 0;
+  int n = 0;
+  for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+    float q = getQuality(i);
+    if (q >= 0.0f) { total += q; n++; }
+  }
+  _avg_quality = n > 0 ? total / n : -1.0f;
+}
+
+float LinkEstimator::getQuality(int slot) const {
+  const LinkStats& l = _links[slot];
+  if (!l.active) return -1.0f;
+  if (l.n_chances >= LINK_MIN_CHANCES) return l.echo_ratio / 255.0f;
+  if (l.n_rx > 0) {   // not enough echo samples yet, estimate from SNR margin
+    float q = ((l.rx_snr / 4.0f) - _snr_floor) / 10.0f;
+    return q < 0.0f ? 0.0f : (q > 1.0f ? 1.0f : q);
+  }
+  return -1.0f;
+}
+
+float LinkEstimator::getQualityByHash(uint8_t hash) const {
+  int slot = findSlot(hash);
+  return slot >= 0 ? getQuality(slot) : -1.0f;
+}
+
+uint8_t LinkEstimator::getETX10(int slot) const {
+  const LinkStats& l = _links[slot];
+  if (!l.active || l.n_chances < LINK_MIN_CHANCES) return 0;
+  if (l.echo_ratio < 10) return 255;
+  int etx = 2550 / l.echo_ratio;
+  return etx > 255 ? 255 : etx;
+}
+
+uint8_t LinkEstimator::getFlags(int slot) const {
+  const LinkStats& l = _links[slot];
+  uint8_t flags = 0;
+  if (l.active && l.n_rx >= 8 && (l.rx_snr / 4.0f) >= _snr_floor + 5.0f    // we hear them well...
+      && l.n_chances >= 2*LINK_MIN_CHANCES && l.echo_ratio < 26) {        // ...but < 10% echoes
+    flags |= LINK_FLAG_ASYMMETRIC;
+  }
+  return flags;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Mesh.h>
+
+#if MAX_NEIGHBOURS
+
+#if MAX_NEIGHBOURS > 64
+  #error "LinkEstimator supports max 64 neighbours"
+#endif
+
+#define LINK_TX_HISTORY          16      // our recent flood transmissions, awaiting echoes
+#define LINK_ECHO_WINDOW_MILLIS  20000   // how long after our TX a neighbour's re-forward counts as an echo
+#define LINK_MIN_CHANCES          4      // min echo chances before echo ratio is trusted
+
+#define LINK_FLAG_ASYMMETRIC   0x01    // we hear them well, but they rarely seem to hear us
+
+struct LinkStats {
+  uint8_t hash;           // neighbour's path hash (first byte of pub_key)
+  bool active;
+  int16_t rx_snr;         // x 4, moving average of packets heard directly from neighbour
+  uint16_t n_rx;          // packets heard directly from neighbour (saturates)
+  uint16_t n_chances;     // our flood TXs which neighbour could have re-forwarded (saturates)
+  uint16_t n_echoes;      // ... which neighbour was overheard re-forwarding (saturates)
+  uint8_t echo_ratio;     // moving average of echoes per chance, 0..255
+};
+
+/**
+ * \brief  Passive (ETX style) link estimator, per neighbour slot (ie. parallel to neighbours[]).
+ *         Neighbours are identified by the last hash in a received flood packet's path (ie. who transmitted it).
+ *         Delivery is estimated by overhearing neighbours re-forward our own flood transmissions, which proves a
+ *         round trip (us -> them -> us), so ETX = 1 / echo_ratio.
+ *         NOTE: a neighbour may not re-forward just because it already had the packet from elsewhere, so echo_ratio
+ *         is a lower bound.
+ */
+class LinkEstimator {
+  struct SentFlood {
+    uint32_t fingerprint;
+    uint8_t path_len;
+    unsigned long sent_at;   // 0 = unused
+    uint64_t echoed;         // bit per neighbour slot
+    uint64_t excluded;       // slots which were already in the path (so won't re-forward)
+  };
+
+  LinkStats _links[MAX_NEIGHBOURS];
+  SentFlood _sent[LINK_TX_HISTORY];
+  int _next_sent;
+  float _snr_floor;
+  float _avg_quality;
+
+  int findSlot(uint8_t hash) const;
+  void finalise(SentFlood& s);
+  void updateAvgQuality();
+
+public:
+  LinkEstimator();
+
+  void setSnrFloor(float snr_floor) { _snr_floor = snr_floor; }
+
+  void setNeighbour(int slot, uint8_t hash);
+  void clearNeighbour(int slot);
+
+  void onTxFlood(const mesh::Packet* pkt, unsigned long now);
+  void onRecv(const mesh::Packet* pkt, float snr, unsigned long now);
+
+  /**
+   * \brief  closes out transmissions whose echo window has passed. Call periodically.
+   */
+  void checkExpired(unsigned long now);
+
+  const LinkStats& getStats(int slot) const { return _links[slot]; }
+
+  /**
+   * \returns  0.0 (bad) .. 1.0 (good), or -1 if unknown
+   */
+  float getQuality(int slot) const;
+  float getQualityByHash(uint8_t hash) const;
+  float getAvgQuality() const { return _avg_quality; }
+
+  /**
+   * \returns  ETX x 10 (10 = perfect link, 255 = max), or 0 if unknown
+   */
+  uint8_t getETX10(int slot) const;
+  uint8_t getFlags(int slot) const;
+};
+
+#endif
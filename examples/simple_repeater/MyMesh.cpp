@@ -1,6 +1,10 @@
 #include "MyMesh.h"
 #include <algorithm>
 
+#if MESH_PACKET_CAPTURE
+  #include <helpers/ReplayRadio.h>
+#endif
+
 /* ------------------------------ Config -------------------------------- */
 
 #ifndef LORA_FREQ
@@ -41,7 +45,7 @@
   #define TXT_ACK_DELAY 200
 #endif
 
-#define FIRMWARE_VER_LEVEL       2
+#define FIRMWARE_VER_LEVEL       4
 
 #define REQ_TYPE_GET_STATUS         0x01 // same as _GET_STATS
 #define REQ_TYPE_KEEP_ALIVE         0x02
@@ -49,6 +53,8 @@
 #define REQ_TYPE_GET_ACCESS_LIST    0x05
 #define REQ_TYPE_GET_NEIGHBOURS     0x06
 #define REQ_TYPE_GET_OWNER_INFO     0x07     // FIRMWARE_VER_LEVEL >= 2
+#define REQ_TYPE_GET_LINK_STATS     0x08     // FIRMWARE_VER_LEVEL >= 3
+#define REQ_TYPE_GET_STATS_TLV      0x09     // FIRMWARE_VER_LEVEL >= 4
 
 #define RESP_SERVER_LOGIN_OK        0 // response to ANON_REQ
 
@@ -84,6 +90,7 @@ void MyMesh::putNeighbour(const mesh::Identity &id, uint32_t timestamp, float sn
   neighbour->advert_timestamp = timestamp;
   neighbour->heard_timestamp = getRTCClock()->getCurrentTime();
   neighbour->snr = (int8_t)(snr * 4);
+  links.setNeighbour(neighbour - neighbours, id.pub_key[0]);
 #endif
 }
 
@@ -121,7 +128,7 @@ uint8_t MyMesh::handleLoginReq(const mesh::Identity& sender, const uint8_t* secr
     client->last_activity = getRTCClock()->getCurrentTime();
     client->permissions &= ~0x03;
     client->permissions |= perms;
-    memcpy(client->shared_secret, secret, PUB_KEY_SIZE);
+    acl.setSharedSecret(client, secret);
 
     if (perms != PERM_ACL_GUEST) {   // keep number of FS writes to a minimum
       dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
@@ -192,6 +199,8 @@ uint8_t MyMesh::handleAnonClockReq(const mesh::Identity& sender, uint32_t sender
     reply_data[8] |= 0x01;  // is bridge, type UART
 #elif WITH_ESPNOW_BRIDGE
     reply_data[8] |= 0x03;  // is bridge, type ESP-NOW
+#elif WITH_UDP_BRIDGE
+    reply_data[8] |= 0x05;  // is bridge, type UDP
 #endif
     if (_prefs.disable_fwd) {   // is this repeater currently disabled
       reply_data[8] |= 0x80;  // is disabled
@@ -202,6 +211,53 @@ uint8_t MyMesh::handleAnonClockReq(const mesh::Identity& sender, uint32_t sender
   return 0;
 }
 
+void MyMesh::getStats(RepeaterStats& stats) {
+  stats.batt_milli_volts = board.getBattMilliVolts();
+  stats.curr_tx_queue_len = _mgr->getOutboundCount(0xFFFFFFFF);
+  stats.noise_floor = (int16_t)_radio->getNoiseFloor();
+  stats.last_rssi = (int16_t)radio_driver.getLastRSSI();
+  stats.n_packets_recv = radio_driver.getPacketsRecv();
+  stats.n_packets_sent = radio_driver.getPacketsSent();
+  stats.total_air_time_secs = getTotalAirTime() / 1000;
+  stats.total_up_time_secs = uptime_millis / 1000;
+  stats.n_sent_flood = getNumSentFlood();
+  stats.n_sent_direct = getNumSentDirect();
+  stats.n_recv_flood = getNumRecvFlood();
+  stats.n_recv_direct = getNumRecvDirect();
+  stats.err_events = _err_flags;
+  stats.last_snr = (int16_t)(radio_driver.getLastSNR() * 4);
+  stats.n_direct_dups = ((SimpleMeshTables *)getTables())->getNumDirectDups();
+  stats.n_flood_dups = ((SimpleMeshTables *)getTables())->getNumFloodDups();
+  stats.total_rx_air_time_secs = getReceiveAirTime() / 1000;
+  stats.n_recv_errors = radio_driver.getPacketsRecvErrors();
+}
+
+uint32_t MyMesh::getStatsValues(uint32_t values[]) {
+  RepeaterStats stats;
+  getStats(stats);
+
+  memset(values, 0, STATS_NUM_FIELDS * sizeof(uint32_t));
+  values[STATS_BATTERY_MV] = stats.batt_milli_volts;
+  values[STATS_UPTIME_SECS] = stats.total_up_time_secs;
+  values[STATS_ERRORS] = stats.err_events;
+  values[STATS_QUEUE_LEN] = stats.curr_tx_queue_len;
+  values[STATS_NOISE_FLOOR] = (int32_t) stats.noise_floor;
+  values[STATS_LAST_RSSI] = (int32_t) stats.last_rssi;
+  values[STATS_LAST_SNR] = (int32_t) stats.last_snr;
+  values[STATS_TX_AIR_SECS] = stats.total_air_time_secs;
+  values[STATS_RX_AIR_SECS] = stats.total_rx_air_time_secs;
+  values[STATS_RECV] = stats.n_packets_recv;
+  values[STATS_SENT] = stats.n_packets_sent;
+  values[STATS_FLOOD_TX] = stats.n_sent_flood;
+  values[STATS_DIRECT_TX] = stats.n_sent_direct;
+  values[STATS_FLOOD_RX] = stats.n_recv_flood;
+  values[STATS_DIRECT_RX] = stats.n_recv_direct;
+  values[STATS_RECV_ERRORS] = stats.n_recv_errors;
+  values[STATS_DIRECT_DUPS] = stats.n_direct_dups;
+  values[STATS_FLOOD_DUPS] = stats.n_flood_dups;
+  return STATS_GROUP_CORE | STATS_GROUP_RADIO | STATS_GROUP_PACKETS | STATS_GROUP_DUPS;   // fields present
+}
+
 int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t *payload, size_t payload_len) {
   // uint32_t now = getRTCClock()->getCurrentTimeUnique();
   // memcpy(reply_data, &now, 4);   // response packets always prefixed with timestamp
@@ -209,28 +265,21 @@ int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t
 
   if (payload[0] == REQ_TYPE_GET_STATUS) {  // guests can also access this now
     RepeaterStats stats;
-    stats.batt_milli_volts = board.getBattMilliVolts();
-    stats.curr_tx_queue_len = _mgr->getOutboundCount(0xFFFFFFFF);
-    stats.noise_floor = (int16_t)_radio->getNoiseFloor();
-    stats.last_rssi = (int16_t)radio_driver.getLastRSSI();
-    stats.n_packets_recv = radio_driver.getPacketsRecv();
-    stats.n_packets_sent = radio_driver.getPacketsSent();
-    stats.total_air_time_secs = getTotalAirTime() / 1000;
-    stats.total_up_time_secs = uptime_millis / 1000;
-    stats.n_sent_flood = getNumSentFlood();
-    stats.n_sent_direct = getNumSentDirect();
-    stats.n_recv_flood = getNumRecvFlood();
-    stats.n_recv_direct = getNumRecvDirect();
-    stats.err_events = _err_flags;
-    stats.last_snr = (int16_t)(radio_driver.getLastSNR() * 4);
-    stats.n_direct_dups = ((SimpleMeshTables *)getTables())->getNumDirectDups();
-    stats.n_flood_dups = ((SimpleMeshTables *)getTables())->getNumFloodDups();
-    stats.total_rx_air_time_secs = getReceiveAirTime() / 1000;
-    stats.n_recv_errors = radio_driver.getPacketsRecvErrors();
+    getStats(stats);
     memcpy(&reply_data[4], &stats, sizeof(stats));
 
     return 4 + sizeof(stats); //  reply_len
   }
+  if (payload[0] == REQ_TYPE_GET_STATS_TLV && payload_len >= 7 && payload[1] == 0) {  // version 0, guests can also access
+    uint32_t field_mask;
+    memcpy(&field_mask, &payload[2], 4);   // 0 = all fields
+    uint8_t base_id = payload[6];          // 0 = full values, else delta against this earlier response
+
+    uint32_t values[STATS_NUM_FIELDS];
+    uint32_t present = getStatsValues(values);
+    return 4 + stats_tlv.encode(values, present, field_mask, base_id, sender->id.pub_key,
+                                 &reply_data[4], sizeof(reply_data) - 4);
+  }
   if (payload[0] == REQ_TYPE_GET_TELEMETRY_DATA) {
     uint8_t perm_mask = ~(payload[1]); // NEW: first reserved byte (of 4), is now inverse mask to apply to permissions
 
@@ -357,6 +406,48 @@ int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t
       memcpy(&reply_data[reply_offset], &results_count, 2); reply_offset += 2;
       memcpy(&reply_data[reply_offset], &results_buffer, results_offset); reply_offset += results_offset;
 
+      return reply_offset;
+    }
+  } else if (payload[0] == REQ_TYPE_GET_LINK_STATS) {
+    uint8_t request_version = payload[1];
+    if (request_version == 0) {
+      int reply_offset = 4;
+
+      uint8_t count = payload[2];
+      uint16_t offset;
+      memcpy(&offset, &payload[3], 2);
+      uint8_t pubkey_prefix_length = payload[5];
+      if (pubkey_prefix_length > PUB_KEY_SIZE) pubkey_prefix_length = PUB_KEY_SIZE;
+
+      int16_t links_count = 0;
+      int16_t results_count = 0;
+      int results_offset = 0;
+      uint8_t results_buffer[130];
+#if MAX_NEIGHBOURS
+      for (int i = 0; i < MAX_NEIGHBOURS; i++) {
+        if (neighbours[i].heard_timestamp == 0) continue;
+
+        int idx = links_count++;
+        if (idx < offset || results_count >= count) continue;
+
+        int entry_size = pubkey_prefix_length + 4;
+        if (results_offset + entry_size > sizeof(results_buffer)) continue;   // keep counting total
+
+        const LinkStats& l = links.getStats(i);
+        memcpy(&results_buffer[results_offset], neighbours[i].id.pub_key, pubkey_prefix_length); results_offset += pubkey_prefix_length;
+        int16_t snr = l.rx_snr < -128 ? -128 : (l.rx_snr > 127 ? 127 : l.rx_snr);
+        results_buffer[results_offset++] = (uint8_t)(int8_t)snr;    // x 4
+        results_buffer[results_offset++] = l.echo_ratio;            // 0..255
+        results_buffer[results_offset++] = links.getETX10(i);       // 0 = unknown
+        results_buffer[results_offset++] = links.getFlags(i);
+        results_count++;
+      }
+#endif
+      MESH_DEBUG_PRINTLN("REQ_TYPE_GET_LINK_STATS links_count=%d results_count=%d", links_count, results_count);
+      memcpy(&reply_data[reply_offset], &links_count, 2); reply_offset += 2;
+      memcpy(&reply_data[reply_offset], &results_count, 2); reply_offset += 2;
+      memcpy(&reply_data[reply_offset], results_buffer, results_offset); reply_offset += results_offset;
+
       return reply_offset;
     }
   } else if (payload[0] == REQ_TYPE_GET_OWNER_INFO) {
@@ -409,6 +500,9 @@ void MyMesh::logRxRaw(float snr, float rssi, const uint8_t raw[], int len) {
   mesh::Utils::printHex(Serial, raw, len);
   Serial.println();
 #endif
+#if MESH_PACKET_CAPTURE
+  ReplayRadio::writeCaptureLine(Serial, millis(), snr, rssi, raw, len);   // for replaying with ReplayRadio
+#endif
 }
 
 void MyMesh::logRx(mesh::Packet *pkt, int len, float score) {
@@ -417,6 +511,9 @@ void MyMesh::logRx(mesh::Packet *pkt, int len, float score) {
     bridge.sendPacket(pkt);
   }
 #endif
+#if MAX_NEIGHBOURS
+  links.onRecv(pkt, pkt->getSNR(), _ms->getMillis());
+#endif
 
   if (_logging) {
     File f = openAppend(PACKET_LOG_FILE);
@@ -443,6 +540,11 @@ void MyMesh::logTx(mesh::Packet *pkt, int len) {
     bridge.sendPacket(pkt);
   }
 #endif
+#if MAX_NEIGHBOURS
+  if (pkt->isRouteFlood()) {
+    links.onTxFlood(pkt, _ms->getMillis());
+  }
+#endif
 
   if (_logging) {
     File f = openAppend(PACKET_LOG_FILE);
@@ -476,15 +578,26 @@ void MyMesh::logTxFail(mesh::Packet *pkt, int len) {
 
 int MyMesh::calcRxDelay(float score, uint32_t air_time) const {
   if (_prefs.rx_delay_base <= 0.0f) return 0;
-  return (int)((pow(_prefs.rx_delay_base, 0.85f - score) - 1.0) * air_time);
+  return rx_delays.calcRxDelay(_prefs.rx_delay_base, score, air_time);
 }
 
 uint32_t MyMesh::getRetransmitDelay(const mesh::Packet *packet) {
   uint32_t t = (_radio->getEstAirtimeFor(packet->path_len + packet->payload_len + 2) * _prefs.tx_delay_factor);
+#if MAX_NEIGHBOURS
+  // if our links are poor, back off more (others are probably better placed to forward), else less
+  float q = links.getAvgQuality();
+  if (q >= 0.0f) t = (uint32_t) (t * (1.5f - q));
+#endif
   return getRNG()->nextInt(0, 5*t + 1);
 }
 uint32_t MyMesh::getDirectRetransmitDelay(const mesh::Packet *packet) {
   uint32_t t = (_radio->getEstAirtimeFor(packet->path_len + packet->payload_len + 2) * _prefs.direct_tx_delay_factor);
+#if MAX_NEIGHBOURS
+  if (packet->path_len > 0) {   // path[0] is now the next hop
+    float q = links.getQualityByHash(packet->path[0]);
+    if (q >= 0.0f) t = (uint32_t) (t * (1.5f - q));
+  }
+#endif
   return getRNG()->nextInt(0, 5*t + 1);
 }
 
@@ -546,20 +659,14 @@ void MyMesh::onAnonDataRecv(mesh::Packet *packet, const uint8_t *secret, const m
 }
 
 int MyMesh::searchPeersByHash(const uint8_t *hash) {
-  int n = 0;
-  for (int i = 0; i < acl.getNumClients(); i++) {
-    if (acl.getClientByIdx(i)->id.isHashMatch(hash)) {
-      matching_peer_indexes[n++] = i; // store the INDEXES of matching contacts (for subsequent 'peer' methods)
-    }
-  }
-  return n;
+  // store the INDEXES of matching contacts (for subsequent 'peer' methods)
+  return acl.searchByHash(hash, matching_peer_indexes, MAX_CLIENTS);
 }
 
 void MyMesh::getPeerSharedSecret(uint8_t *dest_secret, int peer_idx) {
   int i = matching_peer_indexes[peer_idx];
   if (i >= 0 && i < acl.getNumClients()) {
-    // lookup pre-calculated shared_secret
-    memcpy(dest_secret, acl.getClientByIdx(i)->shared_secret, PUB_KEY_SIZE);
+    memcpy(dest_secret, acl.getSharedSecret(acl.getClientByIdx(i)), PUB_KEY_SIZE);   // (calculated on first use)
   } else {
     MESH_DEBUG_PRINTLN("getPeerSharedSecret: Invalid peer idx: %d", i);
   }
@@ -750,7 +857,7 @@ MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondCloc
 #if defined(WITH_RS232_BRIDGE)
       , bridge(&_prefs, WITH_RS232_BRIDGE, _mgr, &rtc)
 #endif
-#if defined(WITH_ESPNOW_BRIDGE)
+#if defined(WITH_ESPNOW_BRIDGE) || defined(WITH_UDP_BRIDGE)
       , bridge(&_prefs, _mgr, &rtc)
 #endif
 {
@@ -819,6 +926,10 @@ void MyMesh::begin(FILESYSTEM *fs) {
 #endif
 
   radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+  _radio->onParamsChanged();
+#if MAX_NEIGHBOURS
+  links.setSnrFloor(-7.5f - 2.5f * (_prefs.sf - 7));   // approx. demodulation floor
+#endif
   radio_set_tx_power(_prefs.tx_power_dbm);
 
   updateAdvertTimer();
@@ -947,12 +1058,40 @@ void MyMesh::formatNeighborsReply(char *reply) {
   *dp = 0; // null terminator
 }
 
+void MyMesh::formatLinksReply(char *reply) {
+  char *dp = reply;
+
+#if MAX_NEIGHBOURS
+  for (int i = 0; i < MAX_NEIGHBOURS && dp - reply < 134; i++) {
+    if (neighbours[i].heard_timestamp == 0) continue;
+
+    const LinkStats& l = links.getStats(i);
+    if (dp > reply) *dp++ = '\n';
+
+    char hex[10];
+    mesh::Utils::toHex(hex, neighbours[i].id.pub_key, 4);
+
+    // echo % is only meaningful once etx is non-zero
+    sprintf(dp, "%s:%d:%d:%d%s", hex, (int)l.rx_snr, (l.echo_ratio * 100) / 255, links.getETX10(i),
+            (links.getFlags(i) & LINK_FLAG_ASYMMETRIC) ? ":A" : "");
+    while (*dp)
+      dp++; // find end of string
+  }
+#endif
+  if (dp == reply) { // no neighbours, need empty response
+    strcpy(dp, "-none-");
+    dp += 6;
+  }
+  *dp = 0; // null terminator
+}
+
 void MyMesh::removeNeighbor(const uint8_t *pubkey, int key_len) {
 #if MAX_NEIGHBOURS
   for (int i = 0; i < MAX_NEIGHBOURS; i++) {
     NeighbourInfo *neighbour = &neighbours[i];
     if (memcmp(neighbour->id.pub_key, pubkey, key_len) == 0) {
       neighbours[i] = NeighbourInfo(); // clear neighbour entry
+      links.clearNeighbour(i);
     }
   }
 #endif
@@ -1067,6 +1206,8 @@ void MyMesh::handleCommand(uint32_t sender_timestamp, char *command, char *reply
       Serial.printf("\n");
     }
     reply[0] = 0;
+  } else if (strcmp(command, "neighbors.links") == 0) {
+    formatLinksReply(reply);
   } else if (memcmp(command, "region", 6) == 0) {
     reply[0] = 0;
 
@@ -1180,6 +1321,10 @@ void MyMesh::loop() {
 
   mesh::Mesh::loop();
 
+#if MAX_NEIGHBOURS
+  links.checkExpired(_ms->getMillis());
+#endif
+
   if (next_flood_advert && millisHasNowPassed(next_flood_advert)) {
     mesh::Packet *pkt = createSelfAdvert();
     if (pkt) sendFlood(pkt);
@@ -1196,12 +1341,14 @@ void MyMesh::loop() {
   if (set_radio_at && millisHasNowPassed(set_radio_at)) { // apply pending (temporary) radio params
     set_radio_at = 0;                                     // clear timer
     radio_set_params(pending_freq, pending_bw, pending_sf, pending_cr);
+    _radio->onParamsChanged();
     MESH_DEBUG_PRINTLN("Temp radio params");
   }
 
   if (revert_radio_at && millisHasNowPassed(revert_radio_at)) { // revert radio params to orig
     revert_radio_at = 0;                                        // clear timer
     radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+    _radio->onParamsChanged();
     MESH_DEBUG_PRINTLN("Radio params restored");
   }
 
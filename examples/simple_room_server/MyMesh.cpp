@@ -10,12 +10,23 @@
 
 #define POST_SYNC_DELAY_SECS        6
 
-#define FIRMWARE_VER_LEVEL       1
+#ifndef PUSH_WINDOW_SIZE
+  #define PUSH_WINDOW_SIZE          4      // max clients with an outstanding (un-ACKed) push
+#endif
+#ifndef PUSH_AIRTIME_PERCENT
+  #define PUSH_AIRTIME_PERCENT      30     // max share of airtime to spend on pushes
+#endif
+#define PUSH_AIRTIME_BURST_MILLIS   8000
+#define PUSH_MAX_QUEUED             2      // don't push while outbound queue is backed up
+#define PUSH_MAX_WAIT_BONUS         30000
+
+#define FIRMWARE_VER_LEVEL       2
 
 #define REQ_TYPE_GET_STATUS         0x01 // same as _GET_STATS
 #define REQ_TYPE_KEEP_ALIVE         0x02
 #define REQ_TYPE_GET_TELEMETRY_DATA 0x03
 #define REQ_TYPE_GET_ACCESS_LIST    0x05
+#define REQ_TYPE_GET_STATS_TLV      0x09     // FIRMWARE_VER_LEVEL >= 2
 
 #define RESP_SERVER_LOGIN_OK        0 // response to ANON_REQ
 
@@ -40,11 +51,7 @@ struct ServerStats {
 
 void MyMesh::addPost(ClientInfo *client, const char *postData) {
   // TODO: suggested postData format: <title>/<descrption>
-  posts[next_post_idx].author = client->id; // add to cyclic queue
-  StrHelper::strncpy(posts[next_post_idx].text, postData, MAX_POST_TEXT_LEN);
-
-  posts[next_post_idx].post_timestamp = getRTCClock()->getCurrentTimeUnique();
-  next_post_idx = (next_post_idx + 1) % MAX_UNSYNCED_POSTS;
+  posts.addPost(client->id, getRTCClock()->getCurrentTimeUnique(), postData);   // append to post log
 
   next_push = futureMillis(PUSH_NOTIFY_DELAY_MILLIS);
   _num_posted++; // stats
@@ -71,7 +78,7 @@ void MyMesh::pushPostToClient(ClientInfo *client, PostInfo &post) {
   mesh::Utils::sha256((uint8_t *)&client->extra.room.pending_ack, 4, reply_data, len, client->id.pub_key, PUB_KEY_SIZE);
   client->extra.room.push_post_timestamp = post.post_timestamp;
 
-  auto reply = createDatagram(PAYLOAD_TYPE_TXT_MSG, client->id, client->shared_secret, reply_data, len);
+  auto reply = createDatagram(PAYLOAD_TYPE_TXT_MSG, client->id, acl.getSharedSecret(client), reply_data, len);
   if (reply) {
     if (client->out_path_len < 0) {
       sendFlood(reply);
@@ -81,6 +88,7 @@ void MyMesh::pushPostToClient(ClientInfo *client, PostInfo &post) {
       client->extra.room.ack_timeout =
           futureMillis(PUSH_TIMEOUT_BASE + PUSH_ACK_TIMEOUT_FACTOR * (client->out_path_len + 1));
     }
+    client->extra.room.push_sent_at = _ms->getMillis();
     _num_post_pushes++; // stats
   } else {
     client->extra.room.pending_ack = 0;
@@ -89,14 +97,7 @@ void MyMesh::pushPostToClient(ClientInfo *client, PostInfo &post) {
 }
 
 uint8_t MyMesh::getUnsyncedCount(ClientInfo *client) {
-  uint8_t count = 0;
-  for (int k = 0; k < MAX_UNSYNCED_POSTS; k++) {
-    if (posts[k].post_timestamp > client->extra.room.sync_since // is new post for this Client?
-        && !posts[k].author.matches(client->id)) {   // don't push posts to the author
-      count++;
-    }
-  }
-  return count;
+  return posts.countUnsyncedFor(client->id, client->extra.room.sync_since, 0xFF);
 }
 
 bool MyMesh::processAck(const uint8_t *data) {
@@ -106,12 +107,91 @@ bool MyMesh::processAck(const uint8_t *data) {
       client->extra.room.pending_ack = 0; // clear this, so next push can happen
       client->extra.room.push_failures = 0;
       client->extra.room.sync_since = client->extra.room.push_post_timestamp; // advance Client's SINCE timestamp, to sync next post
+
+      unsigned long rtt = _ms->getMillis() - client->extra.room.push_sent_at;
+      if (client->out_path_len >= 0) {
+        client_paths.onSuccess(client->id.pub_key, client->out_path, client->out_path_len, rtt, _ms->getMillis());
+      }
+      if (rtt > 0xFFFF) rtt = 0xFFFF;
+      if (client->extra.room.ack_latency == 0) {
+        client->extra.room.ack_latency = rtt;
+      } else {
+        client->extra.room.ack_latency = (client->extra.room.ack_latency * 3 + rtt) / 4;  // smoothed
+      }
+      return true;
+    }
+  }
+  // check for LATE acks, of pushes which have already timed out
+  for (int i = 0; i < PREV_ACK_TABLE_SIZE; i++) {
+    auto prev = &prev_acks[i];
+    if (prev->ack && memcmp(data, &prev->ack, 4) == 0) {
+      prev->ack = 0;
+      auto client = acl.getClient(prev->client_prefix, sizeof(prev->client_prefix));
+      if (client && prev->post_timestamp > client->extra.room.sync_since) {
+        client->extra.room.sync_since = prev->post_timestamp;   // client DID get that post
+        if (client->extra.room.pending_ack && client->extra.room.push_post_timestamp <= prev->post_timestamp) {
+          client->extra.room.pending_ack = 0;   // retry of same post is now redundant, so move on
+        }
+        client->extra.room.push_failures = 0;
+      }
       return true;
     }
   }
   return false;
 }
 
+uint32_t MyMesh::estPushRoundTrip(const ClientInfo* client) const {
+  if (client->extra.room.ack_latency) return client->extra.room.ack_latency;   // measured
+  if (client->out_path_len < 0) return PUSH_ACK_TIMEOUT_FLOOD / 2;
+  return (PUSH_TIMEOUT_BASE + PUSH_ACK_TIMEOUT_FACTOR * (client->out_path_len + 1)) / 2;
+}
+
+uint32_t MyMesh::estPushAirtime(const ClientInfo* client, const PostInfo& post) {
+  int data_len = 4 + 1 + 4 + strlen(post.text);
+  int pkt_len = 2 + 2 + CIPHER_MAC_SIZE + ((data_len + CIPHER_BLOCK_SIZE - 1) / CIPHER_BLOCK_SIZE) * CIPHER_BLOCK_SIZE;
+  if (client->out_path_len < 0) {
+    return _radio->getEstAirtimeFor(pkt_len) * 4;    // flood, so assume several repeaters will retransmit
+  }
+  return _radio->getEstAirtimeFor(pkt_len + client->out_path_len) * (client->out_path_len + 1);   // once per hop
+}
+
+void MyMesh::updatePushCredit() {
+  unsigned long now = _ms->getMillis();
+  unsigned long elapsed = now - last_credit_update;
+  if (elapsed > PUSH_AIRTIME_BURST_MILLIS * 100 / PUSH_AIRTIME_PERCENT) {   // enough to fill bucket (and no overflow below)
+    elapsed = PUSH_AIRTIME_BURST_MILLIS * 100 / PUSH_AIRTIME_PERCENT;
+  }
+  push_airtime_credit += elapsed * PUSH_AIRTIME_PERCENT / 100;
+  if (push_airtime_credit > PUSH_AIRTIME_BURST_MILLIS) push_airtime_credit = PUSH_AIRTIME_BURST_MILLIS;
+  last_credit_update = now;
+}
+
+ClientInfo* MyMesh::selectNextPushClient(PostInfo& post) {
+  uint32_t rtc_now = getRTCClock()->getCurrentTime();
+  if (rtc_now <= POST_SYNC_DELAY_SECS) return NULL;   // clock not sane yet
+  uint32_t until = rtc_now - POST_SYNC_DELAY_SECS;
+  unsigned long now = _ms->getMillis();
+  ClientInfo* best = NULL;
+  long best_score = 0;
+  PostInfo p;
+  for (int i = 0; i < acl.getNumClients(); i++) {
+    auto c = acl.getClientByIdx(i);
+    if (c->extra.room.pending_ack || c->last_activity == 0 || c->extra.room.push_failures >= 3) continue;   // busy, evicted, or retries maxed
+
+    // favour clients with quickest turnaround (short paths, fast ACKs), but age those left waiting
+    unsigned long waited = now - c->extra.room.push_sent_at;
+    long score = (long) estPushRoundTrip(c) - (long) (waited < PUSH_MAX_WAIT_BONUS ? waited : PUSH_MAX_WAIT_BONUS);
+    if (best && score >= best_score) continue;
+
+    if (posts.findNextFor(c->id, c->extra.room.sync_since, until, p)) {   // has a new post ready for this Client?
+      best = c;
+      best_score = score;
+      post = p;
+    }
+  }
+  return best;
+}
+
 mesh::Packet *MyMesh::createSelfAdvert() {
   uint8_t app_data[MAX_ADVERT_DATA_SIZE];
   uint8_t app_data_len = _cli.buildAdvertData(ADV_TYPE_ROOM, app_data);
@@ -129,6 +209,31 @@ File MyMesh::openAppend(const char *fname) {
 #endif
 }
 
+uint32_t MyMesh::getStatsValues(uint32_t values[]) {
+  memset(values, 0, STATS_NUM_FIELDS * sizeof(uint32_t));
+  values[STATS_BATTERY_MV] = board.getBattMilliVolts();
+  values[STATS_UPTIME_SECS] = uptime_millis / 1000;
+  values[STATS_ERRORS] = _err_flags;
+  values[STATS_QUEUE_LEN] = _mgr->getOutboundCount(0xFFFFFFFF);
+  values[STATS_NOISE_FLOOR] = (int32_t) _radio->getNoiseFloor();
+  values[STATS_LAST_RSSI] = (int32_t) radio_driver.getLastRSSI();
+  values[STATS_LAST_SNR] = (int32_t) (radio_driver.getLastSNR() * 4);
+  values[STATS_TX_AIR_SECS] = getTotalAirTime() / 1000;
+  values[STATS_RX_AIR_SECS] = getReceiveAirTime() / 1000;
+  values[STATS_RECV] = radio_driver.getPacketsRecv();
+  values[STATS_SENT] = radio_driver.getPacketsSent();
+  values[STATS_FLOOD_TX] = getNumSentFlood();
+  values[STATS_DIRECT_TX] = getNumSentDirect();
+  values[STATS_FLOOD_RX] = getNumRecvFlood();
+  values[STATS_DIRECT_RX] = getNumRecvDirect();
+  values[STATS_RECV_ERRORS] = radio_driver.getPacketsRecvErrors();
+  values[STATS_DIRECT_DUPS] = ((SimpleMeshTables *)getTables())->getNumDirectDups();
+  values[STATS_FLOOD_DUPS] = ((SimpleMeshTables *)getTables())->getNumFloodDups();
+  values[STATS_POSTED] = _num_posted;
+  values[STATS_POST_PUSHES] = _num_post_pushes;
+  return STATS_GROUP_CORE | STATS_GROUP_RADIO | STATS_GROUP_PACKETS | STATS_GROUP_DUPS | STATS_GROUP_ROOM;   // fields present
+}
+
 int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t *payload,
                           size_t payload_len) {
   // uint32_t now = getRTCClock()->getCurrentTimeUnique();
@@ -159,6 +264,16 @@ int MyMesh::handleRequest(ClientInfo *sender, uint32_t sender_timestamp, uint8_t
     memcpy(&reply_data[4], &stats, sizeof(stats));
     return 4 + sizeof(stats);
   }
+  if (payload[0] == REQ_TYPE_GET_STATS_TLV && payload_len >= 7 && payload[1] == 0) {  // version 0
+    uint32_t field_mask;
+    memcpy(&field_mask, &payload[2], 4);   // 0 = all fields
+    uint8_t base_id = payload[6];          // 0 = full values, else delta against this earlier response
+
+    uint32_t values[STATS_NUM_FIELDS];
+    uint32_t present = getStatsValues(values);
+    return 4 + stats_tlv.encode(values, present, field_mask, base_id, sender->id.pub_key,
+                                 &reply_data[4], sizeof(reply_data) - 4);
+  }
   if (payload[0] == REQ_TYPE_GET_TELEMETRY_DATA) {
     uint8_t perm_mask = ~(payload[1]); // NEW: first reserved byte (of 4), is now inverse mask to apply to permissions
 
@@ -251,7 +366,7 @@ void MyMesh::logTxFail(mesh::Packet *pkt, int len) {
 
 int MyMesh::calcRxDelay(float score, uint32_t air_time) const {
   if (_prefs.rx_delay_base <= 0.0f) return 0;
-  return (int)((pow(_prefs.rx_delay_base, 0.85f - score) - 1.0) * air_time);
+  return rx_delays.calcRxDelay(_prefs.rx_delay_base, score, air_time);
 }
 
 const char *MyMesh::getLogDateTime() {
@@ -327,13 +442,14 @@ void MyMesh::onAnonDataRecv(mesh::Packet *packet, const uint8_t *secret, const m
       client->last_activity = getRTCClock()->getCurrentTime();
       client->permissions &= ~0x03;
       client->permissions |= perm;
-      memcpy(client->shared_secret, secret, PUB_KEY_SIZE);
+      acl.setSharedSecret(client, secret);
 
       dirty_contacts_expiry = futureMillis(LAZY_CONTACTS_WRITE_DELAY);
     }
 
     if (packet->isRouteFlood()) {
       client->out_path_len = -1;  // need to rediscover out_path
+      client_paths.forget(client->id.pub_key);
     }
 
     uint32_t now = getRTCClock()->getCurrentTimeUnique();
@@ -351,11 +467,11 @@ void MyMesh::onAnonDataRecv(mesh::Packet *packet, const uint8_t *secret, const m
 
     if (packet->isRouteFlood()) {
       // let this sender know path TO here, so they can use sendDirect(), and ALSO encode the response
-      mesh::Packet *path = createPathReturn(sender, client->shared_secret, packet->path, packet->path_len,
+      mesh::Packet *path = createPathReturn(sender, acl.getSharedSecret(client), packet->path, packet->path_len,
                                             PAYLOAD_TYPE_RESPONSE, reply_data, 13);
       if (path) sendFlood(path, SERVER_RESPONSE_DELAY);
     } else {
-      mesh::Packet *reply = createDatagram(PAYLOAD_TYPE_RESPONSE, sender, client->shared_secret, reply_data, 13);
+      mesh::Packet *reply = createDatagram(PAYLOAD_TYPE_RESPONSE, sender, acl.getSharedSecret(client), reply_data, 13);
       if (reply) {
         if (client->out_path_len >= 0) { // we have an out_path, so send DIRECT
           sendDirect(reply, client->out_path, client->out_path_len, SERVER_RESPONSE_DELAY);
@@ -368,20 +484,14 @@ void MyMesh::onAnonDataRecv(mesh::Packet *packet, const uint8_t *secret, const m
 }
 
 int MyMesh::searchPeersByHash(const uint8_t *hash) {
-  int n = 0;
-  for (int i = 0; i < acl.getNumClients(); i++) {
-    if (acl.getClientByIdx(i)->id.isHashMatch(hash)) {
-      matching_peer_indexes[n++] = i; // store the INDEXES of matching contacts (for subsequent 'peer' methods)
-    }
-  }
-  return n;
+  // store the INDEXES of matching contacts (for subsequent 'peer' methods)
+  return acl.searchByHash(hash, matching_peer_indexes, MAX_CLIENTS);
 }
 
 void MyMesh::getPeerSharedSecret(uint8_t *dest_secret, int peer_idx) {
   int i = matching_peer_indexes[peer_idx];
   if (i >= 0 && i < acl.getNumClients()) {
-    // lookup pre-calculated shared_secret
-    memcpy(dest_secret, acl.getClientByIdx(i)->shared_secret, PUB_KEY_SIZE);
+    memcpy(dest_secret, acl.getSharedSecret(acl.getClientByIdx(i)), PUB_KEY_SIZE);   // (calculated on first use)
   } else {
     MESH_DEBUG_PRINTLN("getPeerSharedSecret: Invalid peer idx: %d", i);
   }
@@ -563,7 +673,12 @@ bool MyMesh::onPeerPathRecv(mesh::Packet *packet, int sender_idx, const uint8_t
   if (i >= 0 && i < acl.getNumClients()) { // get from our known_clients table (sender SHOULD already be known in this context)
     MESH_DEBUG_PRINTLN("PATH to client, path_len=%d", (uint32_t)path_len);
     auto client = acl.getClientByIdx(i);
-    memcpy(client->out_path, path, client->out_path_len = path_len); // store a copy of path, for sendDirect()
+    unsigned long now = _ms->getMillis();
+    client_paths.addPath(client->id.pub_key, path, path_len, now);
+    client->out_path_len = client_paths.selectBest(client->id.pub_key, client->out_path, now);  // store a copy of best path, for sendDirect()
+    if (client->out_path_len < 0) {
+      memcpy(client->out_path, path, client->out_path_len = path_len);
+    }
     client->last_activity = getRTCClock()->getCurrentTime();
   } else {
     MESH_DEBUG_PRINTLN("onPeerPathRecv: invalid peer idx: %d", i);
@@ -624,10 +739,11 @@ MyMesh::MyMesh(mesh::MainBoard &board, mesh::Radio &radio, mesh::MillisecondCloc
   _prefs.gps_interval = 0;
   _prefs.advert_loc_policy = ADVERT_LOC_PREFS;
 
-  next_post_idx = 0;
-  next_client_idx = 0;
   next_push = 0;
-  memset(posts, 0, sizeof(posts));
+  memset(prev_acks, 0, sizeof(prev_acks));
+  next_prev_ack_idx = 0;
+  push_airtime_credit = PUSH_AIRTIME_BURST_MILLIS;
+  last_credit_update = 0;
   _num_posted = _num_post_pushes = 0;
 }
 
@@ -638,8 +754,10 @@ void MyMesh::begin(FILESYSTEM *fs) {
   _cli.loadPrefs(_fs);
 
   acl.load(_fs, self_id);
+  posts.begin(_fs);
 
   radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+  _radio->onParamsChanged();
   radio_set_tx_power(_prefs.tx_power_dbm);
 
   updateAdvertTimer();
@@ -813,43 +931,53 @@ void MyMesh::loop() {
 
   if (millisHasNowPassed(next_push) && acl.getNumClients() > 0) {
     // check for ACK timeouts
+    int num_pending = 0;
     for (int i = 0; i < acl.getNumClients(); i++) {
       auto c = acl.getClientByIdx(i);
       if (c->extra.room.pending_ack && millisHasNowPassed(c->extra.room.ack_timeout)) {
         c->extra.room.push_failures++;
-        c->extra.room.pending_ack = 0; // reset  (TODO: keep prev expected_ack's in a list, incase they arrive LATER, after we retry)
+        if (c->out_path_len >= 0) {   // try next best path (if any) for the retry
+          uint8_t path[MAX_PATH_SIZE];
+          int path_len = client_paths.onFailure(c->id.pub_key, c->out_path, c->out_path_len, path, _ms->getMillis());
+          if (path_len >= 0) memcpy(c->out_path, path, c->out_path_len = path_len);
+        }
+
+        auto prev = &prev_acks[next_prev_ack_idx];   // keep expected ACK, incase it arrives LATER, after we retry
+        prev->ack = c->extra.room.pending_ack;
+        prev->post_timestamp = c->extra.room.push_post_timestamp;
+        memcpy(prev->client_prefix, c->id.pub_key, sizeof(prev->client_prefix));
+        next_prev_ack_idx = (next_prev_ack_idx + 1) % PREV_ACK_TABLE_SIZE;
+
+        c->extra.room.pending_ack = 0; // reset
         MESH_DEBUG_PRINTLN("pending ACK timed out: push_failures: %d", (uint32_t)c->extra.room.push_failures);
+      } else if (c->extra.room.pending_ack) {
+        num_pending++;
       }
     }
-    // check next Round-Robin client, and sync next new post
-    auto client = acl.getClientByIdx(next_client_idx);
+    updatePushCredit();
+
+    // keep a window of pushes outstanding, to several clients at once
     bool did_push = false;
-    if (client->extra.room.pending_ack == 0 && client->last_activity != 0 &&
-        client->extra.room.push_failures < 3) { // not already waiting for ACK, AND not evicted, AND retries not max
-      MESH_DEBUG_PRINTLN("loop - checking for client %02X", (uint32_t)client->id.pub_key[0]);
-      uint32_t now = getRTCClock()->getCurrentTime();
-      for (int k = 0, idx = next_post_idx; k < MAX_UNSYNCED_POSTS; k++) {
-        auto p = &posts[idx];
-        if (now >= p->post_timestamp + POST_SYNC_DELAY_SECS &&
-            p->post_timestamp > client->extra.room.sync_since // is new post for this Client?
-            && !p->author.matches(client->id)) {   // don't push posts to the author
+    if (num_pending < PUSH_WINDOW_SIZE && _mgr->getOutboundCount(0xFFFFFFFF) < PUSH_MAX_QUEUED) {
+      PostInfo p;
+      auto client = selectNextPushClient(p);
+      if (client) {
+        uint32_t airtime = estPushAirtime(client, p);
+        if (airtime <= push_airtime_credit || push_airtime_credit >= PUSH_AIRTIME_BURST_MILLIS) {   // within airtime budget?
+          push_airtime_credit = airtime < push_airtime_credit ? push_airtime_credit - airtime : 0;
+
           // push this post to Client, then wait for ACK
-          pushPostToClient(client, *p);
+          pushPostToClient(client, p);
           did_push = true;
-          MESH_DEBUG_PRINTLN("loop - pushed to client %02X: %s", (uint32_t)client->id.pub_key[0], p->text);
-          break;
+          MESH_DEBUG_PRINTLN("loop - pushed to client %02X: %s", (uint32_t)client->id.pub_key[0], p.text);
         }
-        idx = (idx + 1) % MAX_UNSYNCED_POSTS; // wrap to start of cyclic queue
       }
-    } else {
-      MESH_DEBUG_PRINTLN("loop - skipping busy (or evicted) client %02X", (uint32_t)client->id.pub_key[0]);
     }
-    next_client_idx = (next_client_idx + 1) % acl.getNumClients(); // round robin polling for each client
 
     if (did_push) {
-      next_push = futureMillis(SYNC_PUSH_INTERVAL);
+      next_push = futureMillis(SYNC_PUSH_INTERVAL / PUSH_WINDOW_SIZE);
     } else {
-      // were no unsynced posts for curr client, so proccess next client much quicker! (in next loop())
+      // nothing (yet) to push, so check again much quicker! (in next loop())
       next_push = futureMillis(SYNC_PUSH_INTERVAL / 8);
     }
   }
@@ -870,12 +998,14 @@ void MyMesh::loop() {
   if (set_radio_at && millisHasNowPassed(set_radio_at)) { // apply pending (temporary) radio params
     set_radio_at = 0;                                     // clear timer
     radio_set_params(pending_freq, pending_bw, pending_sf, pending_cr);
+    _radio->onParamsChanged();
     MESH_DEBUG_PRINTLN("Temp radio params");
   }
 
   if (revert_radio_at && millisHasNowPassed(revert_radio_at)) { // revert radio params to orig
     revert_radio_at = 0;                                        // clear timer
     radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+    _radio->onParamsChanged();
     MESH_DEBUG_PRINTLN("Radio params restored");
   }
 
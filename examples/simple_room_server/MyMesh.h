@@ -19,7 +19,11 @@
 #include <helpers/TxtDataHelpers.h>
 #include <helpers/CommonCLI.h>
 #include <helpers/StatsFormatHelper.h>
+#include <helpers/StatsTLV.h>
 #include <helpers/ClientACL.h>
+#include <helpers/RxDelayTable.h>
+#include <helpers/PathStore.h>
+#include "PostStore.h"
 #include <RTClib.h>
 #include <target.h>
 
@@ -63,10 +67,6 @@
   #define  ADMIN_PASSWORD  "password"
 #endif
 
-#ifndef MAX_UNSYNCED_POSTS
-  #define MAX_UNSYNCED_POSTS    32
-#endif
-
 #ifndef SERVER_RESPONSE_DELAY
   #define SERVER_RESPONSE_DELAY   300
 #endif
@@ -79,14 +79,6 @@
 
 #define PACKET_LOG_FILE  "/packet_log"
 
-#define MAX_POST_TEXT_LEN    (160-9)
-
-struct PostInfo {
-  mesh::Identity author;
-  uint32_t post_timestamp;   // by OUR clock
-  char text[MAX_POST_TEXT_LEN+1];
-};
-
 class MyMesh : public mesh::Mesh, public CommonCLICallbacks {
   FILESYSTEM* _fs;
   uint32_t last_millis;
@@ -94,16 +86,27 @@ class MyMesh : public mesh::Mesh, public CommonCLICallbacks {
   unsigned long next_local_advert, next_flood_advert;
   bool _logging;
   NodePrefs _prefs;
+  RxDelayTable rx_delays;
   ClientACL acl;
+  PathStore client_paths;
   CommonCLI _cli;
   unsigned long dirty_contacts_expiry;
   uint8_t reply_data[MAX_PACKET_PAYLOAD];
   unsigned long next_push;
   uint16_t _num_posted, _num_post_pushes;
-  int next_client_idx;  // for round-robin polling
-  int next_post_idx;
-  PostInfo posts[MAX_UNSYNCED_POSTS];   // cyclic queue
+  PostStore posts;
+  struct PrevAck {
+    uint32_t ack;
+    uint32_t post_timestamp;
+    uint8_t client_prefix[4];
+  };
+  #define PREV_ACK_TABLE_SIZE  16
+  PrevAck prev_acks[PREV_ACK_TABLE_SIZE];   // cyclic table of timed-out expected ACKs (may still arrive LATER)
+  int next_prev_ack_idx;
+  uint32_t push_airtime_credit;   // millis of airtime currently available for pushes
+  unsigned long last_credit_update;
   CayenneLPP telemetry;
+  StatsTLVEncoder stats_tlv;
   unsigned long set_radio_at, revert_radio_at;
   float pending_freq;
   float pending_bw;
@@ -113,11 +116,16 @@ class MyMesh : public mesh::Mesh, public CommonCLICallbacks {
 
   void addPost(ClientInfo* client, const char* postData);
   void pushPostToClient(ClientInfo* client, PostInfo& post);
+  ClientInfo* selectNextPushClient(PostInfo& post);
+  uint32_t estPushRoundTrip(const ClientInfo* client) const;
+  uint32_t estPushAirtime(const ClientInfo* client, const PostInfo& post);
+  void updatePushCredit();
   uint8_t getUnsyncedCount(ClientInfo* client);
   bool processAck(const uint8_t *data);
   mesh::Packet* createSelfAdvert();
   File openAppend(const char* fname);
   int handleRequest(ClientInfo* sender, uint32_t sender_timestamp, uint8_t* payload, size_t payload_len);
+  uint32_t getStatsValues(uint32_t values[]);
 
 protected:
   float getAirtimeBudgetFactor() const override {
@@ -0,0 +1,172 @@
+#include "PostStore.h"
+#include <helpers/TxtDataHelpers.h>
+
+#define POST_LOG_FILE   "/posts"
+
+struct PostRecord {
+  uint32_t seq_plus1;   // zero means unused
+  PostInfo post;
+};
+
+static File openRead(FILESYSTEM* fs, const char* filename) {
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  return fs->open(filename, FILE_O_READ);
+#elif defined(RP2040_PLATFORM)
+  return fs->open(filename, "r");
+#else
+  return fs->open(filename, "r", false);
+#endif
+}
+
+static File openReadWrite(FILESYSTEM* fs, const char* filename) {
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  return fs->open(filename, FILE_O_WRITE);   // NOTE: does not truncate, and allows seek()
+#elif defined(RP2040_PLATFORM)
+  return fs->open(filename, fs->exists(filename) ? "r+" : "w+");
+#else
+  return fs->open(filename, fs->exists(filename) ? "r+" : "w+", true);
+#endif
+}
+
+PostStore::PostStore() {
+  _fs = NULL;
+  _next_seq = 0;
+  _num = 0;
+  memset(_timestamps, 0, sizeof(_timestamps));
+  memset(_authors, 0, sizeof(_authors));
+  memset(_cache, 0, sizeof(_cache));
+}
+
+void PostStore::begin(FILESYSTEM* fs) {
+  _fs = fs;
+  _next_seq = 0;
+  _num = 0;
+  if (_fs == NULL || !_fs->exists(POST_LOG_FILE)) return;
+
+  File file = openRead(_fs, POST_LOG_FILE);
+  if (file) {
+    // pass 1: find the newest record
+    uint32_t max_seq_plus1 = 0;
+    PostRecord rec;
+    for (int slot = 0; slot < MAX_STORED_POSTS; slot++) {
+      if (file.read((uint8_t *) &rec, sizeof(rec)) != sizeof(rec)) break;  // EOF
+      if (rec.seq_plus1 > max_seq_plus1 && (rec.seq_plus1 - 1) % MAX_STORED_POSTS == slot) {
+        max_seq_plus1 = rec.seq_plus1;
+      }
+    }
+
+    // pass 2: walk back from newest, rebuilding the index (stop at first gap, or record from an older cycle)
+    _next_seq = max_seq_plus1;
+    while (_num < MAX_STORED_POSTS && _num < (int) _next_seq) {
+      uint32_t seq = _next_seq - 1 - _num;
+      int slot = seq % MAX_STORED_POSTS;
+      file.seek(slot * sizeof(PostRecord));
+      if (file.read((uint8_t *) &rec, sizeof(rec)) != sizeof(rec) || rec.seq_plus1 != seq + 1) break;
+      if (_num > 0 && rec.post.post_timestamp >= _timestamps[(seq + 1) % MAX_STORED_POSTS]) break;  // out of order
+
+      _timestamps[slot] = rec.post.post_timestamp;
+      _authors[slot] = authorPrefix(rec.post.author);
+      if (_num < MAX_UNSYNCED_POSTS) {
+        _cache[seq % MAX_UNSYNCED_POSTS] = rec.post;
+      }
+      _num++;
+    }
+    file.close();
+    MESH_DEBUG_PRINTLN("PostStore::begin() - restored %d posts", _num);
+  }
+}
+
+void PostStore::writeRecord(uint32_t seq, const PostInfo& post) {
+  File file = openReadWrite(_fs, POST_LOG_FILE);
+  if (file) {
+    PostRecord rec;
+    rec.seq_plus1 = seq + 1;
+    rec.post = post;
+    file.seek((seq % MAX_STORED_POSTS) * sizeof(PostRecord));
+    if (file.write((const uint8_t *) &rec, sizeof(rec)) != sizeof(rec)) {
+      MESH_DEBUG_PRINTLN("PostStore: post log write failed");
+    }
+    file.close();
+  }
+}
+
+uint32_t PostStore::addPost(const mesh::Identity& author, uint32_t timestamp, const char* text) {
+  uint32_t newest = getNewestTimestamp();
+  if (timestamp <= newest) timestamp = newest + 1;   // keep log ascending (eg. if RTC went backwards)
+
+  uint32_t seq = _next_seq++;
+  PostInfo* p = &_cache[seq % MAX_UNSYNCED_POSTS];
+  p->author = author;
+  p->post_timestamp = timestamp;
+  StrHelper::strncpy(p->text, text, sizeof(p->text));
+
+  int slot = seq % MAX_STORED_POSTS;
+  _timestamps[slot] = timestamp;
+  _authors[slot] = authorPrefix(author);
+
+  int capacity = _fs ? MAX_STORED_POSTS : MAX_UNSYNCED_POSTS;   // without log, only cache can be retained
+  if (_num < capacity) _num++;
+
+  if (_fs) writeRecord(seq, *p);
+  return timestamp;
+}
+
+int PostStore::findFirstAfter(uint32_t since) const {
+  // binary search for first post with timestamp > since  (returns offset from firstSeq())
+  int lo = 0, hi = _num;
+  uint32_t first = firstSeq();
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (_timestamps[(first + mid) % MAX_STORED_POSTS] > since) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+bool PostStore::loadPost(uint32_t seq, PostInfo& dest) {
+  int cached = _num < MAX_UNSYNCED_POSTS ? _num : MAX_UNSYNCED_POSTS;
+  if (seq >= _next_seq - cached) {   // is in recent posts cache?
+    dest = _cache[seq % MAX_UNSYNCED_POSTS];
+    return true;
+  }
+  if (_fs == NULL) return false;
+
+  bool success = false;
+  File file = openRead(_fs, POST_LOG_FILE);
+  if (file) {
+    PostRecord rec;
+    file.seek((seq % MAX_STORED_POSTS) * sizeof(PostRecord));
+    if (file.read((uint8_t *) &rec, sizeof(rec)) == sizeof(rec) && rec.seq_plus1 == seq + 1) {
+      dest = rec.post;
+      success = true;
+    }
+    file.close();
+  }
+  return success;
+}
+
+bool PostStore::findNextFor(const mesh::Identity& client, uint32_t since, uint32_t until, PostInfo& dest) {
+  uint32_t first = firstSeq();
+  for (int i = findFirstAfter(since); i < _num; i++) {
+    uint32_t seq = first + i;
+    int slot = seq % MAX_STORED_POSTS;
+    if (_timestamps[slot] > until) break;   // not eligible yet (nor any after it)
+    if (_authors[slot] == authorPrefix(client)) continue;  // don't push posts to the author
+
+    if (loadPost(seq, dest)) return true;
+  }
+  return false;
+}
+
+int PostStore::countUnsyncedFor(const mesh::Identity& client, uint32_t since, int max_count) {
+  int count = 0;
+  uint32_t first = firstSeq();
+  uint32_t prefix = authorPrefix(client);
+  for (int i = findFirstAfter(since); i < _num && count < max_count; i++) {
+    if (_authors[(first + i) % MAX_STORED_POSTS] != prefix) count++;
+  }
+  return count;
+}
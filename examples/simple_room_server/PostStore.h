@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>   // needed for PlatformIO
+#include <Mesh.h>
+
+#if defined(NRF52_PLATFORM)
+  #include <InternalFileSystem.h>
+#elif defined(RP2040_PLATFORM)
+  #include <LittleFS.h>
+#elif defined(ESP32)
+  #include <SPIFFS.h>
+#endif
+
+#define MAX_POST_TEXT_LEN    (160-9)
+
+#ifndef MAX_UNSYNCED_POSTS
+  #define MAX_UNSYNCED_POSTS    32     // now the size of the in-RAM cache of most recent posts
+#endif
+
+#ifndef MAX_STORED_POSTS
+  #if defined(ESP32)
+    #define MAX_STORED_POSTS    1024
+  #else
+    #define MAX_STORED_POSTS    MAX_UNSYNCED_POSTS    // small flash, so just persist what was held in RAM
+  #endif
+#endif
+
+struct PostInfo {
+  mesh::Identity author;
+  uint32_t post_timestamp;   // by OUR clock
+  char text[MAX_POST_TEXT_LEN+1];
+};
+
+/**
+ * \brief  Persistent log of room posts. Posts are appended to a cyclic file of fixed size records (oldest
+ *     overwritten once MAX_STORED_POSTS is reached). RAM holds only a timestamp + author key prefix index per
+ *     post, plus a cache of the most recent MAX_UNSYNCED_POSTS posts, so a client's 'sync_since' is a binary
+ *     search and the 'not from this client' test never needs to touch flash.
+ */
+class PostStore {
+  FILESYSTEM* _fs;
+  uint32_t _next_seq;     // sequence number of next post (record slot is seq % MAX_STORED_POSTS)
+  int _num;               // number of posts currently retained
+  uint32_t _timestamps[MAX_STORED_POSTS];   // index, by slot (ascending, by seq)
+  uint32_t _authors[MAX_STORED_POSTS];      // index, by slot (author pub_key prefix, see authorPrefix())
+  PostInfo _cache[MAX_UNSYNCED_POSTS];      // most recent posts, by seq % MAX_UNSYNCED_POSTS
+
+  uint32_t firstSeq() const { return _next_seq - _num; }
+  static uint32_t authorPrefix(const mesh::Identity& id) { uint32_t p; memcpy(&p, id.pub_key, sizeof(p)); return p; }
+  int findFirstAfter(uint32_t since) const;
+  bool loadPost(uint32_t seq, PostInfo& dest);
+  void writeRecord(uint32_t seq, const PostInfo& post);
+
+public:
+  PostStore();
+
+  /**
+   * \brief  restores the index (and recent posts cache) from the post log.
+   * \param  fs  can be NULL, in which case posts are only kept in RAM cache.
+   */
+  void begin(FILESYSTEM* fs);
+
+  /**
+   * \brief  appends a new post. (timestamp is bumped if needed, so log stays in ascending timestamp order)
+   * \returns  the timestamp assigned to the post
+   */
+  uint32_t addPost(const mesh::Identity& author, uint32_t timestamp, const char* text);
+
+  /**
+   * \brief  finds the oldest post with timestamp in range (since, until], which was NOT authored by 'client'.
+   * \returns  true if found (copied to 'dest')
+   */
+  bool findNextFor(const mesh::Identity& client, uint32_t since, uint32_t until, PostInfo& dest);
+
+  /**
+   * \returns  number of posts newer than 'since', NOT authored by 'client' (capped at 'max_count')
+   */
+  int countUnsyncedFor(const mesh::Identity& client, uint32_t since, int max_count);
+
+  int getNumPosts() const { return _num; }
+  uint32_t getNewestTimestamp() const { return _num > 0 ? _timestamps[(_next_seq - 1) % MAX_STORED_POSTS] : 0; }
+};
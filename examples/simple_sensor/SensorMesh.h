@@ -22,6 +22,7 @@
 #include <helpers/CommonCLI.h>
 #include <helpers/StatsFormatHelper.h>
 #include <helpers/ClientACL.h>
+#include <helpers/RxDelayTable.h>
 #include <RTClib.h>
 #include <target.h>
 
@@ -133,6 +134,7 @@ private:
   FILESYSTEM* _fs;
   unsigned long next_local_advert, next_flood_advert;
   NodePrefs _prefs;
+  RxDelayTable rx_delays;
   ClientACL  acl;
   CommonCLI _cli;
   uint8_t reply_data[MAX_PACKET_PAYLOAD];
@@ -152,7 +154,7 @@ private:
   uint8_t handleRequest(uint8_t perms, uint32_t sender_timestamp, uint8_t req_type, uint8_t* payload, size_t payload_len);
   mesh::Packet* createSelfAdvert();
 
-  void sendAlert(const ClientInfo* c, Trigger* t);
+  void sendAlert(ClientInfo* c, Trigger* t);   // (non-const, as shared secret is calculated lazily)
 
   #if ENV_INCLUDE_GPS == 1
   void applyGpsPrefs() {
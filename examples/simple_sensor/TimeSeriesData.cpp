@@ -1,5 +1,99 @@
 #include "TimeSeriesData.h"
 
+#define MIN_BUCKETS_PER_QUERY    4     // a rollup tier is only used when the range spans at least this many buckets
+#define ROLLUP_FILE_VERSION      1
+
+static File openRead(FILESYSTEM* fs, const char* filename) {
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  return fs->open(filename, FILE_O_READ);
+#elif defined(RP2040_PLATFORM)
+  return fs->open(filename, "r");
+#else
+  return fs->open(filename, "r", false);
+#endif
+}
+
+static File openWrite(FILESYSTEM* fs, const char* filename) {
+#if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+  fs->remove(filename);
+  return fs->open(filename, FILE_O_WRITE);
+#elif defined(RP2040_PLATFORM)
+  return fs->open(filename, "w");
+#else
+  return fs->open(filename, "w", true);
+#endif
+}
+
+static int putVarint(uint8_t* dest, uint32_t v) {
+  int len = 0;
+  while (v >= 0x80) {
+    dest[len++] = (v & 0x7F) | 0x80;
+    v >>= 7;
+  }
+  dest[len++] = v;
+  return len;
+}
+
+static bool getVarint(File& file, uint32_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 32; shift += 7) {
+    int c = file.read();
+    if (c < 0) return false;   // EOF
+    v |= ((uint32_t)(c & 0x7F)) << shift;
+    if ((c & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+static inline uint32_t zigzag(int32_t v) { return (((uint32_t) v) << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+int16_t TimeSeriesData::quantise(float v) const {
+  float q = v / quantum;
+  if (q > 32767.0f) return 32767;
+  if (q < -32767.0f) return -32767;
+  return (int16_t) lroundf(q);
+}
+
+bool TimeSeriesData::addRollup(int num_buckets, uint32_t bucket_secs) {
+  if (num_tiers >= MAX_ROLLUP_TIERS) return false;
+
+  Tier* t = &tiers[num_tiers++];
+  memset(t, 0, sizeof(*t));
+  t->bucket_secs = bucket_secs;
+  t->num_buckets = num_buckets;
+  t->buckets = new Rollup[num_buckets];
+  memset(t->buckets, 0, sizeof(Rollup)*num_buckets);
+  return true;
+}
+
+void TimeSeriesData::closeBucket(Tier& t) {
+  if (t.num_filled > 0 && t.curr.start <= t.last_start) {
+    // RTC has gone backwards (eg. re-synced). Keep history, and file this bucket as the one after the newest
+    t.curr.start = t.last_start + t.bucket_secs;
+  } else if (t.num_filled > 0) {
+    // insert empty buckets for any gap (eg. were powered off)
+    uint32_t gap = (t.curr.start - t.last_start) / t.bucket_secs - 1;
+    if (gap > t.num_buckets) gap = t.num_buckets;
+    while (gap > 0) {
+      memset(&t.buckets[t.next], 0, sizeof(Rollup));
+      t.next = (t.next + 1) % t.num_buckets;
+      if (t.num_filled < t.num_buckets) t.num_filled++;
+      gap--;
+    }
+  }
+  Rollup* r = &t.buckets[t.next];
+  r->_min = quantise(t.curr.min);
+  r->_max = quantise(t.curr.max);
+  r->_avg = quantise(t.curr.sum / t.curr.count);
+  r->_count = t.curr.count;
+  t.next = (t.next + 1) % t.num_buckets;
+  if (t.num_filled < t.num_buckets) t.num_filled++;
+
+  t.last_start = t.curr.start;
+  t.curr.count = 0;
+}
+
 void TimeSeriesData::recordData(mesh::RTCClock* clock, float value) {
   uint32_t now = clock->getCurrentTime();
   if (now >= last_timestamp + interval_secs) {
@@ -7,34 +101,105 @@ void TimeSeriesData::recordData(mesh::RTCClock* clock, float value) {
 
     data[next] = value;   // append to cycle table
     next = (next + 1) % num_slots;
+    if (num_recorded < num_slots) num_recorded++;
+  }
+  if (isnan(value)) return;
+
+  // update the open bucket of each rollup tier
+  bool needs_save = false;
+  for (int i = 0; i < num_tiers; i++) {
+    Tier* t = &tiers[i];
+    uint32_t start = now - (now % t->bucket_secs);
+    if (t->curr.count > 0 && start != t->curr.start) {
+      closeBucket(*t);
+      if (t->bucket_secs >= ROLLUP_SAVE_MIN_SECS) needs_save = true;
+    }
+    if (t->curr.count == 0) {
+      t->curr.start = start;
+      t->curr.min = t->curr.max = t->curr.sum = value;
+      t->curr.count = 1;
+    } else if (t->curr.count < 0xFFFF) {
+      if (value < t->curr.min) t->curr.min = value;
+      if (value > t->curr.max) t->curr.max = value;
+      t->curr.sum += value;
+      t->curr.count++;
+    }
+  }
+  if (needs_save) saveRollups();
+}
+
+void TimeSeriesData::accumulate(const Tier& t, float& total, int& num_values, float& mn, float& mx, uint32_t now, uint32_t start_secs_ago, uint32_t end_secs_ago) const {
+  if (t.curr.count > 0 && t.curr.start <= now) {   // open bucket (most recent)
+    uint32_t ago = now - t.curr.start;
+    if (ago >= end_secs_ago && ago < start_secs_ago) {
+      if (num_values == 0 || t.curr.min < mn) mn = t.curr.min;
+      if (num_values == 0 || t.curr.max > mx) mx = t.curr.max;
+      total += t.curr.sum;
+      num_values += t.curr.count;
+    }
+  }
+
+  // back-track through closed buckets, from newest, until past start of range
+  uint32_t start = t.last_start;
+  int i = t.next;
+  for (int n = 0; n < t.num_filled; n++, start -= t.bucket_secs) {
+    i = (i == 0 ? t.num_buckets : i) - 1;
+    if (start > now) continue;   // RTC behind recorded data
+
+    uint32_t ago = now - start;
+    if (ago >= start_secs_ago) break;   // none older will be in range either
+
+    const Rollup* r = &t.buckets[i];
+    if (ago >= end_secs_ago && r->_count > 0) {
+      float v_min = r->_min * quantum, v_max = r->_max * quantum;
+      if (num_values == 0 || v_min < mn) mn = v_min;
+      if (num_values == 0 || v_max > mx) mx = v_max;
+      total += r->_avg * quantum * r->_count;    // weight by number of samples
+      num_values += r->_count;
+    }
   }
 }
 
 void TimeSeriesData::calcMinMaxAvg(mesh::RTCClock* clock, uint32_t start_secs_ago, uint32_t end_secs_ago, MinMaxAvg* dest, uint8_t channel, uint8_t lpp_type) const {
-  int i = next, n = num_slots;
-  uint32_t ago = clock->getCurrentTime() - last_timestamp;
+  uint32_t now = clock->getCurrentTime();
   int num_values = 0;
   float total = 0.0f;
 
   dest->_channel = channel;
   dest->_lpp_type = lpp_type;
 
-  // start at most recet recording, back-track through to oldest
-  while (n > 0) {
-    n--;
-    i = (i + num_slots - 1) % num_slots;  // go back by one
-    if (ago >= end_secs_ago && ago < start_secs_ago) {   // filter by the desired time range
-      float v = data[i];
-      num_values++;
-      total += v;
-      if (num_values == 1) {
-        dest->_max = dest->_min = v;
-      } else {
-        if (v < dest->_min) dest->_min = v;
-        if (v > dest->_max) dest->_max = v;
+  // choose coarsest tier that still has enough resolution (or, which reaches back far enough)
+  uint32_t span = start_secs_ago > end_secs_ago ? start_secs_ago - end_secs_ago : 0;
+  uint32_t covers = num_slots * interval_secs;
+  int sel = -1;   // raw samples
+  for (int t = 0; t < num_tiers; t++) {
+    if (tiers[t].bucket_secs * MIN_BUCKETS_PER_QUERY <= span || covers < start_secs_ago) {
+      sel = t;
+      covers = tiers[t].bucket_secs * tiers[t].num_buckets;
+    }
+  }
+
+  if (sel >= 0) {
+    accumulate(tiers[sel], total, num_values, dest->_min, dest->_max, now, start_secs_ago, end_secs_ago);
+  } else {
+    int i = next;
+    uint32_t ago = now - last_timestamp;
+
+    // start at most recet recording, back-track through to oldest
+    for (int n = 0; n < num_recorded && ago < start_secs_ago; n++, ago += interval_secs) {
+      i = (i == 0 ? num_slots : i) - 1;  // go back by one
+      if (ago >= end_secs_ago) {   // filter by the desired time range
+        float v = data[i];
+        num_values++;
+        total += v;
+        if (num_values == 1) {
+          dest->_max = dest->_min = v;
+        } else {
+          if (v < dest->_min) dest->_min = v;
+          if (v > dest->_max) dest->_max = v;
+        }
       }
     }
-    ago += interval_secs;
   }
   // calc average
   if (num_values > 0) {
@@ -43,3 +208,106 @@ void TimeSeriesData::calcMinMaxAvg(mesh::RTCClock* clock, uint32_t start_secs_ag
     dest->_max = dest->_min = dest->_avg = NAN;
   }
 }
+
+/*
+  File format:  version(1), num_tiers(1), then per tier:
+      bucket_secs(4), num_buckets(2), num_filled(2), last_start(4),
+      open bucket: start(4), min(4), max(4), sum(4), count(2),
+      closed buckets, oldest to newest:  varint count, and if non-zero:
+          zigzag varint (avg - prev_avg), varint (avg - min), varint (max - avg)
+*/
+void TimeSeriesData::saveRollups() {
+  if (_fs == NULL || _filename == NULL) return;
+
+  File file = openWrite(_fs, _filename);
+  if (file) {
+    uint8_t hdr[2] = { ROLLUP_FILE_VERSION, (uint8_t) num_tiers };
+    bool success = (file.write(hdr, 2) == 2);
+
+    for (int i = 0; i < num_tiers && success; i++) {
+      const Tier* t = &tiers[i];
+      uint16_t num_buckets = t->num_buckets, num_filled = t->num_filled;
+      success = success && (file.write((const uint8_t *) &t->bucket_secs, 4) == 4);
+      success = success && (file.write((const uint8_t *) &num_buckets, 2) == 2);
+      success = success && (file.write((const uint8_t *) &num_filled, 2) == 2);
+      success = success && (file.write((const uint8_t *) &t->last_start, 4) == 4);
+      success = success && (file.write((const uint8_t *) &t->curr.start, 4) == 4);
+      success = success && (file.write((const uint8_t *) &t->curr.min, 4) == 4);
+      success = success && (file.write((const uint8_t *) &t->curr.max, 4) == 4);
+      success = success && (file.write((const uint8_t *) &t->curr.sum, 4) == 4);
+      success = success && (file.write((const uint8_t *) &t->curr.count, 2) == 2);
+
+      int j = (t->next + t->num_buckets - t->num_filled) % t->num_buckets;   // oldest
+      int32_t prev_avg = 0;
+      for (int n = 0; n < t->num_filled && success; n++, j = (j + 1) % t->num_buckets) {
+        const Rollup* r = &t->buckets[j];
+        uint8_t buf[20];
+        int len = putVarint(buf, r->_count);
+        if (r->_count > 0) {
+          len += putVarint(&buf[len], zigzag(r->_avg - prev_avg));
+          len += putVarint(&buf[len], r->_avg - r->_min);
+          len += putVarint(&buf[len], r->_max - r->_avg);
+          prev_avg = r->_avg;
+        }
+        success = (file.write(buf, len) == len);
+      }
+    }
+    file.close();
+    if (!success) MESH_DEBUG_PRINTLN("TimeSeriesData: write failed: %s", _filename);
+  }
+}
+
+void TimeSeriesData::begin(FILESYSTEM* fs, const char* filename) {
+  _fs = fs;
+  _filename = filename;
+  if (_fs == NULL || !_fs->exists(_filename)) return;
+
+  File file = openRead(_fs, _filename);
+  if (file) {
+    uint8_t hdr[2];
+    bool success = (file.read(hdr, 2) == 2) && hdr[0] == ROLLUP_FILE_VERSION && hdr[1] == num_tiers;
+
+    for (int i = 0; i < num_tiers && success; i++) {
+      Tier* t = &tiers[i];
+      uint32_t bucket_secs;
+      uint16_t num_buckets, num_filled;
+      success = success && (file.read((uint8_t *) &bucket_secs, 4) == 4);
+      success = success && (file.read((uint8_t *) &num_buckets, 2) == 2);
+      success = success && (file.read((uint8_t *) &num_filled, 2) == 2);
+      success = success && bucket_secs == t->bucket_secs && num_buckets == t->num_buckets && num_filled <= num_buckets;  // config unchanged?
+      success = success && (file.read((uint8_t *) &t->last_start, 4) == 4);
+      success = success && (file.read((uint8_t *) &t->curr.start, 4) == 4);
+      success = success && (file.read((uint8_t *) &t->curr.min, 4) == 4);
+      success = success && (file.read((uint8_t *) &t->curr.max, 4) == 4);
+      success = success && (file.read((uint8_t *) &t->curr.sum, 4) == 4);
+      success = success && (file.read((uint8_t *) &t->curr.count, 2) == 2);
+
+      int32_t prev_avg = 0;
+      int n;
+      for (n = 0; n < num_filled && success; n++) {
+        Rollup* r = &t->buckets[n];
+        uint32_t count, d_avg, d_min, d_max;
+        success = getVarint(file, count);
+        r->_count = count;
+        if (success && count > 0) {
+          success = getVarint(file, d_avg) && getVarint(file, d_min) && getVarint(file, d_max);
+          r->_avg = prev_avg + unzigzag(d_avg);
+          r->_min = r->_avg - d_min;
+          r->_max = r->_avg + d_max;
+          prev_avg = r->_avg;
+        }
+      }
+      t->num_filled = n;
+      t->next = n % t->num_buckets;
+    }
+    file.close();
+
+    if (!success) {   // corrupt, or tiers have been re-configured, so start afresh
+      MESH_DEBUG_PRINTLN("TimeSeriesData: discarding rollups in: %s", _filename);
+      for (int i = 0; i < num_tiers; i++) {
+        tiers[i].num_filled = tiers[i].next = 0;
+        tiers[i].curr.count = 0;
+      }
+    }
+  }
+}
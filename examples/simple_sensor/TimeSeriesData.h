@@ -3,27 +3,94 @@
 #include <Arduino.h>
 #include <Mesh.h>
 
+#if defined(NRF52_PLATFORM)
+  #include <InternalFileSystem.h>
+#elif defined(RP2040_PLATFORM)
+  #include <LittleFS.h>
+#elif defined(ESP32)
+  #include <SPIFFS.h>
+#endif
+
+#ifndef MAX_ROLLUP_TIERS
+  #define MAX_ROLLUP_TIERS   4
+#endif
+
+#ifndef ROLLUP_SAVE_MIN_SECS
+  #define ROLLUP_SAVE_MIN_SECS   (60*60)    // only write to flash when a bucket of at least this size closes
+#endif
+
 struct MinMaxAvg {
   float _min, _max, _avg;
   uint8_t _lpp_type, _channel;
 };
 
+/**
+ * \brief  Recent samples are kept in a ring at 'interval_secs' (the raw tier), and can optionally also be rolled
+ *    up into coarser tiers (eg. 15 min -> hourly -> daily), each a ring of quantised min/max/avg/count buckets,
+ *    maintained incrementally as each value is recorded. Range queries are answered from the coarsest tier
+ *    which still has enough resolution, so long histories need only a few buckets visited. The rollup tiers
+ *    can be persisted to flash (delta encoded), so history survives a reboot.
+ */
 class TimeSeriesData {
+  struct Rollup {
+    int16_t _min, _max, _avg;   // in units of 'quantum'
+    uint16_t _count;            // zero means no data in this bucket
+  };
+  struct Accum {      // the currently open bucket (not yet quantised)
+    uint32_t start;
+    float min, max, sum;
+    uint16_t count;
+  };
+  struct Tier {
+    uint32_t bucket_secs;
+    Rollup* buckets;    // cyclic, 'next' is oldest
+    int num_buckets, next, num_filled;
+    uint32_t last_start;   // start time of most recent closed bucket
+    Accum curr;
+  };
+
   float* data;
-  int num_slots, next;
+  int num_slots, next, num_recorded;
   uint32_t last_timestamp;
   uint32_t interval_secs;
+  float quantum;
+  Tier tiers[MAX_ROLLUP_TIERS];
+  int num_tiers;
+  FILESYSTEM* _fs;
+  const char* _filename;
+
+  int16_t quantise(float v) const;
+  void closeBucket(Tier& t);
+  void accumulate(const Tier& t, float& total, int& num_values, float& mn, float& mx, uint32_t now, uint32_t start_secs_ago, uint32_t end_secs_ago) const;
+  void saveRollups();
 
 public:
-  TimeSeriesData(float* array, int num, uint32_t secs) : num_slots(num), data(array), last_timestamp(0), next(0), interval_secs(secs) { 
+  TimeSeriesData(float* array, int num, uint32_t secs) : num_slots(num), data(array), last_timestamp(0), next(0), interval_secs(secs) {
     memset(data, 0, sizeof(float)*num);
+    num_recorded = 0; quantum = 0.01f; num_tiers = 0; _fs = NULL; _filename = NULL;
   }
   TimeSeriesData(int num, uint32_t secs) : num_slots(num), last_timestamp(0), next(0), interval_secs(secs) {
     data = new float[num];
     memset(data, 0, sizeof(float)*num);
+    num_recorded = 0; quantum = 0.01f; num_tiers = 0; _fs = NULL; _filename = NULL;
   }
 
+  /**
+   * \brief  sets the resolution that rollup values are stored at. (default is 0.01, ie. range is +/- 327.67)
+   */
+  void setQuantum(float q) { quantum = q; }
+
+  /**
+   * \brief  adds a rollup tier. Must be added in order of increasing 'bucket_secs', before begin().
+   * \returns  false, if MAX_ROLLUP_TIERS exceeded
+   */
+  bool addRollup(int num_buckets, uint32_t bucket_secs);
+
+  /**
+   * \brief  restores the rollup tiers from 'filename' (if tier config unchanged), and enables saving to it.
+   */
+  void begin(FILESYSTEM* fs, const char* filename);
+
   void recordData(mesh::RTCClock* clock, float value);
   void calcMinMaxAvg(mesh::RTCClock* clock, uint32_t start_secs_ago, uint32_t end_secs_ago, MinMaxAvg* dest, uint8_t channel, uint8_t lpp_type) const;
 };
-
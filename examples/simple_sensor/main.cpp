@@ -9,8 +9,16 @@ class MyMesh : public SensorMesh {
 public:
   MyMesh(mesh::MainBoard& board, mesh::Radio& radio, mesh::MillisecondClock& ms, mesh::RNG& rng, mesh::RTCClock& rtc, mesh::MeshTables& tables)
      : SensorMesh(board, radio, ms, rng, rtc, tables), 
-       battery_data(12*24, 5*60)    // 24 hours worth of battery data, every 5 minutes
+       battery_data(12, 5*60)    // last hour of battery data, every 5 minutes
   {
+    battery_data.addRollup(4*6, 15*60);     // then 6 hours of 15 minute rollups
+    battery_data.addRollup(48, 60*60);      // 2 days of hourly
+    battery_data.addRollup(8*7, 24*60*60);  // 8 weeks of daily
+  }
+
+  void begin(FILESYSTEM* fs) {
+    SensorMesh::begin(fs);
+    battery_data.begin(fs, "/batt_data");   // restore rollup history
   }
 
 protected:
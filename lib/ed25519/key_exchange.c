@@ -1,10 +1,255 @@
 #include "ed_25519.h"
 #include "fe.h"
 
-void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key) {
-    unsigned char e[32];
-    unsigned int i;
-    
+#if defined(__SIZEOF_INT128__)
+
+/*
+    64-bit targets: field elements in radix 2^51 (5 limbs), with 64x64->128 multiplies.
+    About 3x fewer multiply instructions than the generic 10 limb 'fe' ladder below.
+*/
+
+typedef uint64_t fe51[5];
+typedef unsigned __int128 uint128_t;
+
+#define MASK51  0x7ffffffffffffULL
+
+static uint64_t load_8(const unsigned char *in) {
+    uint64_t r = 0;
+    int i;
+    for (i = 7; i >= 0; --i) {
+        r = (r << 8) | in[i];
+    }
+    return r;
+}
+
+static void store_8(unsigned char *out, uint64_t v) {
+    int i;
+    for (i = 0; i < 8; ++i) {
+        out[i] = (unsigned char) v;
+        v >>= 8;
+    }
+}
+
+static void fe51_frombytes(fe51 h, const unsigned char *s) {
+    uint64_t t0 = load_8(s), t1 = load_8(s + 8), t2 = load_8(s + 16), t3 = load_8(s + 24);
+    h[0] = t0 & MASK51;
+    h[1] = ((t0 >> 51) | (t1 << 13)) & MASK51;
+    h[2] = ((t1 >> 38) | (t2 << 26)) & MASK51;
+    h[3] = ((t2 >> 25) | (t3 << 39)) & MASK51;
+    h[4] = (t3 >> 12) & MASK51;   /* top bit is ignored */
+}
+
+static void fe51_carry(uint64_t t[5]) {
+    t[1] += t[0] >> 51; t[0] &= MASK51;
+    t[2] += t[1] >> 51; t[1] &= MASK51;
+    t[3] += t[2] >> 51; t[2] &= MASK51;
+    t[4] += t[3] >> 51; t[3] &= MASK51;
+    t[0] += 19 * (t[4] >> 51); t[4] &= MASK51;
+}
+
+static void fe51_tobytes(unsigned char *s, const fe51 f) {
+    uint64_t t[5];
+    int i;
+    for (i = 0; i < 5; ++i) {
+        t[i] = f[i];
+    }
+    fe51_carry(t);
+    fe51_carry(t);
+
+    /* now 0 <= t < 2^255. Add 19, so values >= p overflow bit 255 */
+    t[0] += 19;
+    fe51_carry(t);
+
+    /* now 19 <= t < 2^255 + 19 (mod 2^255). Add 2^255 - 19, then drop bit 255 */
+    t[0] += 0x8000000000000ULL - 19;
+    t[1] += 0x8000000000000ULL - 1;
+    t[2] += 0x8000000000000ULL - 1;
+    t[3] += 0x8000000000000ULL - 1;
+    t[4] += 0x8000000000000ULL - 1;
+
+    t[1] += t[0] >> 51; t[0] &= MASK51;
+    t[2] += t[1] >> 51; t[1] &= MASK51;
+    t[3] += t[2] >> 51; t[2] &= MASK51;
+    t[4] += t[3] >> 51; t[3] &= MASK51;
+    t[4] &= MASK51;
+
+    store_8(s,      t[0]        | (t[1] << 51));
+    store_8(s + 8,  (t[1] >> 13) | (t[2] << 38));
+    store_8(s + 16, (t[2] >> 26) | (t[3] << 25));
+    store_8(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+static void fe51_1(fe51 h) {
+    h[0] = 1; h[1] = h[2] = h[3] = h[4] = 0;
+}
+
+static void fe51_copy(fe51 h, const fe51 f) {
+    h[0] = f[0]; h[1] = f[1]; h[2] = f[2]; h[3] = f[3]; h[4] = f[4];
+}
+
+static void fe51_add(fe51 h, const fe51 f, const fe51 g) {
+    h[0] = f[0] + g[0]; h[1] = f[1] + g[1]; h[2] = f[2] + g[2]; h[3] = f[3] + g[3]; h[4] = f[4] + g[4];
+}
+
+/* h = f - g  (adds 2p first, so limbs stay positive) */
+static void fe51_sub(fe51 h, const fe51 f, const fe51 g) {
+    h[0] = (f[0] + 0xfffffffffffdaULL) - g[0];
+    h[1] = (f[1] + 0xffffffffffffeULL) - g[1];
+    h[2] = (f[2] + 0xffffffffffffeULL) - g[2];
+    h[3] = (f[3] + 0xffffffffffffeULL) - g[3];
+    h[4] = (f[4] + 0xffffffffffffeULL) - g[4];
+}
+
+static void fe51_reduce(fe51 h, uint128_t r0, uint128_t r1, uint128_t r2, uint128_t r3, uint128_t r4) {
+    uint64_t c;
+    c = (uint64_t) (r0 >> 51); h[0] = (uint64_t) r0 & MASK51; r1 += c;
+    c = (uint64_t) (r1 >> 51); h[1] = (uint64_t) r1 & MASK51; r2 += c;
+    c = (uint64_t) (r2 >> 51); h[2] = (uint64_t) r2 & MASK51; r3 += c;
+    c = (uint64_t) (r3 >> 51); h[3] = (uint64_t) r3 & MASK51; r4 += c;
+    c = (uint64_t) (r4 >> 51); h[4] = (uint64_t) r4 & MASK51;
+    h[0] += c * 19;
+    h[1] += h[0] >> 51; h[0] &= MASK51;
+}
+
+/* limbs of f and g must be < 2^54 */
+static void fe51_mul(fe51 h, const fe51 f, const fe51 g) {
+    uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+    uint64_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4;
+
+    uint128_t r0 = (uint128_t) f0 * g0 + (uint128_t) f1 * g4_19 + (uint128_t) f2 * g3_19 + (uint128_t) f3 * g2_19 + (uint128_t) f4 * g1_19;
+    uint128_t r1 = (uint128_t) f0 * g1 + (uint128_t) f1 * g0 + (uint128_t) f2 * g4_19 + (uint128_t) f3 * g3_19 + (uint128_t) f4 * g2_19;
+    uint128_t r2 = (uint128_t) f0 * g2 + (uint128_t) f1 * g1 + (uint128_t) f2 * g0 + (uint128_t) f3 * g4_19 + (uint128_t) f4 * g3_19;
+    uint128_t r3 = (uint128_t) f0 * g3 + (uint128_t) f1 * g2 + (uint128_t) f2 * g1 + (uint128_t) f3 * g0 + (uint128_t) f4 * g4_19;
+    uint128_t r4 = (uint128_t) f0 * g4 + (uint128_t) f1 * g3 + (uint128_t) f2 * g2 + (uint128_t) f3 * g1 + (uint128_t) f4 * g0;
+
+    fe51_reduce(h, r0, r1, r2, r3, r4);
+}
+
+static void fe51_sq(fe51 h, const fe51 f) {
+    uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint64_t f0_2 = 2 * f0, f1_2 = 2 * f1;
+    uint64_t f3_19 = 19 * f3, f4_19 = 19 * f4;
+
+    uint128_t r0 = (uint128_t) f0 * f0 + (uint128_t) f1_2 * f4_19 + (uint128_t) (2 * f2) * f3_19;
+    uint128_t r1 = (uint128_t) f0_2 * f1 + (uint128_t) (2 * f2) * f4_19 + (uint128_t) f3 * f3_19;
+    uint128_t r2 = (uint128_t) f0_2 * f2 + (uint128_t) f1 * f1 + (uint128_t) (2 * f3) * f4_19;
+    uint128_t r3 = (uint128_t) f0_2 * f3 + (uint128_t) f1_2 * f2 + (uint128_t) f4 * f4_19;
+    uint128_t r4 = (uint128_t) f0_2 * f4 + (uint128_t) f1_2 * f3 + (uint128_t) f2 * f2;
+
+    fe51_reduce(h, r0, r1, r2, r3, r4);
+}
+
+static void fe51_mul121666(fe51 h, const fe51 f) {
+    fe51_reduce(h, (uint128_t) f[0] * 121666, (uint128_t) f[1] * 121666, (uint128_t) f[2] * 121666,
+                   (uint128_t) f[3] * 121666, (uint128_t) f[4] * 121666);
+}
+
+static void fe51_sqn(fe51 h, const fe51 f, int n) {
+    fe51_sq(h, f);
+    while (--n > 0) {
+        fe51_sq(h, h);
+    }
+}
+
+static void fe51_invert(fe51 out, const fe51 z) {
+    fe51 t0, t1, t2, t3;
+
+    /* z^(p-2), same addition chain as fe_invert() */
+    fe51_sq(t0, z);
+    fe51_sqn(t1, t0, 2);
+    fe51_mul(t1, z, t1);
+    fe51_mul(t0, t0, t1);
+    fe51_sq(t2, t0);
+    fe51_mul(t1, t1, t2);
+    fe51_sqn(t2, t1, 5);
+    fe51_mul(t1, t2, t1);
+    fe51_sqn(t2, t1, 10);
+    fe51_mul(t2, t2, t1);
+    fe51_sqn(t3, t2, 20);
+    fe51_mul(t2, t3, t2);
+    fe51_sqn(t2, t2, 10);
+    fe51_mul(t1, t2, t1);
+    fe51_sqn(t2, t1, 50);
+    fe51_mul(t2, t2, t1);
+    fe51_sqn(t3, t2, 100);
+    fe51_mul(t2, t3, t2);
+    fe51_sqn(t2, t2, 50);
+    fe51_mul(t1, t2, t1);
+    fe51_sqn(t1, t1, 5);
+    fe51_mul(out, t1, t0);
+}
+
+static void fe51_cswap(fe51 f, fe51 g, unsigned int b) {
+    uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+    int i;
+    for (i = 0; i < 5; ++i) {
+        uint64_t x = mask & (f[i] ^ g[i]);
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+
+static void x25519_ladder(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *e) {
+    fe51 x1, x2, z2, x3, z3, tmp0, tmp1;
+    int pos;
+    unsigned int swap;
+    unsigned int b;
+
+    /* unpack the public key and convert edwards to montgomery */
+    /* due to CodesInChaos: montgomeryX = (edwardsY + 1)*inverse(1 - edwardsY) mod p */
+    fe51_frombytes(x1, public_key);
+    fe51_1(tmp1);
+    fe51_add(tmp0, x1, tmp1);
+    fe51_sub(tmp1, tmp1, x1);
+    fe51_invert(tmp1, tmp1);
+    fe51_mul(x1, tmp0, tmp1);
+
+    fe51_1(x2);
+    z2[0] = z2[1] = z2[2] = z2[3] = z2[4] = 0;
+    fe51_copy(x3, x1);
+    fe51_1(z3);
+
+    swap = 0;
+    for (pos = 254; pos >= 0; --pos) {
+        b = e[pos / 8] >> (pos & 7);
+        b &= 1;
+        swap ^= b;
+        fe51_cswap(x2, x3, swap);
+        fe51_cswap(z2, z3, swap);
+        swap = b;
+
+        fe51_sub(tmp0, x3, z3);
+        fe51_sub(tmp1, x2, z2);
+        fe51_add(x2, x2, z2);
+        fe51_add(z2, x3, z3);
+        fe51_mul(z3, tmp0, x2);
+        fe51_mul(z2, z2, tmp1);
+        fe51_sq(tmp0, tmp1);
+        fe51_sq(tmp1, x2);
+        fe51_add(x3, z3, z2);
+        fe51_sub(z2, z3, z2);
+        fe51_mul(x2, tmp1, tmp0);
+        fe51_sub(tmp1, tmp1, tmp0);
+        fe51_sq(z2, z2);
+        fe51_mul121666(z3, tmp1);
+        fe51_sq(x3, x3);
+        fe51_add(tmp0, tmp0, z3);
+        fe51_mul(z3, x1, z2);
+        fe51_mul(z2, tmp1, tmp0);
+    }
+
+    fe51_cswap(x2, x3, swap);
+    fe51_cswap(z2, z3, swap);
+
+    fe51_invert(z2, z2);
+    fe51_mul(x2, x2, z2);
+    fe51_tobytes(shared_secret, x2);
+}
+
+#else
+
+static void x25519_ladder(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *e) {
     fe x1;
     fe x2;
     fe z2;
@@ -17,15 +262,6 @@ void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *pub
     unsigned int swap;
     unsigned int b;
 
-    /* copy the private key and make sure it's valid */
-    for (i = 0; i < 32; ++i) {
-        e[i] = private_key[i];
-    }
-
-    e[0] &= 248;
-    e[31] &= 63;
-    e[31] |= 64;
-
     /* unpack the public key and convert edwards to montgomery */
     /* due to CodesInChaos: montgomeryX = (edwardsY + 1)*inverse(1 - edwardsY) mod p */
     fe_frombytes(x1, public_key);
@@ -77,3 +313,21 @@ void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *pub
     fe_mul(x2, x2, z2);
     fe_tobytes(shared_secret, x2);
 }
+
+#endif
+
+void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key) {
+    unsigned char e[32];
+    unsigned int i;
+
+    /* copy the private key and make sure it's valid */
+    for (i = 0; i < 32; ++i) {
+        e[i] = private_key[i];
+    }
+
+    e[0] &= 248;
+    e[31] &= 63;
+    e[31] |= 64;
+
+    x25519_ladder(shared_secret, public_key, e);
+}
@@ -44,14 +44,33 @@ static int consttime_equal(const unsigned char *x, const unsigned char *y) {
     return !r;
 }
 
+/* S must be a canonical scalar (ie. S < L), otherwise (R, S + L) would also verify */
+static int sc_is_canonical(const unsigned char *s) {
+    static const unsigned char L[32] = {
+        0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+    };
+    int i;
+
+    for (i = 31; i >= 0; --i) {
+        if (s[i] < L[i]) {
+            return 1;
+        }
+        if (s[i] > L[i]) {
+            return 0;
+        }
+    }
+
+    return 0;   /* S == L */
+}
+
 int ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key) {
     unsigned char h[64];
     unsigned char checker[32];
-    sha512_context hash;
     ge_p3 A;
     ge_p2 R;
 
-    if (signature[63] & 224) {
+    if (!sc_is_canonical(signature + 32)) {
         return 0;
     }
 
@@ -59,12 +78,15 @@ int ed25519_verify(const unsigned char *signature, const unsigned char *message,
         return 0;
     }
 
-    sha512_init(&hash);
-    sha512_update(&hash, signature, 32);
-    sha512_update(&hash, public_key, 32);
-    sha512_update(&hash, message, message_len);
-    sha512_final(&hash, h);
-    
+    {   /* (scoped, so its stack isn't held during the scalar multiply) */
+        sha512_context hash;
+        sha512_init(&hash);
+        sha512_update(&hash, signature, 32);
+        sha512_update(&hash, public_key, 32);
+        sha512_update(&hash, message, message_len);
+        sha512_final(&hash, h);
+    }
+
     sc_reduce(h);
     ge_double_scalarmult_vartime(&R, h, &A, signature + 32);
     ge_tobytes(checker, &R);
@@ -14,14 +14,37 @@ namespace mesh {
   #define NOISE_FLOOR_CALIB_INTERVAL   2000     // 2 seconds
 #endif
 
+void Dispatcher::initInterface(RadioInterface& iface, Radio* radio) {
+  iface.radio = radio;
+  iface.outbound = NULL;
+  iface.total_air_time = 0;
+  iface.next_tx_time = 0;
+  iface.cad_busy_start = 0;
+  iface.next_floor_calib_time = iface.next_agc_reset_time = 0;
+  iface.radio_nonrx_start = 0;
+  iface.prev_isrecv_mode = true;
+}
+
+int Dispatcher::addRadio(Radio& radio) {
+  if (_num_ifaces >= MAX_RADIO_INTERFACES) return -1;
+
+  initInterface(_ifaces[_num_ifaces], &radio);
+  return _num_ifaces++;
+}
+
 void Dispatcher::begin() {
   n_sent_flood = n_sent_direct = 0;
   n_recv_flood = n_recv_direct = 0;
   _err_flags = 0;
-  radio_nonrx_start = _ms->getMillis();
-
-  _radio->begin();
-  prev_isrecv_mode = _radio->isInRecvMode();
+  util_window_start = _ms->getMillis();
+  util_busy_start = _ifaces[0].total_air_time + rx_air_time;
+
+  for (int i = 0; i < _num_ifaces; i++) {
+    auto& iface = _ifaces[i];
+    iface.radio_nonrx_start = _ms->getMillis();
+    iface.radio->begin();
+    iface.prev_isrecv_mode = iface.radio->isInRecvMode();
+  }
 }
 
 float Dispatcher::getAirtimeBudgetFactor() const {
@@ -39,63 +62,85 @@ uint32_t Dispatcher::getCADFailMaxDuration() const {
   return 4000;   // 4 seconds
 }
 
+void Dispatcher::updateChannelUtil() {
+  unsigned long now = _ms->getMillis();
+  unsigned long busy = _ifaces[0].total_air_time + rx_air_time;
+  uint32_t pct = (busy - util_busy_start) * 100 / (now - util_window_start);
+  if (pct > 100) pct = 100;   // (rx_air_time is of all interfaces)
+  channel_util = (channel_util * 3 + pct) / 4;
+
+  util_window_start = now;
+  util_busy_start = busy;
+}
+
 void Dispatcher::loop() {
-  if (millisHasNowPassed(next_floor_calib_time)) {
-    _radio->triggerNoiseFloorCalibrate(getInterferenceThreshold());
-    next_floor_calib_time = futureMillis(NOISE_FLOOR_CALIB_INTERVAL);
+  if (millisHasNowPassed(util_window_start + CHANNEL_UTIL_WINDOW_MILLIS)) {
+    updateChannelUtil();
   }
-  _radio->loop();
-
-  // check for radio 'stuck' in mode other than Rx
-  bool is_recv = _radio->isInRecvMode();
-  if (is_recv != prev_isrecv_mode) {
-    prev_isrecv_mode = is_recv;
-    if (!is_recv) {
-      radio_nonrx_start = _ms->getMillis();
+
+  int num_busy = 0;
+  for (int idx = 0; idx < _num_ifaces; idx++) {
+    auto& iface = _ifaces[idx];
+    if (millisHasNowPassed(iface.next_floor_calib_time)) {
+      iface.radio->triggerNoiseFloorCalibrate(getInterferenceThreshold());
+      iface.next_floor_calib_time = futureMillis(NOISE_FLOOR_CALIB_INTERVAL);
     }
-  }
-  if (!is_recv && _ms->getMillis() - radio_nonrx_start > 8000) {   // radio has not been in Rx mode for 8 seconds!
-    _err_flags |= ERR_EVENT_STARTRX_TIMEOUT;
-  }
+    iface.radio->loop();
+
+    // check for radio 'stuck' in mode other than Rx
+    bool is_recv = iface.radio->isInRecvMode();
+    if (is_recv != iface.prev_isrecv_mode) {
+      iface.prev_isrecv_mode = is_recv;
+      if (!is_recv) {
+        iface.radio_nonrx_start = _ms->getMillis();
+      }
+    }
+    if (!is_recv && _ms->getMillis() - iface.radio_nonrx_start > 8000) {   // radio has not been in Rx mode for 8 seconds!
+      _err_flags |= ERR_EVENT_STARTRX_TIMEOUT;
+    }
+
+    if (iface.outbound) {  // waiting for outbound send to be completed
+      Packet* outbound = iface.outbound;
+      if (iface.radio->isSendComplete()) {
+        long t = _ms->getMillis() - iface.outbound_start;
+        iface.total_air_time += t;  // keep track of how much air time we are using
+        //Serial.print("  airtime="); Serial.println(t);
 
-  if (outbound) {  // waiting for outbound send to be completed
-    if (_radio->isSendComplete()) {
-      long t = _ms->getMillis() - outbound_start;
-      total_air_time += t;  // keep track of how much air time we are using
-      //Serial.print("  airtime="); Serial.println(t);
+        // will need radio silence up to next_tx_time
+        iface.next_tx_time = futureMillis(t * getAirtimeBudgetFactor());
+
+        iface.radio->onSendFinished();
+        logTx(outbound, 2 + outbound->path_len + outbound->payload_len);
+        if (outbound->isRouteFlood()) {
+          n_sent_flood++;
+        } else {
+          n_sent_direct++;
+        }
+        releasePacket(outbound);  // return to pool
+        iface.outbound = NULL;
+      } else if (millisHasNowPassed(iface.outbound_expiry)) {
+        MESH_DEBUG_PRINTLN("%s Dispatcher::loop(): WARNING: outbound packed send timed out!", getLogDateTime());
 
-      // will need radio silence up to next_tx_time
-      next_tx_time = futureMillis(t * getAirtimeBudgetFactor());
+        iface.radio->onSendFinished();
+        logTxFail(outbound, 2 + outbound->path_len + outbound->payload_len);
 
-      _radio->onSendFinished();
-      logTx(outbound, 2 + outbound->path_len + outbound->payload_len);
-      if (outbound->isRouteFlood()) {
-        n_sent_flood++;
+        releasePacket(outbound);  // return to pool
+        iface.outbound = NULL;
       } else {
-        n_sent_direct++;
+        num_busy++;
+        continue;  // can't do any more activity on this radio until send is complete or timed out
       }
-      releasePacket(outbound);  // return to pool
-      outbound = NULL;
-    } else if (millisHasNowPassed(outbound_expiry)) {
-      MESH_DEBUG_PRINTLN("%s Dispatcher::loop(): WARNING: outbound packed send timed out!", getLogDateTime());
-
-      _radio->onSendFinished();
-      logTxFail(outbound, 2 + outbound->path_len + outbound->payload_len);
 
-      releasePacket(outbound);  // return to pool
-      outbound = NULL;
-    } else {
-      return;  // can't do any more radio activity until send is complete or timed out
+      // going back into receive mode now...
+      iface.next_agc_reset_time = futureMillis(getAGCResetInterval());
     }
 
-    // going back into receive mode now...
-    next_agc_reset_time = futureMillis(getAGCResetInterval());
-  }
-
-  if (getAGCResetInterval() > 0 && millisHasNowPassed(next_agc_reset_time)) {
-    _radio->resetAGC();
-    next_agc_reset_time = futureMillis(getAGCResetInterval());
+    if (getAGCResetInterval() > 0 && millisHasNowPassed(iface.next_agc_reset_time)) {
+      iface.radio->resetAGC();
+      iface.next_agc_reset_time = futureMillis(getAGCResetInterval());
+    }
   }
+  if (num_busy == _num_ifaces) return;   // all radios are mid-transmit
 
   // check inbound (delayed) queue
   {
@@ -104,19 +149,24 @@ void Dispatcher::loop() {
       processRecvPacket(pkt);
     }
   }
-  checkRecv();
-  checkSend();
+  for (int idx = 0; idx < _num_ifaces; idx++) {
+    if (_ifaces[idx].outbound == NULL) {
+      checkRecv(idx);
+      checkSend(idx);
+    }
+  }
 }
 
-void Dispatcher::checkRecv() {
+void Dispatcher::checkRecv(int idx) {
+  Radio* radio = _ifaces[idx].radio;
   Packet* pkt;
   float score;
   uint32_t air_time;
   {
     uint8_t raw[MAX_TRANS_UNIT+1];
-    int len = _radio->recvRaw(raw, MAX_TRANS_UNIT);
+    int len = radio->recvRaw(raw, MAX_TRANS_UNIT);
     if (len > 0) {
-      logRxRaw(_radio->getLastSNR(), _radio->getLastRSSI(), raw, len);
+      logRxRaw(radio->getLastSNR(), radio->getLastRSSI(), raw, len);
 
       pkt = _mgr->allocNew();
       if (pkt == NULL) {
@@ -155,10 +205,12 @@ void Dispatcher::checkRecv() {
             pkt = NULL;  
           } else {
             memcpy(pkt->payload, &raw[i], pkt->payload_len);
+            pkt->invalidateFingerprint();
 
-            pkt->_snr = _radio->getLastSNR() * 4.0f;
-            score = _radio->packetScore(_radio->getLastSNR(), len);
-            air_time = _radio->getEstAirtimeFor(len);
+            pkt->_snr = radio->getLastSNR() * 4.0f;
+            pkt->_iface_rx = idx;
+            score = radio->packetScore(radio->getLastSNR(), len);
+            air_time = radio->getEstAirtimeFor(len);
             rx_air_time += air_time;
           }
         }
@@ -172,7 +224,7 @@ void Dispatcher::checkRecv() {
     Serial.print(getLogDateTime());
     Serial.printf(": RX, len=%d (type=%d, route=%s, payload_len=%d) SNR=%d RSSI=%d score=%d time=%d", 
             pkt->getRawLength(), pkt->getPayloadType(), pkt->isRouteDirect() ? "D" : "F", pkt->payload_len,
-            (int)pkt->getSNR(), (int)_radio->getLastRSSI(), (int)(score*1000), air_time);
+            (int)pkt->getSNR(), (int)radio->getLastRSSI(), (int)(score*1000), air_time);
 
     static uint8_t packet_hash[MAX_HASH_SIZE];
     pkt->calculatePacketHash(packet_hash);
@@ -219,32 +271,56 @@ void Dispatcher::processRecvPacket(Packet* pkt) {
     uint8_t priority = (action >> 24) - 1;
     uint32_t _delay = action & 0xFFFFFF;
 
-    _mgr->queueOutbound(pkt, priority, futureMillis(_delay));
+    queueOutbound(pkt, priority, futureMillis(_delay));
+  }
+}
+
+void Dispatcher::queueOutbound(Packet* packet, uint8_t priority, uint32_t scheduled_for) {
+  // queue a copy for each (allowed) interface
+  Packet* first = packet;
+  for (int idx = 0; idx < _num_ifaces; idx++) {
+    if (!allowSendOn(first, idx)) continue;
+
+    if (packet == NULL) {
+      packet = _mgr->allocNew();
+      if (packet == NULL) {
+        _err_flags |= ERR_EVENT_FULL;
+        break;
+      }
+      *packet = *first;
+    }
+    packet->_iface_tx = idx;
+    _mgr->queueOutbound(packet, priority, scheduled_for);
+    packet = NULL;
+  }
+  if (packet) {   // not allowed on any interface
+    _mgr->free(packet);
   }
 }
 
-void Dispatcher::checkSend() {
+void Dispatcher::checkSend(int idx) {
+  auto& iface = _ifaces[idx];
   if (_mgr->getOutboundCount(_ms->getMillis()) == 0) return;  // nothing waiting to send
-  if (!millisHasNowPassed(next_tx_time)) return;   // still in 'radio silence' phase (from airtime budget setting)
-  if (_radio->isReceiving()) {   // LBT - check if radio is currently mid-receive, or if channel activity
-    if (cad_busy_start == 0) {
-      cad_busy_start = _ms->getMillis();   // record when CAD busy state started
+  if (!millisHasNowPassed(iface.next_tx_time)) return;   // still in 'radio silence' phase (from airtime budget setting)
+  if (iface.radio->isReceiving()) {   // LBT - check if radio is currently mid-receive, or if channel activity
+    if (iface.cad_busy_start == 0) {
+      iface.cad_busy_start = _ms->getMillis();   // record when CAD busy state started
     }
 
-    if (_ms->getMillis() - cad_busy_start > getCADFailMaxDuration()) {
+    if (_ms->getMillis() - iface.cad_busy_start > getCADFailMaxDuration()) {
       _err_flags |= ERR_EVENT_CAD_TIMEOUT;
 
       MESH_DEBUG_PRINTLN("%s Dispatcher::checkSend(): CAD busy max duration reached!", getLogDateTime());
       // channel activity has gone on too long... (Radio might be in a bad state)
       // force the pending transmit below...
     } else {
-      next_tx_time = futureMillis(getCADFailRetryDelay());
+      iface.next_tx_time = futureMillis(getCADFailRetryDelay());
       return;
     }
   }
-  cad_busy_start = 0;  // reset busy state
+  iface.cad_busy_start = 0;  // reset busy state
 
-  outbound = _mgr->getNextOutbound(_ms->getMillis());
+  Packet* outbound = _num_ifaces == 1 ? _mgr->getNextOutbound(_ms->getMillis()) : _mgr->getNextOutboundFor(_ms->getMillis(), idx);
   if (outbound) {
     int len = 0;
     uint8_t raw[MAX_TRANS_UNIT];
@@ -267,9 +343,9 @@ void Dispatcher::checkSend() {
     } else {
       memcpy(&raw[len], outbound->payload, outbound->payload_len); len += outbound->payload_len;
 
-      uint32_t max_airtime = _radio->getEstAirtimeFor(len)*3/2;
-      outbound_start = _ms->getMillis();
-      bool success = _radio->startSendRaw(raw, len);
+      uint32_t max_airtime = iface.radio->getEstAirtimeFor(len)*3/2;
+      iface.outbound_start = _ms->getMillis();
+      bool success = iface.radio->startSendRaw(raw, len);
       if (!success) {
         MESH_DEBUG_PRINTLN("%s Dispatcher::loop(): ERROR: send start failed!", getLogDateTime());
 
@@ -279,7 +355,8 @@ void Dispatcher::checkSend() {
         outbound = NULL;
         return;
       }
-      outbound_expiry = futureMillis(max_airtime);
+      iface.outbound = outbound;
+      iface.outbound_expiry = futureMillis(max_airtime);
 
     #if MESH_PACKET_LOGGING
       Serial.print(getLogDateTime());
@@ -303,6 +380,8 @@ Packet* Dispatcher::obtainNewPacket() {
   } else {
     pkt->payload_len = pkt->path_len = 0;
     pkt->_snr = 0;
+    pkt->_iface_rx = IFACE_NONE;
+    pkt->invalidateFingerprint();
   }
   return pkt;
 }
@@ -316,7 +395,7 @@ void Dispatcher::sendPacket(Packet* packet, uint8_t priority, uint32_t delay_mil
     MESH_DEBUG_PRINTLN("%s Dispatcher::sendPacket(): ERROR: invalid packet... path_len=%d, payload_len=%d", getLogDateTime(), (uint32_t) packet->path_len, (uint32_t) packet->payload_len);
     _mgr->free(packet);
   } else {
-    _mgr->queueOutbound(packet, priority, futureMillis(delay_millis));
+    queueOutbound(packet, priority, futureMillis(delay_millis));
   }
 }
 
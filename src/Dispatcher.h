@@ -38,6 +38,11 @@ public:
 
   virtual float packetScore(float snr, int packet_len) = 0;
 
+  /**
+   * \brief  a hook for re-calculating anything derived from the modulation params. (call after changing freq/bw/sf/cr)
+  */
+  virtual void onParamsChanged() { }
+
   /**
    * \brief  starts the raw packet send. (no wait)
    * \param  bytes   the raw packet data
@@ -89,6 +94,7 @@ public:
 
   virtual void queueOutbound(Packet* packet, uint8_t priority, uint32_t scheduled_for) = 0;
   virtual Packet* getNextOutbound(uint32_t now) = 0;    // by priority
+  virtual Packet* getNextOutboundFor(uint32_t now, uint8_t iface) { return getNextOutbound(now); }   // only those for given interface
   virtual int getOutboundCount(uint32_t now) const = 0;
   virtual int getFreeCount() const = 0;
   virtual Packet* getOutboundByIdx(int i) = 0;
@@ -108,40 +114,57 @@ typedef uint32_t  DispatcherAction;
 #define ERR_EVENT_CAD_TIMEOUT       (1 << 1)
 #define ERR_EVENT_STARTRX_TIMEOUT   (1 << 2)
 
+#ifndef CHANNEL_UTIL_WINDOW_MILLIS
+  #define CHANNEL_UTIL_WINDOW_MILLIS   30000   // sampling period for getChannelUtilisation()
+#endif
+
+#ifndef MAX_RADIO_INTERFACES
+  #define MAX_RADIO_INTERFACES   1    // eg. 2 for a LoRa + ESP-NOW gateway, or two LoRa radios
+#endif
+
 /**
  * \brief  The low-level task that manages detecting incoming Packets, and the queueing
  *      and scheduling of outbound Packets.
 */
 class Dispatcher {
-  Packet* outbound;  // current outbound packet
-  unsigned long outbound_expiry, outbound_start, total_air_time, rx_air_time;
-  unsigned long next_tx_time;
-  unsigned long cad_busy_start;
-  unsigned long radio_nonrx_start;
-  unsigned long next_floor_calib_time, next_agc_reset_time;
-  bool  prev_isrecv_mode;
+  struct RadioInterface {   // per-radio TX state, and airtime budget
+    Radio* radio;
+    Packet* outbound;  // current outbound packet
+    unsigned long outbound_expiry, outbound_start, total_air_time;
+    unsigned long next_tx_time;
+    unsigned long cad_busy_start;
+    unsigned long radio_nonrx_start;
+    unsigned long next_floor_calib_time, next_agc_reset_time;
+    bool  prev_isrecv_mode;
+  };
+  RadioInterface _ifaces[MAX_RADIO_INTERFACES];
+  int _num_ifaces;
+  unsigned long rx_air_time;
+  unsigned long util_window_start, util_busy_start;
+  uint8_t channel_util;
   uint32_t n_sent_flood, n_sent_direct;
   uint32_t n_recv_flood, n_recv_direct;
 
+  void initInterface(RadioInterface& iface, Radio* radio);
   void processRecvPacket(Packet* pkt);
+  void queueOutbound(Packet* packet, uint8_t priority, uint32_t scheduled_for);
+  void updateChannelUtil();
 
 protected:
   PacketManager* _mgr;
-  Radio* _radio;
+  Radio* _radio;    // the primary radio (interface 0)
   MillisecondClock* _ms;
   uint16_t _err_flags;
 
   Dispatcher(Radio& radio, MillisecondClock& ms, PacketManager& mgr)
     : _radio(&radio), _ms(&ms), _mgr(&mgr)
   {
-    outbound = NULL;
-    total_air_time = rx_air_time = 0;
-    next_tx_time = 0;
-    cad_busy_start = 0;
-    next_floor_calib_time = next_agc_reset_time = 0;
+    _num_ifaces = 1;
+    initInterface(_ifaces[0], &radio);
+    rx_air_time = 0;
+    util_window_start = util_busy_start = 0;
+    channel_util = 0;
     _err_flags = 0;
-    radio_nonrx_start = 0;
-    prev_isrecv_mode = true;
   }
 
   virtual DispatcherAction onRecvPacket(Packet* pkt) = 0;
@@ -160,7 +183,21 @@ protected:
   virtual int getInterferenceThreshold() const { return 0; }    // disabled by default
   virtual int getAGCResetInterval() const { return 0; }    // disabled by default
 
+  /**
+   * \brief  per-interface forwarding rule. Outbound packets are sent on every interface this allows.
+   *         (see Packet::_iface_rx for which interface a retransmitted packet was received on)
+   */
+  virtual bool allowSendOn(const Packet* packet, int iface) const { return true; }
+
 public:
+  /**
+   * \brief  adds another radio interface, sharing the packet pool, queues and tables of this node. (call before begin())
+   * \returns  the new interface index, or -1 if MAX_RADIO_INTERFACES exceeded
+   */
+  int addRadio(Radio& radio);
+  int getNumInterfaces() const { return _num_ifaces; }
+  Radio* getRadio(int iface) const { return _ifaces[iface].radio; }
+
   void begin();
   void loop();
 
@@ -168,8 +205,10 @@ public:
   void releasePacket(Packet* packet);
   void sendPacket(Packet* packet, uint8_t priority, uint32_t delay_millis=0);
 
-  unsigned long getTotalAirTime() const { return total_air_time; }  // in milliseconds
+  unsigned long getTotalAirTime() const { return _ifaces[0].total_air_time; }  // in milliseconds, of primary radio
+  unsigned long getTotalAirTime(int iface) const { return _ifaces[iface].total_air_time; }
   unsigned long getReceiveAirTime() const {return rx_air_time; }
+  uint8_t getChannelUtilisation() const { return channel_util; }   // percent of time busy (Tx + Rx), smoothed over last few windows
   uint32_t getNumSentFlood() const { return n_sent_flood; }
   uint32_t getNumSentDirect() const { return n_sent_direct; }
   uint32_t getNumRecvFlood() const { return n_recv_flood; }
@@ -184,8 +223,8 @@ public:
   unsigned long futureMillis(int millis_from_now) const;
 
 private:
-  void checkRecv();
-  void checkSend();
+  void checkRecv(int idx);
+  void checkSend(int idx);
 };
 
 }
@@ -15,11 +15,12 @@ Identity::Identity(const char* pub_hex) {
 }
 
 bool Identity::verify(const uint8_t* sig, const uint8_t* message, int msg_len) const {
-#if 0
-  // NOTE:  memory corruption bug was found in this function!!
-  return ed25519_verify(sig, message, msg_len, pub_key);
+#ifdef ED25519_RWEATHER_VERIFY
+  return Ed25519::verify(sig, this->pub_key, message, msg_len);   // fallback (slower, no S < L check)
 #else
-  return Ed25519::verify(sig, this->pub_key, message, msg_len);
+  // NOTE: memory corruption was once seen on-device with this, most likely from it needing ~3KB of stack. Its scratch is now
+  //   static (see ge_double_scalarmult_vartime()), so only verify from one task
+  return ed25519_verify(sig, message, msg_len, pub_key);
 #endif
 }
 
@@ -4,6 +4,10 @@
 namespace mesh {
 
 void Mesh::begin() {
+  uint8_t key[16];
+  _rng->random(key, sizeof(key));   // fingerprints used in duplicate tables are keyed per boot (can't be pre-computed by others)
+  Packet::setFingerprintKey(key);
+
   Dispatcher::begin();
 }
 
@@ -34,10 +38,15 @@ int Mesh::searchPeersByHash(const uint8_t* hash) {
   return 0;  // not found
 }
 
-int Mesh::searchChannelsByHash(const uint8_t* hash, GroupChannel channels[], int max_matches) {
+int Mesh::searchChannelsByHash(const uint8_t* hash) {
   return 0;  // not found
 }
 
+int Mesh::decryptGroupData(int channel_idx, uint8_t* dest, const uint8_t* src, int src_len) {
+  const GroupChannel* channel = getMatchingChannel(channel_idx);
+  return channel ? Utils::MACThenDecrypt(channel->secret, dest, src, src_len) : 0;
+}
+
 DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
   if (pkt->getPayloadVer() > PAYLOAD_VER_1) {  // not supported in this firmware version
     MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): unsupported packet version", getLogDateTime());
@@ -140,7 +149,7 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
       } else if (!_tables->hasSeen(pkt)) {
         // NOTE: this is a 'first packet wins' impl. When receiving from multiple paths, the first to arrive wins.
         //       For flood mode, the path may not be the 'best' in terms of hops.
-        // FUTURE: could send back multiple paths, using createPathReturn(), and let sender choose which to use(?)
+        //       Later copies (via other routes) are passed to onPeerFloodRepeat(), so alternative paths can be sent back.
 
         if (self_id.isHashMatch(&dest_hash)) {
           // scan contacts DB, for all matching hashes of 'src_hash' (max 4 matches supported ATM)
@@ -183,6 +192,8 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
           }
         }
         action = routeRecvPacket(pkt);
+      } else if (pkt->isRouteFlood() && self_id.isHashMatch(&dest_hash)) {
+        onPeerFloodRepeat(pkt);
       }
       break;
     }
@@ -222,16 +233,15 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
       if (i + 2 >= pkt->payload_len) {
         MESH_DEBUG_PRINTLN("%s Mesh::onRecvPacket(): incomplete data packet", getLogDateTime());
       } else if (!_tables->hasSeen(pkt)) {
-        // scan channels DB, for all matching hashes of 'channel_hash' (max 4 matches supported ATM)
-        GroupChannel channels[4];
-        int num = searchChannelsByHash(&channel_hash, channels, 4);
+        // scan channels DB, for all matching hashes of 'channel_hash'
+        int num = searchChannelsByHash(&channel_hash);
         // for each matching channel, try to decrypt data
         for (int j = 0; j < num; j++) {
           // decrypt, checking MAC is valid
           uint8_t data[MAX_PACKET_PAYLOAD];
-          int len = Utils::MACThenDecrypt(channels[j].secret, data, macAndData, pkt->payload_len - i);
+          int len = decryptGroupData(j, data, macAndData, pkt->payload_len - i);
           if (len > 0) {  // success!
-            onGroupDataRecv(pkt, pkt->getPayloadType(), channels[j], data, len);
+            onGroupDataRecv(pkt, pkt->getPayloadType(), *getMatchingChannel(j), data, len);
             break;
           }
         }
@@ -305,6 +315,27 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
             onAckRecv(&tmp, ack_crc);
             //action = routeRecvPacket(&tmp);  // NOTE: currently not needed, as multipart ACKs not sent Flood
           }
+        } else if ((type == MULTIPART_TYPE_BULK_DATA || type == MULTIPART_TYPE_BULK_ACK) && pkt->payload_len > 3 + CIPHER_MAC_SIZE) {
+          if (!_tables->hasSeen(pkt)) {
+            uint8_t dest_hash = pkt->payload[1];
+            uint8_t src_hash = pkt->payload[2];
+            if (self_id.isHashMatch(&dest_hash)) {
+              int num = searchPeersByHash(&src_hash);
+              for (int j = 0; j < num; j++) {
+                uint8_t secret[PUB_KEY_SIZE];
+                getPeerSharedSecret(secret, j);
+
+                uint8_t data[MAX_PACKET_PAYLOAD];
+                int len = Utils::MACThenDecrypt(secret, data, &pkt->payload[3], pkt->payload_len - 3);
+                if (len > 0) {  // success!
+                  onPeerMultipartRecv(pkt, type, j, secret, data, len);
+                  pkt->markDoNotRetransmit();
+                  break;
+                }
+              }
+            }
+            if (type == MULTIPART_TYPE_BULK_ACK) action = routeRecvPacket(pkt);   // these may be sent Flood (when no path back)
+          }
         } else {
           // FUTURE: other multipart types??
         }
@@ -362,6 +393,12 @@ DispatcherAction Mesh::forwardMultipartDirect(Packet* pkt) {
       removeSelfFromPath(&tmp);
       routeDirectRecvAcks(&tmp, ((uint32_t)remaining + 1) * 300);  // expect multipart ACKs 300ms apart (x2)
     }
+  } else if ((type == MULTIPART_TYPE_BULK_DATA || type == MULTIPART_TYPE_BULK_ACK) && !_tables->hasSeen(pkt)) {
+    // bulk transfer, forward as other direct traffic (other multipart types aren't forwarded)
+    removeSelfFromPath(pkt);
+
+    uint32_t d = getDirectRetransmitDelay(pkt);
+    return ACTION_RETRANSMIT_DELAYED(0, d);
   }
   return ACTION_RELEASE;
 }
@@ -576,6 +613,32 @@ Packet* Mesh::createMultiAck(uint32_t ack_crc, uint8_t remaining) {
   return packet;
 }
 
+Packet* Mesh::createMultipartDatagram(uint8_t type, const Identity& dest, const uint8_t* secret, const uint8_t* data, size_t data_len) {
+  if (type == MULTIPART_TYPE_BULK_DATA || type == MULTIPART_TYPE_BULK_ACK) {
+    size_t padded_len = (data_len + CIPHER_BLOCK_SIZE-1) / CIPHER_BLOCK_SIZE * CIPHER_BLOCK_SIZE;
+    if (3 + CIPHER_MAC_SIZE + padded_len > MAX_PACKET_PAYLOAD) return NULL;
+  } else {
+    return NULL;  // invalid type
+  }
+
+  Packet* packet = obtainNewPacket();
+  if (packet == NULL) {
+    MESH_DEBUG_PRINTLN("%s Mesh::createMultipartDatagram(): error, packet pool empty", getLogDateTime());
+    return NULL;
+  }
+  packet->header = (PAYLOAD_TYPE_MULTIPART << PH_TYPE_SHIFT);  // ROUTE_TYPE_* set later
+
+  int len = 0;
+  packet->payload[len++] = type;   // upper 4 bits ('remaining') not used
+  len += dest.copyHashTo(&packet->payload[len]);  // dest hash
+  len += self_id.copyHashTo(&packet->payload[len]);  // src hash
+  len += Utils::encryptThenMAC(secret, &packet->payload[len], data, data_len);
+
+  packet->payload_len = len;
+
+  return packet;
+}
+
 Packet* Mesh::createRawData(const uint8_t* data, size_t len) {
   if (len > sizeof(Packet::payload)) return NULL;  // invalid arg
 
@@ -14,6 +14,14 @@ public:
  * An abstraction of the data tables needed to be maintained
 */
 class MeshTables {
+protected:
+  /**
+   * \brief  the fingerprint used to detect duplicates. Default is the fast, keyed (per boot) Packet::getFingerprint().
+   *         Override to use Packet::calculatePacketHash() instead, if table entries need to be valid across reboots.
+   * \param  dest  must be MAX_HASH_SIZE bytes
+   */
+  virtual void calcFingerprint(const Packet* packet, uint8_t* dest) { packet->getFingerprint(dest); }
+
 public:
   virtual bool hasSeen(const Packet* packet) = 0;
   virtual void clear(const Packet* packet) = 0;   // remove this packet hash from table
@@ -93,6 +101,14 @@ protected:
   */
   virtual void onPeerDataRecv(Packet* packet, uint8_t type, int sender_idx, const uint8_t* secret, uint8_t* data, size_t len) { }
 
+  /**
+   * \brief  A (now decrypted) multipart packet has been received (by a known peer), eg. a bulk transfer fragment.
+   * \param  type  one of: MULTIPART_TYPE_BULK_DATA, MULTIPART_TYPE_BULK_ACK
+   * \param  sender_idx  index of peer, [0..n) where n is what searchPeersByHash() returned
+   * \param  secret   the pre-calculated shared-secret (handy for sending response packet)
+  */
+  virtual void onPeerMultipartRecv(Packet* packet, uint8_t type, int sender_idx, const uint8_t* secret, uint8_t* data, size_t len) { }
+
   /**
    * \brief  A TRACE packet has been received. (and has reached the end of its given path)
    *         NOTE: this may have been initiated by another node.
@@ -114,6 +130,13 @@ protected:
   */
   virtual bool onPeerPathRecv(Packet* packet, int sender_idx, const uint8_t* secret, uint8_t* path, uint8_t path_len, uint8_t extra_type, uint8_t* extra, uint8_t extra_len) { return false; }
 
+  /**
+   * \brief  A flood data/path packet addressed to this node, which has already been received (and processed), has
+   *         now arrived again via another route (see packet->path). Not decrypted, use packet fingerprint to match.
+   *         Can be used to collect alternative paths from the sender.
+  */
+  virtual void onPeerFloodRepeat(Packet* packet) { }
+
   /**
    * \brief  A new incoming Advertisement has been received.
    *         NOTE: these can be received multiple times (per id/timestamp), via different routes
@@ -146,10 +169,22 @@ protected:
 
   /**
    * \brief  Perform search of local DB of matching GroupChannels.
-   * \param  channels  OUT - store matching channels in this array, up to max_matches
    * \returns  Number of channels with matching hash
    */
-  virtual int searchChannelsByHash(const uint8_t* hash, GroupChannel channels[], int max_matches);
+  virtual int searchChannelsByHash(const uint8_t* hash);
+
+  /**
+   * \param  channel_idx  index of channel, [0..n) where n is what searchChannelsByHash() returned
+   */
+  virtual const GroupChannel* getMatchingChannel(int channel_idx) { return NULL; }
+
+  /**
+   * \brief  check MAC of, and decrypt group data with channel (by idx). Default is Utils::MACThenDecrypt() with
+   *         the channel's secret, override to eg. use cached key schedules.
+   * \param  channel_idx  index of channel, [0..n) where n is what searchChannelsByHash() returned
+   * \returns  length of decrypted data, or zero if MAC doesn't match
+   */
+  virtual int decryptGroupData(int channel_idx, uint8_t* dest, const uint8_t* src, int src_len);
 
   /**
    * \brief  An encrypted group data packet has been received.
@@ -187,6 +222,7 @@ public:
   Packet* createGroupDatagram(uint8_t type, const GroupChannel& channel, const uint8_t* data, size_t data_len);
   Packet* createAck(uint32_t ack_crc);
   Packet* createMultiAck(uint32_t ack_crc, uint8_t remaining);
+  Packet* createMultipartDatagram(uint8_t type, const Identity& dest, const uint8_t* secret, const uint8_t* data, size_t len);
   Packet* createPathReturn(const uint8_t* dest_hash, const uint8_t* secret, const uint8_t* path, uint8_t path_len, uint8_t extra_type, const uint8_t*extra, size_t extra_len);
   Packet* createPathReturn(const Identity& dest, const uint8_t* secret, const uint8_t* path, uint8_t path_len, uint8_t extra_type, const uint8_t*extra, size_t extra_len);
   Packet* createRawData(const uint8_t* data, size_t len);
@@ -1,13 +1,20 @@
 #include "Packet.h"
 #include <string.h>
 #include <SHA256.h>
+#include "Utils.h"
 
 namespace mesh {
 
+static uint8_t fingerprint_key[16];
+static uint8_t fingerprint_key_gen = 0;   // bumped each time key changes, so cached fingerprints are stale
+
 Packet::Packet() {
   header = 0;
   path_len = 0;
   payload_len = 0;
+  _iface_rx = _iface_tx = IFACE_NONE;
+  _fp_tag = 0xFFFFFFFF;
+  _fp_key_gen = 0;
 }
 
 int Packet::getRawLength() const {
@@ -25,6 +32,33 @@ void Packet::calculatePacketHash(uint8_t* hash) const {
   sha.finalize(hash, MAX_HASH_SIZE);
 }
 
+void Packet::setFingerprintKey(const uint8_t* key) {
+  memcpy(fingerprint_key, key, sizeof(fingerprint_key));
+  fingerprint_key_gen++;
+}
+
+const uint8_t* Packet::getFingerprintKey() {
+  return fingerprint_key;
+}
+
+void Packet::getFingerprint(uint8_t* hash) const {
+  uint8_t t = getPayloadType();
+  uint32_t tag = ((uint32_t)t << 24) | ((uint32_t)path_len << 16) | payload_len;
+  if (tag != _fp_tag || _fp_key_gen != fingerprint_key_gen) {
+    uint8_t prefix[1 + sizeof(path_len)];
+    int prefix_len = 0;
+    prefix[prefix_len++] = t;
+    if (t == PAYLOAD_TYPE_TRACE) {
+      memcpy(&prefix[prefix_len], &path_len, sizeof(path_len)); prefix_len += sizeof(path_len);   // CAVEAT: TRACE packets can revisit same node on return path
+    }
+    uint64_t h = Utils::sipHash(fingerprint_key, prefix, prefix_len, payload, payload_len);
+    memcpy(_fingerprint, &h, MAX_HASH_SIZE);
+    _fp_tag = tag;
+    _fp_key_gen = fingerprint_key_gen;
+  }
+  memcpy(hash, _fingerprint, MAX_HASH_SIZE);
+}
+
 uint8_t Packet::writeTo(uint8_t dest[]) const {
   uint8_t i = 0;
   dest[i++] = header;
@@ -54,6 +88,7 @@ bool Packet::readFrom(const uint8_t src[], uint8_t len) {
   payload_len = len - i;
   if (payload_len > sizeof(payload)) return false;  // bad encoding
   memcpy(payload, &src[i], payload_len); //i += payload_len;
+  invalidateFingerprint();
   return true;   // success
 }
 
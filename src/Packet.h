@@ -31,15 +31,25 @@ namespace mesh {
 //...
 #define PAYLOAD_TYPE_RAW_CUSTOM   0x0F    // custom packet as raw bytes, for applications with custom encryption, payloads, etc
 
+// PAYLOAD_TYPE_MULTIPART sub-types (lower 4 bits of payload[0]), besides PAYLOAD_TYPE_ACK
+#define MULTIPART_TYPE_BULK_DATA   0x0C    // bulk transfer fragment (prefixed with dest/src hashes, MAC) (enc data: see BulkTransfer.h)
+#define MULTIPART_TYPE_BULK_ACK    0x0D    // bulk transfer selective ACK (prefixed with dest/src hashes, MAC)
+
 #define PAYLOAD_VER_1       0x00   // 1-byte src/dest hashes, 2-byte MAC
 #define PAYLOAD_VER_2       0x01   // FUTURE (eg. 2-byte hashes, 4-byte MAC ??)
 #define PAYLOAD_VER_3       0x02   // FUTURE
 #define PAYLOAD_VER_4       0x03   // FUTURE
 
+#define IFACE_NONE    0xFF    // for Packet::_iface_rx
+
 /**
  * \brief  The fundamental transmission unit.
 */
 class Packet {
+  mutable uint8_t _fingerprint[MAX_HASH_SIZE];
+  mutable uint32_t _fp_tag;     // type, path_len and payload_len that _fingerprint was calculated for
+  mutable uint8_t _fp_key_gen;  // fingerprint key it was calculated with (see setFingerprintKey())
+
 public:
   Packet();
 
@@ -49,6 +59,8 @@ public:
   uint8_t path[MAX_PATH_SIZE];
   uint8_t payload[MAX_PACKET_PAYLOAD];
   int8_t _snr;
+  uint8_t _iface_rx;   // radio interface received on (IFACE_NONE if created locally)
+  uint8_t _iface_tx;   // radio interface to send on (when queued)
 
   /**
    * \brief calculate the hash of payload + type
@@ -56,6 +68,26 @@ public:
    */
   void calculatePacketHash(uint8_t* dest_hash) const;
 
+  /**
+   * \brief  fast, keyed fingerprint of payload + type (same inputs as calculatePacketHash()), for LOCAL duplicate
+   *         detection only. Keys are random per boot, so must NOT be shown/sent to other nodes. Is cached, until
+   *         type, path_len or payload_len changes, or invalidateFingerprint() called.
+   * \param  dest_hash   destination to store the fingerprint (must be MAX_HASH_SIZE bytes)
+   */
+  void getFingerprint(uint8_t* dest_hash) const;
+
+  /**
+   * \brief  must be called if the payload is re-written in place (ie. packet re-used)
+   */
+  void invalidateFingerprint() { _fp_tag = 0xFFFFFFFF; }
+
+  /**
+   * \brief  sets the (16 byte) key used by getFingerprint(), for ALL packets. Any cached fingerprints are then
+   *         re-calculated with the new key.
+   */
+  static void setFingerprintKey(const uint8_t* key);
+  static const uint8_t* getFingerprintKey();
+
   /**
    * \returns  one of ROUTE_ values
    */
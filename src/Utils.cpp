@@ -27,6 +27,42 @@ void Utils::sha256(uint8_t *hash, size_t hash_len, const uint8_t* frag1, int fra
   sha.finalize(hash, hash_len);
 }
 
+#define ROTL64(x, b)  (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND  do { \
+    v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; v0 = ROTL64(v0, 32); \
+    v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; v2 = ROTL64(v2, 32); \
+  } while (0)
+
+uint64_t Utils::sipHash(const uint8_t* key, const uint8_t* frag1, int frag1_len, const uint8_t* frag2, int frag2_len) {
+  uint64_t k0, k1;
+  memcpy(&k0, key, 8);      // NOTE: all supported MCUs are little-endian
+  memcpy(&k1, &key[8], 8);
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+  int total = frag1_len + frag2_len;
+  uint64_t m = 0;
+  for (int i = 0; i < total; i++) {
+    uint8_t b = i < frag1_len ? frag1[i] : frag2[i - frag1_len];
+    m |= ((uint64_t) b) << (8 * (i & 7));
+    if ((i & 7) == 7) {
+      v3 ^= m; SIPROUND; SIPROUND; v0 ^= m;
+      m = 0;
+    }
+  }
+  m |= ((uint64_t) total) << 56;   // final block: remaining bytes + length
+  v3 ^= m; SIPROUND; SIPROUND; v0 ^= m;
+
+  v2 ^= 0xFF;
+  SIPROUND; SIPROUND; SIPROUND; SIPROUND;
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
 int Utils::decrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
   AES128 aes;
   uint8_t* dp = dest;
@@ -28,6 +28,12 @@ public:
   */
   static void sha256(uint8_t *hash, size_t hash_len, const uint8_t* frag1, int frag1_len, const uint8_t* frag2, int frag2_len);
 
+  /**
+   * \brief  calculates the SipHash-2-4 (64-bit) of two fragments, 'frag1' and 'frag2' (in that order), with 16 byte 'key'.
+   *         Much faster than sha256(), but only suitable for local use (eg. hash tables), where 'key' is kept secret.
+  */
+  static uint64_t sipHash(const uint8_t* key, const uint8_t* frag1, int frag1_len, const uint8_t* frag2, int frag2_len);
+
   /**
    * \brief  Encrypts the 'src' bytes using AES128 cipher, using 'shared_secret' as key, with key length fixed at CIPHER_KEY_SIZE.
    *         Final block is padded with zero bytes before encrypt. Result stored in 'dest'.
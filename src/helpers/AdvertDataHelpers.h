@@ -12,10 +12,13 @@
 //FUTURE: 5..15
 
 #define ADV_LATLON_MASK       0x10
-#define ADV_FEAT1_MASK        0x20   // FUTURE
+#define ADV_FEAT1_MASK        0x20   // has ADV_FEAT1_* bits
 #define ADV_FEAT2_MASK        0x40   // FUTURE
 #define ADV_NAME_MASK         0x80
 
+// feature 1 bits
+#define ADV_FEAT1_TXT_COMPRESS  0x0001   // understands TXT_TYPE_COMPRESSED
+
 class AdvertDataBuilder {
   uint8_t _type;
   bool _has_loc;
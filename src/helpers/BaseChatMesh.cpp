@@ -1,4 +1,5 @@
 #include <helpers/BaseChatMesh.h>
+#include <helpers/TextCompressor.h>
 #include <Utils.h>
 
 #ifndef SERVER_RESPONSE_DELAY
@@ -9,6 +10,35 @@
   #define TXT_ACK_DELAY     200
 #endif
 
+#define ALT_PATH_WINDOW_MILLIS   8000   // how long after a flood msg its repeats can yield alternative paths
+#define ALT_PATH_RETURN_DELAY    1000
+
+#define KEEP_ALIVE_MAX_RETRIES   4   // early re-sends of an unACKed KEEP_ALIVE, before waiting the full interval
+
+// if compressing the text at data[5] saves at least one cipher block on air, replaces it, and returns new length
+static int compactText(uint8_t* data, int len) {
+  uint8_t packed[MAX_TEXT_LEN];
+  int n = TextCompressor::compress((const char *) &data[5], len - 5, packed, sizeof(packed));
+  if (n == 0 || (5 + n + CIPHER_BLOCK_SIZE-1) / CIPHER_BLOCK_SIZE >= (len + CIPHER_BLOCK_SIZE-1) / CIPHER_BLOCK_SIZE) {
+    return len;   // not worth it
+  }
+  memcpy(&data[5], packed, n);
+  data[4] = (data[4] & 3) | (TXT_TYPE_COMPRESSED << 2);
+  return 5 + n;
+}
+
+// replaces compressed text at data[5] with the plain text, and makes data[4] TXT_TYPE_PLAIN
+static bool expandText(uint8_t* data, size_t& len) {
+  char text[MAX_TEXT_LEN+1];
+  int n = TextCompressor::decompress(&data[5], len - 5, text, sizeof(text));
+  if (n < 0) return false;
+
+  memcpy(&data[5], text, n + 1);
+  data[4] &= 3;   // as TXT_TYPE_PLAIN, keeping attempt
+  len = 5 + n;
+  return true;
+}
+
 void BaseChatMesh::sendFloodScoped(const ContactInfo& recipient, mesh::Packet* pkt, uint32_t delay_millis) {
   sendFlood(pkt, delay_millis);
 }
@@ -21,6 +51,7 @@ mesh::Packet* BaseChatMesh::createSelfAdvert(const char* name) {
   uint8_t app_data_len;
   {
     AdvertDataBuilder builder(ADV_TYPE_CHAT, name);
+    builder.setFeat1(ADV_FEAT1_TXT_COMPRESS);
     app_data_len = builder.encodeTo(app_data);
   }
 
@@ -32,6 +63,7 @@ mesh::Packet* BaseChatMesh::createSelfAdvert(const char* name, double lat, doubl
   uint8_t app_data_len;
   {
     AdvertDataBuilder builder(ADV_TYPE_CHAT, name, lat, lon);
+    builder.setFeat1(ADV_FEAT1_TXT_COMPRESS);
     app_data_len = builder.encodeTo(app_data);
   }
 
@@ -99,6 +131,7 @@ void BaseChatMesh::populateContactFromAdvert(ContactInfo& ci, const mesh::Identi
     ci.gps_lat = parser.getIntLat();
     ci.gps_lon = parser.getIntLon();
   }
+  ci.adv_feat1 = parser.getFeat1();
   ci.last_advert_timestamp = timestamp;
   ci.lastmod = getRTCClock()->getCurrentTime();
 }
@@ -163,6 +196,7 @@ void BaseChatMesh::onAdvertRecv(mesh::Packet* packet, const mesh::Identity& id,
       from->gps_lat = parser.getIntLat();
       from->gps_lon = parser.getIntLon();
     }
+    from->adv_feat1 = parser.getFeat1();
     from->last_advert_timestamp = timestamp;
     from->lastmod = getRTCClock()->getCurrentTime();
 
@@ -197,6 +231,8 @@ void BaseChatMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender
 
   ContactInfo& from = contacts[i];
 
+  if (packet->isRouteFlood()) trackFloodRecv(from, packet);
+
   if (type == PAYLOAD_TYPE_TXT_MSG && len > 5) {
     uint32_t timestamp;
     memcpy(&timestamp, data, 4);  // timestamp (by sender's RTC clock - which could be wrong)
@@ -205,6 +241,15 @@ void BaseChatMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender
     // len can be > original length, but 'text' will be padded with zeroes
     data[len] = 0; // need to make a C string again, with null terminator
 
+    if (flags == TXT_TYPE_COMPRESSED) {   // expand, then handle (and ACK) as the plain text msg it was composed from
+      if (!expandText(data, len)) {
+        MESH_DEBUG_PRINTLN("onPeerDataRecv: invalid compressed text");
+        return;
+      }
+      flags = TXT_TYPE_PLAIN;
+      from.adv_feat1 |= ADV_FEAT1_TXT_COMPRESS;   // evidently understands it, even if advert not heard since reboot
+    }
+
     if (flags == TXT_TYPE_PLAIN) {
       from.lastmod = getRTCClock()->getCurrentTime(); // update last heard time
       onMessageRecv(from, packet, timestamp, (const char *) &data[5]);  // let UI know
@@ -289,20 +334,33 @@ bool BaseChatMesh::onPeerPathRecv(mesh::Packet* packet, int sender_idx, const ui
 
   ContactInfo& from = contacts[i];
 
+  if (packet->isRouteFlood()) trackFloodRecv(from, packet);
+
   return onContactPathRecv(from, packet->path, packet->path_len, path, path_len, extra_type, extra, extra_len);
 }
 
 bool BaseChatMesh::onContactPathRecv(ContactInfo& from, uint8_t* in_path, uint8_t in_path_len, uint8_t* out_path, uint8_t out_path_len, uint8_t extra_type, uint8_t* extra, uint8_t extra_len) {
-  // NOTE: default impl, we just replace the current 'out_path' regardless, whenever sender sends us a new out_path.
-  // FUTURE: could store multiple out_paths per contact, and try to find which is the 'best'(?)
-  memcpy(from.out_path, out_path, from.out_path_len = out_path_len);  // store a copy of path, for sendDirect()
+  // NOTE: default impl, add to candidate paths for this contact, and switch to whichever is now the 'best'
+  unsigned long now = _ms->getMillis();
+  uint8_t prev_path[MAX_PATH_SIZE];
+  int8_t prev_path_len = from.out_path_len;
+  if (prev_path_len > 0) memcpy(prev_path, from.out_path, prev_path_len);
+
+  _paths.addPath(from.id.pub_key, out_path, out_path_len, now);
+  from.out_path_len = _paths.selectBest(from.id.pub_key, from.out_path, now);   // store a copy of path, for sendDirect()
+  if (from.out_path_len < 0) {
+    memcpy(from.out_path, out_path, from.out_path_len = out_path_len);
+  }
+  if (from.out_path_len != prev_path_len || memcmp(from.out_path, prev_path, from.out_path_len) != 0) {
+    from.rtt = _paths.getRTT(from.id.pub_key, from.out_path, from.out_path_len);   // round trips of previous path no longer relevant
+  }
   from.lastmod = getRTCClock()->getCurrentTime();
 
   onContactPathUpdated(from);
 
   if (extra_type == PAYLOAD_TYPE_ACK && extra_len >= 4) {
     // also got an encoded ACK!
-    if (processAck(extra) != NULL) {
+    if (processOutboundAck(extra) == NULL && processAck(extra) != NULL) {
       txt_send_timeout = 0;   // matched one we're waiting for, cancel timeout timer
     }
   } else if (extra_type == PAYLOAD_TYPE_RESPONSE && extra_len > 0) {
@@ -312,9 +370,16 @@ bool BaseChatMesh::onContactPathRecv(ContactInfo& from, uint8_t* in_path, uint8_
 }
 
 void BaseChatMesh::onAckRecv(mesh::Packet* packet, uint32_t ack_crc) {
-  ContactInfo* from;
-  if ((from = processAck((uint8_t *)&ack_crc)) != NULL) {
+  ContactInfo* from = processOutboundAck((uint8_t *)&ack_crc);
+  if (from == NULL && (from = processAck((uint8_t *)&ack_crc)) != NULL) {
     txt_send_timeout = 0;   // matched one we're waiting for, cancel timeout timer
+
+    if (txt_send_direct && from->out_path_len >= 0 && memcmp(from->id.pub_key, txt_send_dest, sizeof(txt_send_dest)) == 0) {
+      onDirectRoundTrip(*from, _ms->getMillis() - txt_sent_millis);
+      txt_send_direct = false;
+    }
+  }
+  if (from) {
     packet->markDoNotRetransmit();   // ACK was for this node, so don't retransmit
 
     if (packet->isRouteFlood() && from->out_path_len >= 0) {
@@ -324,6 +389,40 @@ void BaseChatMesh::onAckRecv(mesh::Packet* packet, uint32_t ack_crc) {
   }
 }
 
+void BaseChatMesh::trackFloodRecv(const ContactInfo& from, mesh::Packet* packet) {
+  packet->getFingerprint(alt_fingerprint);
+  memcpy(alt_sender, from.id.pub_key, sizeof(alt_sender));
+  alt_first_path_len = packet->path_len;
+  alt_paths_sent = 0;
+  alt_path_expiry = futureMillis(ALT_PATH_WINDOW_MILLIS);
+}
+
+void BaseChatMesh::onPeerFloodRepeat(mesh::Packet* packet) {
+  if (alt_path_expiry == 0 || millisHasNowPassed(alt_path_expiry) || alt_paths_sent >= MAX_ALT_PATH_RETURNS) return;
+
+  // NOTE: older firmware just uses the most recent PATH received, so only offer alternatives which are no longer
+  if (packet->path_len > alt_first_path_len) return;
+
+  uint8_t fp[MAX_HASH_SIZE];
+  packet->getFingerprint(fp);
+  if (memcmp(fp, alt_fingerprint, MAX_HASH_SIZE) != 0) return;   // not the last flood msg we received
+
+  ContactInfo* from = lookupContactByPubKey(alt_sender, sizeof(alt_sender));
+  if (from == NULL || from->out_path_len < 0) return;   // only worth it if can be sent DIRECT
+
+  mesh::Packet* rpath = createPathReturn(from->id, from->getSharedSecret(self_id), packet->path, packet->path_len, 0, NULL, 0);
+  if (rpath) {
+    sendDirect(rpath, from->out_path, from->out_path_len, ALT_PATH_RETURN_DELAY + 500*alt_paths_sent);
+    alt_paths_sent++;
+  }
+}
+
+void BaseChatMesh::onTraceRecv(mesh::Packet* packet, uint32_t tag, uint32_t auth_code, uint8_t flags, const uint8_t* path_snrs, const uint8_t* path_hashes, uint8_t path_len) {
+  if ((flags & 0x03) == 0) {   // 1 byte path hashes, same as out_paths
+    _paths.onTraceResult(path_hashes, path_len, (const int8_t *) path_snrs);
+  }
+}
+
 void BaseChatMesh::handleReturnPathRetry(const ContactInfo& contact, const uint8_t* path, uint8_t path_len) {
   // NOTE: simplest impl is just to re-send a reciprocal return path to sender (DIRECTLY)
   //        override this method in various firmwares, if there's a better strategy
@@ -332,26 +431,46 @@ void BaseChatMesh::handleReturnPathRetry(const ContactInfo& contact, const uint8
 }
 
 #ifdef MAX_GROUP_CHANNELS
-int BaseChatMesh::searchChannelsByHash(const uint8_t* hash, mesh::GroupChannel dest[], int max_matches) {
+int BaseChatMesh::searchChannelsByHash(const uint8_t* hash) {
   int n = 0;
-  for (int i = 0; i < MAX_GROUP_CHANNELS && n < max_matches; i++) {
+  for (int i = channel_buckets[hash[0] & (CHANNEL_HASH_BUCKETS-1)]; i >= 0; i = channel_next[i]) {
     if (channels[i].channel.hash[0] == hash[0]) {
-      dest[n++] = channels[i].channel;
+      matching_channel_indexes[n++] = i;  // store the INDEXES of matching channels (for subsequent 'channel' methods)
     }
   }
   return n;
 }
+
+const mesh::GroupChannel* BaseChatMesh::getMatchingChannel(int channel_idx) {
+  return &channels[matching_channel_indexes[channel_idx]].channel;
+}
+
+int BaseChatMesh::decryptGroupData(int channel_idx, uint8_t* dest, const uint8_t* src, int src_len) {
+  int i = matching_channel_indexes[channel_idx];
+  int len = channel_keys.MACThenDecrypt(i, channels[i].channel.secret, dest, src, src_len);
+  if (len > 0) {
+    channel_stats[i].hits++;
+  } else {
+    channel_stats[i].misses++;
+  }
+  return len;
+}
 #endif
 
 void BaseChatMesh::onGroupDataRecv(mesh::Packet* packet, uint8_t type, const mesh::GroupChannel& channel, uint8_t* data, size_t len) {
-  uint8_t txt_type = data[4];
-  if (type == PAYLOAD_TYPE_GRP_TXT && len > 5 && (txt_type >> 2) == 0) {  // 0 = plain text msg
+  uint8_t txt_type = data[4] >> 2;
+  if (type == PAYLOAD_TYPE_GRP_TXT && len > 5 && (txt_type == TXT_TYPE_PLAIN || txt_type == TXT_TYPE_COMPRESSED)) {
     uint32_t timestamp;
     memcpy(&timestamp, data, 4);
 
     // len can be > original length, but 'text' will be padded with zeroes
     data[len] = 0; // need to make a C string again, with null terminator
 
+    if (txt_type == TXT_TYPE_COMPRESSED && !expandText(data, len)) {
+      MESH_DEBUG_PRINTLN("onGroupDataRecv: invalid compressed text");
+      return;
+    }
+
     // notify UI  of this new message
     onChannelMessageRecv(channel, packet, timestamp, (const char *) &data[5]);  // let UI know
   }
@@ -374,6 +493,8 @@ mesh::Packet* BaseChatMesh::composeMsgPacket(const ContactInfo& recipient, uint3
   if (attempt > 3) {
     temp[len++] = 0;  // null terminator
     temp[len++] = attempt;  // hide attempt number at tail end of payload
+  } else if (recipient.adv_feat1 & ADV_FEAT1_TXT_COMPRESS) {
+    len = compactText(temp, len);   // NOTE: expected_ack is still of the plain text
   }
 
   return createDatagram(PAYLOAD_TYPE_TXT_MSG, recipient.id, recipient.getSharedSecret(self_id), temp, len);
@@ -392,9 +513,10 @@ int  BaseChatMesh::sendMessage(const ContactInfo& recipient, uint32_t timestamp,
     rc = MSG_SEND_SENT_FLOOD;
   } else {
     sendDirect(pkt, recipient.out_path, recipient.out_path_len);
-    txt_send_timeout = futureMillis(est_timeout = calcDirectTimeoutMillisFor(t, recipient.out_path_len));
+    txt_send_timeout = futureMillis(est_timeout = calcDirectTimeoutFor(recipient, t));
     rc = MSG_SEND_SENT_DIRECT;
   }
+  trackMsgSend(recipient, rc == MSG_SEND_SENT_DIRECT);
   return rc;
 }
 
@@ -418,9 +540,10 @@ int  BaseChatMesh::sendCommandData(const ContactInfo& recipient, uint32_t timest
     rc = MSG_SEND_SENT_FLOOD;
   } else {
     sendDirect(pkt, recipient.out_path, recipient.out_path_len);
-    txt_send_timeout = futureMillis(est_timeout = calcDirectTimeoutMillisFor(t, recipient.out_path_len));
+    txt_send_timeout = futureMillis(est_timeout = calcDirectTimeoutFor(recipient, t));
     rc = MSG_SEND_SENT_DIRECT;
   }
+  trackMsgSend(recipient, rc == MSG_SEND_SENT_DIRECT);
   return rc;
 }
 
@@ -437,7 +560,10 @@ bool BaseChatMesh::sendGroupMessage(uint32_t timestamp, mesh::GroupChannel& chan
   memcpy(ep, text, text_len);
   ep[text_len] = 0;  // null terminator
 
-  auto pkt = createGroupDatagram(PAYLOAD_TYPE_GRP_TXT, channel, temp, 5 + prefix_len + text_len);
+  int len = 5 + prefix_len + text_len;
+  if (shouldCompressGroupText(channel)) len = compactText(temp, len);
+
+  auto pkt = createGroupDatagram(PAYLOAD_TYPE_GRP_TXT, channel, temp, len);
   if (pkt) {
     sendFloodScoped(channel, pkt);
     return true;
@@ -609,6 +735,7 @@ bool BaseChatMesh::startConnection(const ContactInfo& contact, uint16_t keep_ali
   uint32_t interval = connections[use_idx].keep_alive_millis = ((uint32_t)keep_alive_secs)*1000;
   connections[use_idx].next_ping = futureMillis(interval);
   connections[use_idx].expected_ack = 0;
+  connections[use_idx].ping_retries = 0;
   connections[use_idx].last_activity = getRTCClock()->getCurrentTime();
   return true;  // success
 }
@@ -639,6 +766,7 @@ void BaseChatMesh::markConnectionActive(const ContactInfo& contact) {
 
       // re-schedule next KEEP_ALIVE, now that we have heard from server
       connections[i].next_ping = futureMillis(connections[i].keep_alive_millis);
+      connections[i].ping_retries = 0;
       break;
     }
   }
@@ -653,9 +781,14 @@ ContactInfo* BaseChatMesh::checkConnectionsAck(const uint8_t* data) {
 
       // re-schedule next KEEP_ALIVE, now that we have heard from server
       connections[i].next_ping = futureMillis(connections[i].keep_alive_millis);
+      connections[i].ping_retries = 0;
 
       auto id = &connections[i].server_id;
-      return lookupContactByPubKey(id->pub_key, PUB_KEY_SIZE);  // yes, a match
+      ContactInfo* contact = lookupContactByPubKey(id->pub_key, PUB_KEY_SIZE);  // yes, a match
+      if (contact && contact->out_path_len >= 0) {
+        onDirectRoundTrip(*contact, _ms->getMillis() - connections[i].ping_sent);   // KEEP_ALIVEs are always sent direct
+      }
+      return contact;
     }
   }
   return NULL;  /// no match
@@ -698,19 +831,68 @@ void BaseChatMesh::checkConnections() {
       // calc expected ACK reply
       mesh::Utils::sha256((uint8_t *)&connections[i].expected_ack, 4, data, 9, self_id.pub_key, PUB_KEY_SIZE);
 
+      uint32_t interval = connections[i].keep_alive_millis;
       auto pkt = createDatagram(PAYLOAD_TYPE_REQ, contact->id, contact->getSharedSecret(self_id), data, 9);
       if (pkt) {
+        if (contact->rtt.hasSamples() && connections[i].ping_retries < KEEP_ALIVE_MAX_RETRIES) {
+          // re-send (backing off) once the ACK is overdue, rather than a whole interval later
+          uint32_t t = calcDirectTimeoutFor(*contact, _radio->getEstAirtimeFor(pkt->getRawLength())) << connections[i].ping_retries;
+          if (t < interval) interval = t;
+          connections[i].ping_retries++;
+        }
         sendDirect(pkt, contact->out_path, contact->out_path_len);
       }
-    
+      connections[i].ping_sent = _ms->getMillis();
+
       // schedule next KEEP_ALIVE
-      connections[i].next_ping = futureMillis(connections[i].keep_alive_millis);
+      connections[i].next_ping = futureMillis(interval);
     }
   }
 }
 
 void BaseChatMesh::resetPathTo(ContactInfo& recipient) {
   recipient.out_path_len = -1;
+  recipient.rtt.reset();
+  _paths.forget(recipient.id.pub_key);
+}
+
+void BaseChatMesh::trackMsgSend(const ContactInfo& recipient, bool direct) {
+  memcpy(txt_send_dest, recipient.id.pub_key, sizeof(txt_send_dest));
+  txt_sent_millis = _ms->getMillis();
+  txt_send_direct = direct;
+}
+
+void BaseChatMesh::failOverPath() {
+  txt_send_direct = false;
+
+  ContactInfo* c = lookupContactByPubKey(txt_send_dest, sizeof(txt_send_dest));
+  if (c && c->out_path_len >= 0) switchToNextPath(*c);
+}
+
+void BaseChatMesh::switchToNextPath(ContactInfo& c) {
+  uint8_t path[MAX_PATH_SIZE];
+  int path_len = _paths.onFailure(c.id.pub_key, c.out_path, c.out_path_len, path, _ms->getMillis());
+  // NOTE: if no other candidates, leave out_path as-is (up to app, or the outbound msg retries, to reset path and flood)
+  if (path_len >= 0 && (path_len != c.out_path_len || memcmp(path, c.out_path, path_len) != 0)) {
+    MESH_DEBUG_PRINTLN("switchToNextPath(): switching to alternative path, path_len=%d", path_len);
+    memcpy(c.out_path, path, c.out_path_len = path_len);
+    c.rtt = _paths.getRTT(c.id.pub_key, c.out_path, c.out_path_len);
+    onContactPathUpdated(c);
+  }
+}
+
+void BaseChatMesh::onDirectRoundTrip(ContactInfo& contact, uint32_t rtt_millis) {
+  _paths.onSuccess(contact.id.pub_key, contact.out_path, contact.out_path_len, rtt_millis, _ms->getMillis());
+  contact.rtt.addSample(rtt_millis);
+}
+
+uint32_t BaseChatMesh::calcDirectTimeoutFor(const ContactInfo& recipient, uint32_t pkt_airtime_millis) const {
+  if (!recipient.rtt.hasSamples()) {
+    return calcDirectTimeoutMillisFor(pkt_airtime_millis, recipient.out_path_len);   // static estimate, until measured
+  }
+  uint32_t t = recipient.rtt.getTimeout();
+  uint32_t min_t = pkt_airtime_millis * 2 * (recipient.out_path_len + 1);   // can't be quicker than airtime there and back
+  return t > min_t ? t : min_t;
 }
 
 static ContactInfo* table;  // pass via global :-(
@@ -795,7 +977,10 @@ ChannelDetails* BaseChatMesh::addChannel(const char* name, const char* psk_base6
     if (len == 32 || len == 16) {
       mesh::Utils::sha256(dest->channel.hash, sizeof(dest->channel.hash), dest->channel.secret, len);
       StrHelper::strncpy(dest->name, name, sizeof(dest->name));
+      channel_keys.invalidate(num_channels);
+      memset(&channel_stats[num_channels], 0, sizeof(channel_stats[0]));
       num_channels++;
+      rebuildChannelIndex();
       return dest;
     }
   }
@@ -818,16 +1003,42 @@ bool BaseChatMesh::setChannel(int idx, const ChannelDetails& src) {
     } else {
       mesh::Utils::sha256(channels[idx].channel.hash, sizeof(channels[idx].channel.hash), src.channel.secret, 32);  // 256-bit key
     }
+    channel_keys.invalidate(idx);
+    memset(&channel_stats[idx], 0, sizeof(channel_stats[idx]));
+    rebuildChannelIndex();
     return true;
   }
   return false;
 }
 int BaseChatMesh::findChannelIdx(const mesh::GroupChannel& ch) {
-  for (int i = 0; i < MAX_GROUP_CHANNELS; i++) {
+  for (int i = channel_buckets[ch.hash[0] & (CHANNEL_HASH_BUCKETS-1)]; i >= 0; i = channel_next[i]) {
     if (memcmp(ch.secret, channels[i].channel.secret, sizeof(ch.secret)) == 0) return i;
   }
   return -1;  // not found
 }
+bool BaseChatMesh::getChannelStats(int idx, ChannelStats& dest) {
+  if (idx >= 0 && idx < MAX_GROUP_CHANNELS) {
+    dest = channel_stats[idx];
+    return true;
+  }
+  return false;
+}
+
+void BaseChatMesh::rebuildChannelIndex() {
+  for (int b = 0; b < CHANNEL_HASH_BUCKETS; b++) channel_buckets[b] = -1;
+
+  for (int i = MAX_GROUP_CHANNELS - 1; i >= 0; i--) {   // (backwards, so each bucket is in idx order)
+    bool empty = true;   // unused slots have all zero secret
+    for (int k = 0; k < sizeof(channels[i].channel.secret) && empty; k++) {
+      if (channels[i].channel.secret[k]) empty = false;
+    }
+    if (empty) continue;
+
+    int b = channels[i].channel.hash[0] & (CHANNEL_HASH_BUCKETS-1);
+    channel_next[i] = channel_buckets[b];
+    channel_buckets[b] = i;
+  }
+}
 #else
 ChannelDetails* BaseChatMesh::addChannel(const char* name, const char* psk_base64) {
   return NULL;  // not supported
@@ -841,6 +1052,9 @@ bool BaseChatMesh::setChannel(int idx, const ChannelDetails& src) {
 int BaseChatMesh::findChannelIdx(const mesh::GroupChannel& ch) {
   return -1;  // not found
 }
+bool BaseChatMesh::getChannelStats(int idx, ChannelStats& dest) {
+  return false;
+}
 #endif
 
 bool BaseChatMesh::getContactByIdx(uint32_t idx, ContactInfo& contact) {
@@ -861,15 +1075,265 @@ bool ContactsIterator::hasNext(const BaseChatMesh* mesh, ContactInfo& dest) {
   return true;
 }
 
+#ifdef WITH_BULK_TRANSFER
+
+#define BULK_RECV_IDLE_MILLIS   60000   // incomplete transfer from one contact blocks others for this long
+
+// millis between bulk fragments, so each can get a couple of hops along the path before the next (radios are half duplex)
+static uint32_t calcBulkSpacing(uint32_t frag_airtime, int path_len) {
+  return frag_airtime * ((path_len < 2 ? path_len : 2) + 1);
+}
+
+bool BaseChatMesh::sendBulk(const ContactInfo& recipient, const uint8_t* data, int len) {
+  if (recipient.out_path_len < 0 || _bulk_tx.isActive()) return false;   // needs a Direct path, and one at a time
+
+  uint32_t t = _radio->getEstAirtimeFor(2 + recipient.out_path_len + MAX_PACKET_PAYLOAD);
+  uint32_t spacing = calcBulkSpacing(t, recipient.out_path_len);
+  uint32_t rto = 2*spacing + calcDirectTimeoutMillisFor(t, recipient.out_path_len);
+
+  uint8_t id;
+  do {
+    id = getRNG()->nextInt(1, 256);
+  } while (id == _bulk_tx.getId());   // so receiver won't take it as a repeat of the last one
+
+  if (!_bulk_tx.begin(data, len, id, spacing, rto, _ms->getMillis())) return false;   // too large
+
+  memcpy(bulk_tx_dest, recipient.id.pub_key, PUB_KEY_SIZE);
+  return true;
+}
+
+void BaseChatMesh::onPeerMultipartRecv(mesh::Packet* packet, uint8_t type, int sender_idx, const uint8_t* secret, uint8_t* data, size_t len) {
+  int i = matching_peer_indexes[sender_idx];
+  if (i < 0 || i >= num_contacts) {
+    MESH_DEBUG_PRINTLN("onPeerMultipartRecv: Invalid sender idx: %d", i);
+    return;
+  }
+  ContactInfo& from = contacts[i];
+  uint32_t now = _ms->getMillis();
+
+  if (type == MULTIPART_TYPE_BULK_DATA) {
+    if (memcmp(bulk_rx_src, from.id.pub_key, PUB_KEY_SIZE) != 0) {
+      if (_bulk_rx.isBusy(now, BULK_RECV_IDLE_MILLIS)) {
+        MESH_DEBUG_PRINTLN("onPeerMultipartRecv: busy with another bulk transfer");
+        return;
+      }
+      _bulk_rx.reset();
+      memcpy(bulk_rx_src, from.id.pub_key, PUB_KEY_SIZE);
+    }
+
+    // if sender's burst gets cut short, ACK after a couple of fragment spacings (assumes path back is same length)
+    uint32_t t = _radio->getEstAirtimeFor(packet->getRawLength());
+    uint32_t ack_delay = 2*calcBulkSpacing(t, from.out_path_len < 0 ? 0 : from.out_path_len) + t;
+    if (_bulk_rx.onFragment(data, len, now, ack_delay) == BULK_RECV_COMPLETE) {
+      onBulkDataRecv(from, _bulk_rx.getData(), _bulk_rx.getLength());
+    }
+  } else if (type == MULTIPART_TYPE_BULK_ACK) {
+    if (_bulk_tx.isActive() && memcmp(bulk_tx_dest, from.id.pub_key, PUB_KEY_SIZE) == 0) {
+      _bulk_tx.onAck(data, len, now);
+    }
+  }
+}
+
+void BaseChatMesh::checkBulkTransfers() {
+  uint32_t now = _ms->getMillis();
+
+  if (_bulk_tx.isActive() || _bulk_tx.isDone() || _bulk_tx.isFailed()) {
+    ContactInfo* to = lookupContactByPubKey(bulk_tx_dest, PUB_KEY_SIZE);
+    if (to == NULL) {
+      _bulk_tx.cancel();   // contact removed
+    } else if (_bulk_tx.isDone() || _bulk_tx.isFailed() || to->out_path_len < 0) {
+      bool delivered = _bulk_tx.isDone();
+      _bulk_tx.cancel();
+      onBulkSendDone(*to, delivered);
+    } else {
+      uint8_t frag[BULK_FRAG_META_SIZE + BULK_FRAG_DATA_SIZE];
+      int len = _bulk_tx.nextFragment(now, frag);
+      if (len > 0) {
+        mesh::Packet* pkt = createMultipartDatagram(MULTIPART_TYPE_BULK_DATA, to->id, to->getSharedSecret(self_id), frag, len);
+        if (pkt) sendDirect(pkt, to->out_path, to->out_path_len);   // otherwise, is re-sent later as if lost on air
+      }
+    }
+  }
+
+  if (_bulk_rx.isAckDue(now)) {
+    uint8_t ack[BULK_ACK_SIZE];
+    int len = _bulk_rx.writeAck(ack);
+
+    ContactInfo* from = lookupContactByPubKey(bulk_rx_src, PUB_KEY_SIZE);
+    mesh::Packet* pkt = from ? createMultipartDatagram(MULTIPART_TYPE_BULK_ACK, from->id, from->getSharedSecret(self_id), ack, len) : NULL;
+    if (pkt) {
+      if (from->out_path_len < 0) {
+        sendFloodScoped(*from, pkt);
+      } else {
+        sendDirect(pkt, from->out_path, from->out_path_len);
+      }
+    }
+  }
+}
+
+#endif
+
+bool BaseChatMesh::queueOutboundMessage(const ContactInfo& recipient, uint32_t timestamp, const char* text, uint32_t& msg_id) {
+  int text_len = strlen(text);
+  if (text_len > MAX_TEXT_LEN) return false;
+
+  OutboundMessage* msg = NULL;
+  for (int i = 0; i < MAX_OUTBOUND_MSGS; i++) {
+    if (outbound_msgs[i].seq == 0) { msg = &outbound_msgs[i]; break; }
+  }
+  if (msg == NULL) return false;   // queue full
+
+  memset(msg, 0, sizeof(*msg));
+  msg->seq = next_outbound_seq++;
+  memcpy(msg->dest, recipient.id.pub_key, PUB_KEY_SIZE);
+  msg->timestamp = timestamp;
+  memcpy(msg->text, text, text_len + 1);
+
+  // expected ACK of each attempt (same as composeMsgPacket() calcs)
+  uint8_t temp[5+MAX_TEXT_LEN];
+  memcpy(temp, &timestamp, 4);
+  memcpy(&temp[5], text, text_len);
+  for (int n = 0; n < MSG_RETRY_MAX_ATTEMPTS; n++) {
+    temp[4] = n;   // TXT_TYPE_PLAIN
+    mesh::Utils::sha256((uint8_t *)&msg->acks[n], 4, temp, 5 + text_len, self_id.pub_key, PUB_KEY_SIZE);
+  }
+  msg_id = msg->acks[0];
+
+  if (isNextOutboundTo(*msg)) sendOutboundAttempt(*msg);
+  return true;
+}
+
+int BaseChatMesh::getNumOutboundMessages() const {
+  int n = 0;
+  for (int i = 0; i < MAX_OUTBOUND_MSGS; i++) {
+    if (outbound_msgs[i].seq) n++;
+  }
+  return n;
+}
+
+bool BaseChatMesh::isNextOutboundTo(const OutboundMessage& msg) const {
+  for (int i = 0; i < MAX_OUTBOUND_MSGS; i++) {
+    auto m = &outbound_msgs[i];
+    if (m->seq && m->seq < msg.seq && memcmp(m->dest, msg.dest, PUB_KEY_SIZE) == 0) return false;  // earlier msg to same contact still pending
+  }
+  return true;
+}
+
+uint32_t BaseChatMesh::calcRetryTimeout(uint32_t est_timeout, uint8_t retries) const {
+  uint32_t t = est_timeout << retries;   // exponential backoff
+
+  // queuing delays at each repeater grow as the channel gets busier, ~ 1/(1 - utilisation)
+  uint32_t util = getChannelUtilisation();
+  if (util > MSG_RETRY_MAX_UTIL) util = MSG_RETRY_MAX_UTIL;
+  t = t * 100 / (100 - util);
+
+  return t + getRNG()->nextInt(0, t/4 + 1);   // jitter, so msgs lost in the same collision aren't re-sent in step
+}
+
+void BaseChatMesh::sendOutboundAttempt(OutboundMessage& msg) {
+  ContactInfo* c = lookupContactByPubKey(msg.dest, PUB_KEY_SIZE);
+  if (c == NULL) {   // contact has been removed
+    msg.seq = 0;
+    return;
+  }
+
+  uint8_t n = msg.attempt;
+  uint8_t num_direct = 0;
+  for (int i = 0; i < n; i++) {
+    if (msg.direct_mask & (1 << i)) num_direct++;
+  }
+
+  // direct while the path(s) might work, but always flood the last attempt
+  bool direct = c->out_path_len >= 0 && num_direct < MSG_RETRY_DIRECT_ATTEMPTS && n + 1 < MSG_RETRY_MAX_ATTEMPTS;
+  if (!direct && c->out_path_len >= 0) {
+    MESH_DEBUG_PRINTLN("sendOutboundAttempt(): direct failed, resetting path and flooding");
+    resetPathTo(*c);    // so that recipient's PATH reply sets a fresh one
+    onContactPathUpdated(*c);
+  }
+
+  uint32_t ack;
+  mesh::Packet* pkt = composeMsgPacket(*c, msg.timestamp, n, msg.text, ack);
+  if (pkt == NULL) return;   // packet pool is empty, try again next loop()
+
+  uint32_t t = _radio->getEstAirtimeFor(pkt->getRawLength());
+  uint32_t timeout;
+  if (direct) {
+    timeout = calcRetryTimeout(calcDirectTimeoutFor(*c, t), num_direct);
+    sendDirect(pkt, c->out_path, c->out_path_len);
+    msg.direct_mask |= (1 << n);
+  } else {
+    timeout = calcRetryTimeout(calcFloodTimeoutMillisFor(t), n - num_direct);
+    sendFloodScoped(*c, pkt);
+  }
+  msg.sent_at[n] = _ms->getMillis();
+  msg.ack_timeout = futureMillis(timeout);
+  msg.attempt++;
+}
+
+ContactInfo* BaseChatMesh::processOutboundAck(const uint8_t* data) {
+  for (int i = 0; i < MAX_OUTBOUND_MSGS; i++) {
+    auto m = &outbound_msgs[i];
+    if (m->seq == 0) continue;
+
+    for (int n = 0; n < m->attempt; n++) {   // an ACK of any attempt will do
+      if (memcmp(data, &m->acks[n], 4) != 0) continue;
+
+      m->seq = 0;
+      ContactInfo* c = lookupContactByPubKey(m->dest, PUB_KEY_SIZE);
+      if (c == NULL) return NULL;
+
+      unsigned long now = _ms->getMillis();
+      if (n == m->attempt - 1 && (m->direct_mask & (1 << n)) && c->out_path_len >= 0) {
+        onDirectRoundTrip(*c, now - m->sent_at[n]);   // (earlier attempts may have been via other paths)
+      }
+      onMessageDelivered(*c, m->acks[0], m->attempt, now - m->sent_at[0]);
+      return c;
+    }
+  }
+  return NULL;
+}
+
+void BaseChatMesh::checkOutboundMessages() {
+  for (int i = 0; i < MAX_OUTBOUND_MSGS; i++) {
+    auto m = &outbound_msgs[i];
+    if (m->seq == 0) continue;
+
+    if (m->ack_timeout) {
+      if (!millisHasNowPassed(m->ack_timeout)) continue;   // still waiting for ACK
+      m->ack_timeout = 0;
+
+      ContactInfo* c = lookupContactByPubKey(m->dest, PUB_KEY_SIZE);
+      if (c && c->out_path_len >= 0 && (m->direct_mask & (1 << (m->attempt - 1)))) {
+        switchToNextPath(*c);   // try next best path, if any
+      }
+      if (m->attempt >= MSG_RETRY_MAX_ATTEMPTS) {
+        MESH_DEBUG_PRINTLN("checkOutboundMessages(): no ACK after %d attempts", (uint32_t) m->attempt);
+        m->seq = 0;
+        if (c) onMessageFailed(*c, m->acks[0]);
+        continue;
+      }
+    }
+    if (isNextOutboundTo(*m)) {
+      sendOutboundAttempt(*m);
+    }
+  }
+}
+
 void BaseChatMesh::loop() {
   Mesh::loop();
 
   if (txt_send_timeout && millisHasNowPassed(txt_send_timeout)) {
     // failed to get an ACK
+    if (txt_send_direct) failOverPath();   // try next best path, if any
     onSendTimeout();
     txt_send_timeout = 0;
   }
 
+#ifdef WITH_BULK_TRANSFER
+  checkBulkTransfers();
+#endif
+  checkOutboundMessages();
+
   if (_pendingLoopback) {
     onRecvPacket(_pendingLoopback);  // loop-back, as if received over radio
     releasePacket(_pendingLoopback);   // undo the obtainNewPacket()
@@ -4,6 +4,11 @@
 #include <Mesh.h>
 #include <helpers/AdvertDataHelpers.h>
 #include <helpers/TxtDataHelpers.h>
+#include <helpers/PathStore.h>
+#ifdef WITH_BULK_TRANSFER
+  #include <helpers/BulkTransfer.h>
+#endif
+#include <helpers/CipherKeyCache.h>
 
 #define MAX_TEXT_LEN    (10*CIPHER_BLOCK_SIZE)  // must be LESS than (MAX_PACKET_PAYLOAD - 4 - CIPHER_MAC_SIZE - 1)
 
@@ -41,16 +46,59 @@ public:
   #define MAX_CONNECTIONS  16
 #endif
 
+#ifndef CHANNEL_HASH_BUCKETS
+  #define CHANNEL_HASH_BUCKETS  16    // must be power of 2
+#endif
+
+#ifndef MAX_ALT_PATH_RETURNS
+  #define MAX_ALT_PATH_RETURNS   2    // extra PATH returns sent per flood msg, for repeats arriving via other routes
+#endif
+
 struct ConnectionInfo {
   mesh::Identity server_id;
   unsigned long next_ping;
+  unsigned long ping_sent;   // millis when KEEP_ALIVE for expected_ack was sent
   uint32_t last_activity;
   uint32_t keep_alive_millis;
   uint32_t expected_ack;
+  uint8_t ping_retries;   // KEEP_ALIVEs sent since last ACK
+};
+
+#ifndef MAX_OUTBOUND_MSGS
+  #define MAX_OUTBOUND_MSGS          4    // msgs from queueOutboundMessage(), being (re)sent until ACKed
+#endif
+
+#ifndef MSG_RETRY_MAX_ATTEMPTS
+  #define MSG_RETRY_MAX_ATTEMPTS     4    // sends per msg before giving up (max 4, as ACK hash only has attempt & 3)
+#endif
+
+#ifndef MSG_RETRY_DIRECT_ATTEMPTS
+  #define MSG_RETRY_DIRECT_ATTEMPTS  2    // direct sends (best path, then next best) before resetting path and flooding
+#endif
+
+#ifndef MSG_RETRY_MAX_UTIL
+  #define MSG_RETRY_MAX_UTIL        75    // channel utilisation (percent) above which timeouts stop growing
+#endif
+
+struct OutboundMessage {
+  uint32_t seq;   // queue order, 0 = unused slot
+  uint8_t dest[PUB_KEY_SIZE];
+  uint32_t timestamp;
+  uint32_t acks[MSG_RETRY_MAX_ATTEMPTS];   // expected ACK of each attempt, acks[0] is the msg_id
+  unsigned long sent_at[MSG_RETRY_MAX_ATTEMPTS];
+  unsigned long ack_timeout;   // 0 = not waiting for an ACK
+  uint8_t attempt;       // sends so far
+  uint8_t direct_mask;   // bit per attempt, set if sent direct
+  char text[MAX_TEXT_LEN+1];
 };
 
 #include "ChannelDetails.h"
 
+struct ChannelStats {
+  uint32_t hits;     // packets decrypted with this channel
+  uint32_t misses;   // failed MAC checks (ie. packets for other channels with same hash byte)
+};
+
 /**
  *  \brief  abstract Mesh class for common 'chat' client
  */
@@ -66,13 +114,58 @@ class BaseChatMesh : public mesh::Mesh {
 #ifdef MAX_GROUP_CHANNELS
   ChannelDetails channels[MAX_GROUP_CHANNELS];
   int num_channels;  // only for addChannel()
+  int16_t channel_buckets[CHANNEL_HASH_BUCKETS];  // first channel idx with hash in each bucket, -1 = none
+  int16_t channel_next[MAX_GROUP_CHANNELS];       // next channel idx in same bucket
+  int matching_channel_indexes[MAX_GROUP_CHANNELS];
+  ChannelStats channel_stats[MAX_GROUP_CHANNELS];
+  CipherKeyCache channel_keys;
 #endif
   mesh::Packet* _pendingLoopback;
   uint8_t temp_buf[MAX_TRANS_UNIT];
   ConnectionInfo connections[MAX_CONNECTIONS];
+  PathStore _paths;
+
+  // last msg sent (for path metrics)
+  uint8_t txt_send_dest[4];
+  unsigned long txt_sent_millis;
+  bool txt_send_direct;
+
+  // last flood msg received (for sending back alternative paths)
+  uint8_t alt_fingerprint[MAX_HASH_SIZE];
+  uint8_t alt_sender[4];
+  uint8_t alt_first_path_len;
+  uint8_t alt_paths_sent;
+  unsigned long alt_path_expiry;
+
+#ifdef WITH_BULK_TRANSFER
+  // bulk transfers (one each way at a time)
+  BulkSender _bulk_tx;
+  BulkReceiver _bulk_rx;
+  uint8_t bulk_tx_dest[PUB_KEY_SIZE];
+  uint8_t bulk_rx_src[PUB_KEY_SIZE];
+#endif
+
+  // msgs which are re-sent until ACKed (one at a time per contact)
+  OutboundMessage outbound_msgs[MAX_OUTBOUND_MSGS];
+  uint32_t next_outbound_seq;
 
   mesh::Packet* composeMsgPacket(const ContactInfo& recipient, uint32_t timestamp, uint8_t attempt, const char *text, uint32_t& expected_ack);
   void sendAckTo(const ContactInfo& dest, uint32_t ack_hash);
+  void trackMsgSend(const ContactInfo& recipient, bool direct);
+  void trackFloodRecv(const ContactInfo& from, mesh::Packet* packet);
+  void failOverPath();
+  void switchToNextPath(ContactInfo& contact);
+  void onDirectRoundTrip(ContactInfo& contact, uint32_t rtt_millis);
+#ifdef WITH_BULK_TRANSFER
+  void checkBulkTransfers();
+#endif
+  bool isNextOutboundTo(const OutboundMessage& msg) const;
+  void sendOutboundAttempt(OutboundMessage& msg);
+  ContactInfo* processOutboundAck(const uint8_t* data);
+  void checkOutboundMessages();
+#ifdef MAX_GROUP_CHANNELS
+  void rebuildChannelIndex();
+#endif
 
 protected:
   BaseChatMesh(mesh::Radio& radio, mesh::MillisecondClock& ms, mesh::RNG& rng, mesh::RTCClock& rtc, mesh::PacketManager& mgr, mesh::MeshTables& tables)
@@ -82,10 +175,20 @@ protected:
   #ifdef MAX_GROUP_CHANNELS
     memset(channels, 0, sizeof(channels));
     num_channels = 0;
+    memset(channel_stats, 0, sizeof(channel_stats));
+    rebuildChannelIndex();
   #endif
     txt_send_timeout = 0;
+    txt_send_direct = false;
+    alt_path_expiry = 0;
     _pendingLoopback = NULL;
     memset(connections, 0, sizeof(connections));
+#ifdef WITH_BULK_TRANSFER
+    memset(bulk_tx_dest, 0, sizeof(bulk_tx_dest));
+    memset(bulk_rx_src, 0, sizeof(bulk_rx_src));
+#endif
+    memset(outbound_msgs, 0, sizeof(outbound_msgs));
+    next_outbound_seq = 1;
   }
 
   void bootstrapRTCfromContacts();
@@ -99,6 +202,7 @@ protected:
   virtual void onContactsFull() {};
   virtual bool shouldOverwriteWhenFull() const { return false; }
   virtual void onContactOverwrite(const uint8_t* pub_key) {};
+  virtual bool shouldCompressGroupText(const mesh::GroupChannel& channel) const { return false; }  // only if ALL members understand TXT_TYPE_COMPRESSED
   virtual void onDiscoveredContact(ContactInfo& contact, bool is_new, uint8_t path_len, const uint8_t* path) = 0;
   virtual ContactInfo* processAck(const uint8_t *data) = 0;
   virtual void onContactPathUpdated(const ContactInfo& contact) = 0;
@@ -109,9 +213,28 @@ protected:
   virtual uint32_t calcFloodTimeoutMillisFor(uint32_t pkt_airtime_millis) const = 0;
   virtual uint32_t calcDirectTimeoutMillisFor(uint32_t pkt_airtime_millis, uint8_t path_len) const = 0;
   virtual void onSendTimeout() = 0;
+  virtual void onMessageDelivered(const ContactInfo& contact, uint32_t msg_id, uint8_t attempts, uint32_t latency_millis) { }
+  virtual void onMessageFailed(const ContactInfo& contact, uint32_t msg_id) { }
+
+  /**
+   * \brief  how long to wait for an ACK, before re-sending a queued msg
+   * \param  est_timeout  from calcFloodTimeoutMillisFor() or calcDirectTimeoutFor()
+   * \param  retries  earlier attempts sent the same way (direct or flood)
+   */
+  virtual uint32_t calcRetryTimeout(uint32_t est_timeout, uint8_t retries) const;
+
+  /**
+   * \brief  ACK timeout for a direct send: from the contact's measured round trips, or calcDirectTimeoutMillisFor()
+   *          until there are some.
+   */
+  uint32_t calcDirectTimeoutFor(const ContactInfo& recipient, uint32_t pkt_airtime_millis) const;
   virtual void onChannelMessageRecv(const mesh::GroupChannel& channel, mesh::Packet* pkt, uint32_t timestamp, const char *text) = 0;
   virtual uint8_t onContactRequest(const ContactInfo& contact, uint32_t sender_timestamp, const uint8_t* data, uint8_t len, uint8_t* reply) = 0;
   virtual void onContactResponse(const ContactInfo& contact, const uint8_t* data, uint8_t len) = 0;
+#ifdef WITH_BULK_TRANSFER
+  virtual void onBulkDataRecv(const ContactInfo& contact, const uint8_t* data, int len) { }
+  virtual void onBulkSendDone(const ContactInfo& contact, bool delivered) { }
+#endif
   virtual void handleReturnPathRetry(const ContactInfo& contact, const uint8_t* path, uint8_t path_len);
 
   virtual void sendFloodScoped(const ContactInfo& recipient, mesh::Packet* pkt, uint32_t delay_millis=0);
@@ -127,9 +250,16 @@ protected:
   void getPeerSharedSecret(uint8_t* dest_secret, int peer_idx) override;
   void onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender_idx, const uint8_t* secret, uint8_t* data, size_t len) override;
   bool onPeerPathRecv(mesh::Packet* packet, int sender_idx, const uint8_t* secret, uint8_t* path, uint8_t path_len, uint8_t extra_type, uint8_t* extra, uint8_t extra_len) override;
+#ifdef WITH_BULK_TRANSFER
+  void onPeerMultipartRecv(mesh::Packet* packet, uint8_t type, int sender_idx, const uint8_t* secret, uint8_t* data, size_t len) override;
+#endif
   void onAckRecv(mesh::Packet* packet, uint32_t ack_crc) override;
+  void onPeerFloodRepeat(mesh::Packet* packet) override;
+  void onTraceRecv(mesh::Packet* packet, uint32_t tag, uint32_t auth_code, uint8_t flags, const uint8_t* path_snrs, const uint8_t* path_hashes, uint8_t path_len) override;
 #ifdef MAX_GROUP_CHANNELS
-  int searchChannelsByHash(const uint8_t* hash, mesh::GroupChannel channels[], int max_matches) override;
+  int searchChannelsByHash(const uint8_t* hash) override;
+  const mesh::GroupChannel* getMatchingChannel(int channel_idx) override;
+  int decryptGroupData(int channel_idx, uint8_t* dest, const uint8_t* src, int src_len) override;
 #endif
   void onGroupDataRecv(mesh::Packet* packet, uint8_t type, const mesh::GroupChannel& channel, uint8_t* data, size_t len) override;
 
@@ -151,6 +281,19 @@ public:
   int  sendAnonReq(const ContactInfo& recipient, const uint8_t* data, uint8_t len, uint32_t& tag, uint32_t& est_timeout);
   int  sendRequest(const ContactInfo& recipient, uint8_t req_type, uint32_t& tag, uint32_t& est_timeout);
   int  sendRequest(const ContactInfo& recipient, const uint8_t* req_data, uint8_t data_len, uint32_t& tag, uint32_t& est_timeout);
+#ifdef WITH_BULK_TRANSFER
+  bool sendBulk(const ContactInfo& recipient, const uint8_t* data, int len);
+  bool isBulkSending() const { return _bulk_tx.isActive(); }
+#endif
+
+  /**
+   * \brief  queues a text msg which this node (re)sends until ACKed, or MSG_RETRY_MAX_ATTEMPTS is reached.
+   *         Outcome is reported via onMessageDelivered() or onMessageFailed().
+   * \param  msg_id  (output) same as the expected_ack of sendMessage() with attempt 0
+   * \returns  false if text too long, or queue is full
+   */
+  bool queueOutboundMessage(const ContactInfo& recipient, uint32_t timestamp, const char* text, uint32_t& msg_id);
+  int getNumOutboundMessages() const;
   bool shareContactZeroHop(const ContactInfo& contact);
   uint8_t exportContact(const ContactInfo& contact, uint8_t dest_buf[]);
   bool importContact(const uint8_t src_buf[], uint8_t len);
@@ -167,6 +310,7 @@ public:
   bool getChannel(int idx, ChannelDetails& dest);
   bool setChannel(int idx, const ChannelDetails& src);
   int findChannelIdx(const mesh::GroupChannel& ch);
+  bool getChannelStats(int idx, ChannelStats& dest);
 
   void loop();
 };
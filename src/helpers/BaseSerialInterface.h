@@ -1,9 +1,18 @@
 #pragma once
 
 #include <Arduino.h>
+#include "FrameRing.h"
 
 #define MAX_FRAME_SIZE  172
 
+// byte capacity of the (queued) send/recv frame rings, where interface uses them
+#ifndef SERIAL_SEND_QUEUE_BYTES
+  #define SERIAL_SEND_QUEUE_BYTES  (12*(MAX_FRAME_SIZE+1))
+#endif
+#ifndef SERIAL_RECV_QUEUE_BYTES
+  #define SERIAL_RECV_QUEUE_BYTES  (12*(MAX_FRAME_SIZE+1))
+#endif
+
 class BaseSerialInterface {
 protected:
   BaseSerialInterface() { }
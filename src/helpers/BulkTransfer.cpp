@@ -0,0 +1,155 @@
+#include "BulkTransfer.h"
+
+#define BULK_INITIAL_WINDOW    4
+
+bool BulkSender::begin(const uint8_t* data, int len, uint8_t xfer_id, uint32_t spacing, uint32_t rto, uint32_t now) {
+  if (len <= 0 || len > BULK_MAX_BYTES) return false;
+
+  memcpy(_buf, data, len);
+  _len = len;
+  _id = xfer_id;
+  _total = (len + BULK_FRAG_DATA_SIZE - 1) / BULK_FRAG_DATA_SIZE;
+  _tx_count = 0;
+  _window = BULK_INITIAL_WINDOW;
+  _retries = 0;
+  _acked = 0;
+  _spacing = spacing;
+  _rto = rto;
+  _num_sent = 0;
+  _next_send = now;
+  startBurst();
+  return true;
+}
+
+void BulkSender::startBurst() {
+  // lowest unacked first, so lost fragments are re-sent before new ones
+  _pending = 0;
+  int n = 0;
+  for (int i = 0; i < _total && n < _window; i++) {
+    if ((_acked & (1UL << i)) == 0) {
+      _pending |= (1UL << i);
+      n++;
+    }
+  }
+  _burst = _pending;
+  _state = SENDING;
+}
+
+int BulkSender::nextFragment(uint32_t now, uint8_t dest[]) {
+  if (_state == WAIT_ACK) {
+    if ((int32_t)(now - _ack_deadline) < 0) return 0;   // still waiting
+
+    if (++_retries > BULK_MAX_RETRIES) {
+      _state = FAILED;
+      return 0;
+    }
+    if (_window > 1) _window /= 2;   // link worse than thought, so ask for ACKs sooner
+    startBurst();
+  }
+  if (_state != SENDING || (int32_t)(now - _next_send) < 0) return 0;
+
+  int seq = 0;
+  while (seq < _total && (_pending & (1UL << seq)) == 0) seq++;
+  if (seq >= _total) {   // nothing left in this burst (shouldn't happen, onAck() re-fills it)
+    startBurst();
+    return 0;
+  }
+  _pending &= ~(1UL << seq);
+
+  int off = seq * BULK_FRAG_DATA_SIZE;
+  int n = _len - off;
+  if (n > BULK_FRAG_DATA_SIZE) n = BULK_FRAG_DATA_SIZE;
+
+  uint8_t flags = _tx_count++ & BULK_FLAG_TX_MASK;
+  if (_pending == 0) {   // end of burst
+    flags |= BULK_FLAG_ACK_REQ;
+    _state = WAIT_ACK;
+    _ack_deadline = now + _rto;
+  }
+
+  int i = 0;
+  dest[i++] = _id;
+  dest[i++] = seq;
+  dest[i++] = _total;
+  dest[i++] = flags;
+  dest[i++] = n;
+  memcpy(&dest[i], &_buf[off], n); i += n;
+
+  _next_send = now + _spacing;
+  _num_sent++;
+  return i;
+}
+
+void BulkSender::onAck(const uint8_t* ack, int len, uint32_t now) {
+  if (!isActive() || len < BULK_ACK_SIZE || ack[0] != _id) return;
+
+  uint32_t bitmap;
+  memcpy(&bitmap, &ack[1], 4);
+  bitmap &= allMask();
+
+  uint32_t fresh = bitmap & ~_acked;
+  _acked |= bitmap;
+  _pending &= ~_acked;   // no need to send these
+  if (_acked == allMask()) {
+    _state = DONE;
+    return;
+  }
+
+  if (_state == WAIT_ACK && fresh != 0) {   // (ignore ACKs of earlier bursts)
+    _retries = 0;
+    if ((_burst & ~_acked) == 0 && _window < BULK_MAX_WINDOW) _window++;   // whole burst got through
+    startBurst();
+    _next_send = now;   // ACK has cleared the path
+  } else if (_state == SENDING && _pending == 0) {   // late ACK covered rest of this burst
+    startBurst();
+  }
+}
+
+int BulkReceiver::onFragment(const uint8_t* frag, int len, uint32_t now, uint32_t ack_delay) {
+  if (len < BULK_FRAG_META_SIZE) return BULK_RECV_IGNORED;
+
+  uint8_t id = frag[0];
+  uint8_t seq = frag[1];
+  uint8_t total = frag[2];
+  uint8_t flags = frag[3];
+  uint8_t n = frag[4];
+  if (total == 0 || total > BULK_MAX_FRAGMENTS || seq >= total || n > BULK_FRAG_DATA_SIZE || BULK_FRAG_META_SIZE + n > len) {
+    return BULK_RECV_IGNORED;   // invalid, or too big for us
+  }
+  if (seq < total - 1 && n != BULK_FRAG_DATA_SIZE) return BULK_RECV_IGNORED;   // only last can be short
+
+  if (!_active || id != _id) {   // start of new transfer
+    _active = true;
+    _id = id;
+    _total = total;
+    _received = 0;
+    _last_len = 0;
+    _ack_count = 0;
+  } else if (total != _total) {
+    return BULK_RECV_IGNORED;
+  }
+
+  bool was_complete = isComplete();
+  if ((_received & (1UL << seq)) == 0) {
+    memcpy(&_buf[seq * BULK_FRAG_DATA_SIZE], &frag[BULK_FRAG_META_SIZE], n);
+    if (seq == total - 1) _last_len = n;
+    _received |= (1UL << seq);
+  }
+  _last_recv = now;
+
+  bool complete = isComplete();
+  _ack_pending = true;
+  _ack_due = (flags & BULK_FLAG_ACK_REQ) || complete ? now : now + ack_delay;
+
+  return complete && !was_complete ? BULK_RECV_COMPLETE : BULK_RECV_OK;
+}
+
+int BulkReceiver::writeAck(uint8_t dest[]) {
+  _ack_pending = false;
+
+  int i = 0;
+  dest[i++] = _id;
+  memcpy(&dest[i], &_received, 4); i += 4;
+  dest[i++] = _ack_count++;   // so repeated ACKs aren't dropped as dups along the path
+  return i;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef BULK_MAX_FRAGMENTS
+  #define BULK_MAX_FRAGMENTS     16    // per transfer, max 32 (received bitmap)
+#endif
+
+#ifndef BULK_MAX_WINDOW
+  #define BULK_MAX_WINDOW         8    // max fragments sent before asking for an ACK
+#endif
+
+#ifndef BULK_MAX_RETRIES
+  #define BULK_MAX_RETRIES        8    // ACK timeouts in a row, before giving up
+#endif
+
+// fragment (plaintext):  xfer_id(1), seq(1), total(1), flags(1), data_len(1), data...
+#define BULK_FRAG_META_SIZE      5
+#define BULK_FRAG_DATA_SIZE    171    // so encrypted fragment fills a MULTIPART packet (176 byte ciphertext)
+#define BULK_MAX_BYTES     (BULK_MAX_FRAGMENTS*BULK_FRAG_DATA_SIZE)
+
+#define BULK_FLAG_ACK_REQ     0x80    // last of a burst, receiver should ACK now
+#define BULK_FLAG_TX_MASK     0x7F    // transmit counter, so re-sent fragments aren't dropped as dups along the path
+
+// ACK (plaintext):  xfer_id(1), received bitmap(4), ack counter(1)
+#define BULK_ACK_SIZE            6
+
+/**
+ * \brief  Sending side of a windowed, selective-repeat bulk transfer. Data is split into fragments which are sent
+ *         in bursts (paced for the path length), the last of each asking for an ACK. The ACK has a bitmap of all
+ *         fragments received so far, so the next burst re-sends just the lost ones, then continues with new ones.
+ *         Window grows while ACKs come back, and halves on ACK timeouts.
+ *         Makes the fragment payloads only, caller does the encryption and sending.
+ */
+class BulkSender {
+  enum State { IDLE, SENDING, WAIT_ACK, DONE, FAILED };
+
+  uint8_t _buf[BULK_MAX_BYTES];
+  int _len;
+  uint8_t _id, _total, _tx_count, _window, _retries;
+  State _state;
+  uint32_t _acked;      // bitmap of fragments receiver has
+  uint32_t _pending;    // bitmap of fragments still to send in this burst
+  uint32_t _burst;      // bitmap of all fragments in this burst
+  uint32_t _next_send, _ack_deadline;
+  uint32_t _spacing, _rto;
+  uint32_t _num_sent;
+
+  uint32_t allMask() const { return _total >= 32 ? 0xFFFFFFFF : (1UL << _total) - 1; }
+  void startBurst();
+
+public:
+  BulkSender() : _len(0), _id(0), _state(IDLE), _num_sent(0) { }
+
+  /**
+   * \param  spacing  millis between fragments (eg. to let each hop forward one before the next is sent)
+   * \param  rto  millis to wait for an ACK, after last fragment of a burst
+   * \returns  false if too large
+   */
+  bool begin(const uint8_t* data, int len, uint8_t xfer_id, uint32_t spacing, uint32_t rto, uint32_t now);
+  void cancel() { _state = IDLE; }
+
+  /**
+   * \brief  called often, writes next fragment payload (if one is due) to 'dest' (BULK_FRAG_META_SIZE + BULK_FRAG_DATA_SIZE)
+   * \returns  length of fragment, or 0 if nothing to send now.
+   *           NOTE: if caller can't send it, it is just treated as lost on air
+   */
+  int nextFragment(uint32_t now, uint8_t dest[]);
+
+  void onAck(const uint8_t* ack, int len, uint32_t now);
+
+  bool isActive() const { return _state == SENDING || _state == WAIT_ACK; }
+  bool isDone() const { return _state == DONE; }
+  bool isFailed() const { return _state == FAILED; }
+  uint8_t getId() const { return _id; }
+  int getNumFragments() const { return _total; }
+  uint32_t getNumSent() const { return _num_sent; }   // fragments sent, including re-sends
+};
+
+#define BULK_RECV_IGNORED     0
+#define BULK_RECV_OK          1
+#define BULK_RECV_COMPLETE    2   // all fragments now received (returned once per transfer)
+
+/**
+ * \brief  Receiving side of the bulk transfer. Reassembles fragments, and says when to ACK: when asked to by the
+ *         sender, or when fragments stop arriving (ie. the one asking for the ACK was lost).
+ */
+class BulkReceiver {
+  uint8_t _buf[BULK_MAX_BYTES];
+  uint8_t _id, _total, _ack_count;
+  int _last_len;
+  bool _active;
+  uint32_t _received;   // bitmap
+  uint32_t _last_recv, _ack_due;
+  bool _ack_pending;
+
+  uint32_t allMask() const { return _total >= 32 ? 0xFFFFFFFF : (1UL << _total) - 1; }
+
+public:
+  BulkReceiver() : _active(false), _ack_pending(false) { }
+
+  /**
+   * \returns  true if an incomplete transfer is under way, and has had a fragment in the last 'idle_millis'
+   */
+  bool isBusy(uint32_t now, uint32_t idle_millis) const { return _active && !isComplete() && (now - _last_recv) < idle_millis; }
+  void reset() { _active = false; _ack_pending = false; }
+
+  /**
+   * \param  ack_delay  millis to wait for more fragments before sending an ACK anyway
+   * \returns  one of BULK_RECV_*
+   */
+  int onFragment(const uint8_t* frag, int len, uint32_t now, uint32_t ack_delay);
+
+  /**
+   * \returns  true if an ACK should be sent now (then call writeAck())
+   */
+  bool isAckDue(uint32_t now) const { return _ack_pending && (int32_t)(now - _ack_due) >= 0; }
+
+  /**
+   * \param  dest  must be at least BULK_ACK_SIZE bytes
+   */
+  int writeAck(uint8_t dest[]);
+
+  bool isComplete() const { return _active && _received == allMask(); }
+  const uint8_t* getData() const { return _buf; }
+  int getLength() const { return isComplete() ? (_total - 1)*BULK_FRAG_DATA_SIZE + _last_len : 0; }
+};
@@ -0,0 +1,76 @@
+#include "CipherKeyCache.h"
+#include <string.h>
+
+#define HMAC_BLOCK_SIZE   64
+
+CipherKeyCache::CipherKeyCache() {
+  for (int i = 0; i < CIPHER_KEY_CACHE_SIZE; i++) {
+    _entries[i].slot = -1;
+    _entries[i].last_used = 0;
+  }
+  _tick = 0;
+}
+
+CipherKeyCache::Entry& CipherKeyCache::load(int slot, const uint8_t* secret) {
+  Entry* e = &_entries[0];
+  for (int i = 0; i < CIPHER_KEY_CACHE_SIZE; i++) {
+    if (_entries[i].slot == slot) {
+      _entries[i].last_used = ++_tick;
+      return _entries[i];
+    }
+    if (_entries[i].last_used < e->last_used) e = &_entries[i];
+  }
+
+  // evict least recently used. HMAC key is the whole secret, as in Utils::MACThenDecrypt()
+  uint8_t pad[HMAC_BLOCK_SIZE];
+  memset(pad, 0x36, sizeof(pad));
+  for (int i = 0; i < PUB_KEY_SIZE; i++) pad[i] ^= secret[i];
+  e->inner.reset();
+  e->inner.update(pad, sizeof(pad));
+
+  memset(pad, 0x5C, sizeof(pad));
+  for (int i = 0; i < PUB_KEY_SIZE; i++) pad[i] ^= secret[i];
+  e->outer.reset();
+  e->outer.update(pad, sizeof(pad));
+
+  e->aes.setKey(secret, CIPHER_KEY_SIZE);
+  e->slot = slot;
+  e->last_used = ++_tick;
+  return *e;
+}
+
+void CipherKeyCache::invalidate(int slot) {
+  for (int i = 0; i < CIPHER_KEY_CACHE_SIZE; i++) {
+    if (_entries[i].slot == slot) {
+      _entries[i].slot = -1;
+      _entries[i].last_used = 0;
+    }
+  }
+}
+
+int CipherKeyCache::MACThenDecrypt(int slot, const uint8_t* secret, uint8_t* dest, const uint8_t* src, int src_len) {
+  if (src_len <= CIPHER_MAC_SIZE) return 0;  // invalid src bytes
+
+  Entry& e = load(slot, secret);
+
+  uint8_t hmac[32];
+  {
+    SHA256 sha = e.inner;
+    sha.update(src + CIPHER_MAC_SIZE, src_len - CIPHER_MAC_SIZE);
+    sha.finalize(hmac, sizeof(hmac));
+
+    sha = e.outer;
+    sha.update(hmac, sizeof(hmac));
+    sha.finalize(hmac, CIPHER_MAC_SIZE);
+  }
+  if (memcmp(hmac, src, CIPHER_MAC_SIZE) != 0) return 0;   // invalid HMAC
+
+  uint8_t* dp = dest;
+  const uint8_t* sp = src + CIPHER_MAC_SIZE;
+  const uint8_t* ep = src + src_len;
+  while (sp < ep) {
+    e.aes.decryptBlock(dp, sp);
+    dp += 16; sp += 16;
+  }
+  return dp - dest;  // will always be multiple of 16
+}
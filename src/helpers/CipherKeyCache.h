@@ -0,0 +1,38 @@
+#pragma once
+
+#include <MeshCore.h>
+#include <AES.h>
+#include <SHA256.h>
+
+#ifndef CIPHER_KEY_CACHE_SIZE
+  #define CIPHER_KEY_CACHE_SIZE   4    // eg. the busiest few channels
+#endif
+
+/**
+ * \brief  Same as Utils::MACThenDecrypt(), but keeps the HMAC pad states and AES key schedule of the most recently
+ *         used secrets, so they aren't re-derived for every packet (saves 2 of the ~5 SHA256 blocks of a MAC check,
+ *         and the AES key expansion). Secrets are identified by a slot number (eg. channel index).
+ */
+class CipherKeyCache {
+  struct Entry {
+    int slot;    // -1 = unused
+    uint32_t last_used;
+    SHA256 inner, outer;   // after hashing the ipad/opad key blocks
+    AES128 aes;
+  };
+
+  Entry _entries[CIPHER_KEY_CACHE_SIZE];
+  uint32_t _tick;
+
+  Entry& load(int slot, const uint8_t* secret);
+
+public:
+  CipherKeyCache();
+
+  /**
+   * \param  secret  PUB_KEY_SIZE bytes, must be the same for a slot until invalidate(slot)
+   */
+  int MACThenDecrypt(int slot, const uint8_t* secret, uint8_t* dest, const uint8_t* src, int src_len);
+
+  void invalidate(int slot);
+};
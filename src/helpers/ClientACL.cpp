@@ -1,5 +1,8 @@
 #include "ClientACL.h"
 
+#define ACL_FILENAME      "/s_contacts"
+#define ACL_RECORD_SIZE   (32 + 1 + 4 + 2 + 1 + 64 + PUB_KEY_SIZE)
+
 static File openWrite(FILESYSTEM* _fs, const char* filename) {
   #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
     _fs->remove(filename);
@@ -11,41 +14,66 @@ static File openWrite(FILESYSTEM* _fs, const char* filename) {
   #endif
 }
 
+static File openReadWrite(FILESYSTEM* _fs, const char* filename) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    return _fs->open(filename, FILE_O_WRITE);   // NOTE: does not truncate, and allows seek()
+  #elif defined(RP2040_PLATFORM)
+    return _fs->open(filename, "r+");
+  #else
+    return _fs->open(filename, "r+", false);
+  #endif
+}
+
+static uint32_t hashRecord(const uint8_t* rec) {
+  uint32_t h = 2166136261UL;    // FNV-1a
+  for (int i = 0; i < ACL_RECORD_SIZE; i++) {
+    h = (h ^ rec[i]) * 16777619UL;
+  }
+  return h;
+}
+
+static void packRecord(uint8_t* rec, const ClientInfo* c) {
+  memset(rec, 0, ACL_RECORD_SIZE);
+  int ofs = 0;
+  memcpy(&rec[ofs], c->id.pub_key, 32); ofs += 32;
+  rec[ofs++] = c->permissions;
+  memcpy(&rec[ofs], &c->extra.room.sync_since, 4); ofs += 4;
+  ofs += 2;   // unused
+  rec[ofs++] = c->out_path_len;
+  memcpy(&rec[ofs], c->out_path, 64); ofs += 64;
+  // NOTE: shared_secret is left as zeroes, as is always re-calculated after load
+}
+
+static void unpackRecord(ClientInfo* c, const uint8_t* rec) {
+  int ofs = 0;
+  c->id = mesh::Identity(&rec[ofs]); ofs += 32;
+  c->permissions = rec[ofs++];
+  memcpy(&c->extra.room.sync_since, &rec[ofs], 4); ofs += 4;
+  ofs += 2;   // unused
+  c->out_path_len = rec[ofs++];
+  memcpy(c->out_path, &rec[ofs], 64); ofs += 64;
+}
+
 void ClientACL::load(FILESYSTEM* fs, const mesh::LocalIdentity& self_id) {
   _fs = fs;
-  num_clients = 0;
-  if (_fs->exists("/s_contacts")) {
+  _self_id = &self_id;
+  num_clients = num_indexed = num_saved = 0;
+  if (_fs->exists(ACL_FILENAME)) {
   #if defined(RP2040_PLATFORM)
-    File file = _fs->open("/s_contacts", "r");
+    File file = _fs->open(ACL_FILENAME, "r");
   #else
-    File file = _fs->open("/s_contacts");
+    File file = _fs->open(ACL_FILENAME);
   #endif
     if (file) {
-      bool full = false;
-      while (!full) {
-        ClientInfo c;
-        uint8_t pub_key[32];
-        uint8_t unused[2];
-
-        memset(&c, 0, sizeof(c));
-
-        bool success = (file.read(pub_key, 32) == 32);
-        success = success && (file.read((uint8_t *) &c.permissions, 1) == 1);
-        success = success && (file.read((uint8_t *) &c.extra.room.sync_since, 4) == 4);
-        success = success && (file.read(unused, 2) == 2);
-        success = success && (file.read((uint8_t *)&c.out_path_len, 1) == 1);
-        success = success && (file.read(c.out_path, 64) == 64);
-        success = success && (file.read(c.shared_secret, PUB_KEY_SIZE) == PUB_KEY_SIZE); // will be recalculated below
-
-        if (!success) break; // EOF
-
-        c.id = mesh::Identity(pub_key);
-        self_id.calcSharedSecret(c.shared_secret, pub_key);  // recalculate shared secrets in case our private key changed
-        if (num_clients < MAX_CLIENTS) {
-          clients[num_clients++] = c;
-        } else {
-          full = true;
-        }
+      uint8_t rec[ACL_RECORD_SIZE];
+      while (num_clients < MAX_CLIENTS) {
+        if (file.read(rec, ACL_RECORD_SIZE) != ACL_RECORD_SIZE) break; // EOF
+
+        ClientInfo* c = &clients[num_clients];
+        memset(c, 0, sizeof(*c));
+        unpackRecord(c, rec);    // NOTE: shared secret is calculated on first use (our private key may have changed)
+        saved_hash[num_saved++] = hashRecord(rec);
+        addToIndex(num_clients++);
       }
       file.close();
     }
@@ -54,78 +82,152 @@ void ClientACL::load(FILESYSTEM* fs, const mesh::LocalIdentity& self_id) {
 
 void ClientACL::save(FILESYSTEM* fs, bool (*filter)(ClientInfo*)) {
   _fs = fs;
-  File file = openWrite(_fs, "/s_contacts");
+
+  int num_records = 0;
+  for (int i = 0; i < num_clients; i++) {
+    auto c = &clients[i];
+    if (c->permissions == 0 || (filter && !filter(c))) continue;    // skip deleted entries, or by filter function
+    num_records++;
+  }
+
+  File file;
+  if (num_records < num_saved || num_saved == 0 || !_fs->exists(ACL_FILENAME)) {
+    file = openWrite(_fs, ACL_FILENAME);   // file needs to shrink (or is new), so re-write in full
+    num_saved = 0;
+  } else {
+    file = openReadWrite(_fs, ACL_FILENAME);
+  }
   if (file) {
-    uint8_t unused[2];
-    memset(unused, 0, sizeof(unused));
+    uint8_t rec[ACL_RECORD_SIZE];
+    int slot = 0, num_written = 0;
+    bool success = true;
 
-    for (int i = 0; i < num_clients; i++) {
+    for (int i = 0; i < num_clients && success; i++) {
       auto c = &clients[i];
       if (c->permissions == 0 || (filter && !filter(c))) continue;    // skip deleted entries, or by filter function
 
-      bool success = (file.write(c->id.pub_key, 32) == 32);
-      success = success && (file.write((uint8_t *) &c->permissions, 1) == 1);
-      success = success && (file.write((uint8_t *) &c->extra.room.sync_since, 4) == 4);
-      success = success && (file.write(unused, 2) == 2);
-      success = success && (file.write((uint8_t *)&c->out_path_len, 1) == 1);
-      success = success && (file.write(c->out_path, 64) == 64);
-      success = success && (file.write(c->shared_secret, PUB_KEY_SIZE) == PUB_KEY_SIZE);
-
-      if (!success) break; // write failed
+      packRecord(rec, c);
+      uint32_t h = hashRecord(rec);
+      if (slot >= num_saved || saved_hash[slot] != h) {   // only write records which have changed
+        success = file.seek(slot * ACL_RECORD_SIZE) && file.write(rec, ACL_RECORD_SIZE) == ACL_RECORD_SIZE;
+        saved_hash[slot] = h;
+        num_written++;
+      }
+      slot++;
     }
     file.close();
+
+    num_saved = success ? slot : 0;   // if write failed, force a full re-write next time
+    MESH_DEBUG_PRINTLN("ClientACL::save() - %d of %d records written", num_written, slot);
   }
 }
 
 bool ClientACL::clear() {
   if (!_fs) return false; // no filesystem, nothing to clear
-  if (_fs->exists("/s_contacts")) {
-    _fs->remove("/s_contacts");
+  if (_fs->exists(ACL_FILENAME)) {
+    _fs->remove(ACL_FILENAME);
   }
   memset(clients, 0, sizeof(clients));
-  num_clients = 0;
+  num_clients = num_indexed = num_saved = 0;
   return true;
 }
 
+int ClientACL::lowerBound(const uint8_t* key, int key_len) const {
+  int lo = 0, hi = num_indexed;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (memcmp(clients[sorted[mid]].id.pub_key, key, key_len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void ClientACL::addToIndex(int idx) {
+  int pos = lowerBound(clients[idx].id.pub_key, PUB_KEY_SIZE);
+  memmove(&sorted[pos + 1], &sorted[pos], (num_indexed - pos) * sizeof(sorted[0]));
+  sorted[pos] = idx;
+  num_indexed++;
+}
+
+void ClientACL::removeFromIndex(int idx) {
+  for (int pos = lowerBound(clients[idx].id.pub_key, PUB_KEY_SIZE); pos < num_indexed; pos++) {
+    if (sorted[pos] == idx) {
+      num_indexed--;
+      memmove(&sorted[pos], &sorted[pos + 1], (num_indexed - pos) * sizeof(sorted[0]));
+      break;
+    }
+  }
+}
+
 ClientInfo* ClientACL::getClient(const uint8_t* pubkey, int key_len) {
-  for (int i = 0; i < num_clients; i++) {
-    if (memcmp(pubkey, clients[i].id.pub_key, key_len) == 0) return &clients[i];  // already known
+  int pos = lowerBound(pubkey, key_len);
+  if (pos < num_indexed && memcmp(pubkey, clients[sorted[pos]].id.pub_key, key_len) == 0) {
+    return &clients[sorted[pos]];  // already known
   }
   return NULL;  // not found
 }
 
-ClientInfo* ClientACL::putClient(const mesh::Identity& id, uint8_t init_perms) {
-  uint32_t min_time = 0xFFFFFFFF;
-  ClientInfo* oldest = &clients[MAX_CLIENTS - 1];
-  for (int i = 0; i < num_clients; i++) {
-    if (id.matches(clients[i].id)) return &clients[i];  // already known
-    if (!clients[i].isAdmin() && clients[i].last_activity < min_time) {
-      oldest = &clients[i];
-      min_time = oldest->last_activity;
-    }
+int ClientACL::searchByHash(const uint8_t* hash, int dest[], int max_matches) const {
+  int n = 0;
+  for (int pos = lowerBound(hash, PATH_HASH_SIZE); pos < num_indexed && n < max_matches; pos++) {
+    int i = sorted[pos];
+    if (!clients[i].id.isHashMatch(hash)) break;   // past all matches
+    dest[n++] = i;
+  }
+  return n;
+}
+
+const uint8_t* ClientACL::getSharedSecret(ClientInfo* client) {
+  if (!client->has_shared_secret && _self_id) {
+    _self_id->calcSharedSecret(client->shared_secret, client->id.pub_key);
+    client->has_shared_secret = true;
   }
+  return client->shared_secret;
+}
+
+ClientInfo* ClientACL::putClient(const mesh::Identity& id, uint8_t init_perms) {
+  ClientInfo* c = getClient(id.pub_key, PUB_KEY_SIZE);
+  if (c) return c;  // already known
 
-  ClientInfo* c;
   if (num_clients < MAX_CLIENTS) {
     c = &clients[num_clients++];
   } else {
+    uint32_t min_time = 0xFFFFFFFF;
+    ClientInfo* oldest = &clients[MAX_CLIENTS - 1];
+    for (int i = 0; i < num_clients; i++) {
+      if (!clients[i].isAdmin() && clients[i].last_activity < min_time) {
+        oldest = &clients[i];
+        min_time = oldest->last_activity;
+      }
+    }
     c = oldest;  // evict least active contact
+    removeFromIndex(c - clients);
   }
   memset(c, 0, sizeof(*c));
   c->permissions = init_perms;
   c->id = id;
   c->out_path_len = -1;  // initially out_path is unknown
+  addToIndex(c - clients);
   return c;
 }
 
 bool ClientACL::applyPermissions(const mesh::LocalIdentity& self_id, const uint8_t* pubkey, int key_len, uint8_t perms) {
+  _self_id = &self_id;
   ClientInfo* c;
   if ((perms & PERM_ACL_ROLE_MASK) == PERM_ACL_GUEST) {  // guest role is not persisted in contacts
     c = getClient(pubkey, key_len);
     if (c == NULL) return false;   // partial pubkey not found
 
-    num_clients--;   // delete from contacts[]
     int i = c - clients;
+    removeFromIndex(i);
+    for (int pos = 0; pos < num_indexed; pos++) {
+      if (sorted[pos] > i) sorted[pos]--;    // entries after are about to shift down
+    }
+
+    num_clients--;   // delete from contacts[]
     while (i < num_clients) {
       clients[i] = clients[i + 1];
       i++;
@@ -137,7 +239,6 @@ bool ClientACL::applyPermissions(const mesh::LocalIdentity& self_id, const uint8
     c = putClient(id, 0);
 
     c->permissions = perms;  // update their permissions
-    self_id.calcSharedSecret(c->shared_secret, pubkey);
   }
   return true;
 }
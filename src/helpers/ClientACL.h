@@ -15,7 +15,8 @@ struct ClientInfo {
   uint8_t permissions;
   int8_t out_path_len;
   uint8_t out_path[MAX_PATH_SIZE];
-  uint8_t shared_secret[PUB_KEY_SIZE];
+  uint8_t shared_secret[PUB_KEY_SIZE];   // NOTE: use ClientACL::getSharedSecret(), as is calculated lazily
+  bool has_shared_secret;
   uint32_t last_timestamp;   // by THEIR clock  (transient)
   uint32_t last_activity;    // by OUR clock    (transient)
   union  {
@@ -24,6 +25,8 @@ struct ClientInfo {
       uint32_t pending_ack;
       uint32_t push_post_timestamp;
       unsigned long ack_timeout;
+      unsigned long push_sent_at;
+      uint16_t ack_latency;   // smoothed push -> ACK round trip, in millis (0 = not measured yet)
       uint8_t  push_failures;
     } room;
   } extra;
@@ -37,15 +40,32 @@ struct ClientInfo {
 
 class ClientACL {
   FILESYSTEM* _fs;
+  const mesh::LocalIdentity* _self_id;
   ClientInfo clients[MAX_CLIENTS];
   int num_clients;
+  uint16_t sorted[MAX_CLIENTS];     // indexes into clients[], sorted by pub_key
+  int num_indexed;
+  uint32_t saved_hash[MAX_CLIENTS]; // hash of each record in file, by record position
+  int num_saved;                    // number of records in file
+
+  int lowerBound(const uint8_t* key, int key_len) const;
+  void addToIndex(int idx);
+  void removeFromIndex(int idx);
 
 public:
   ClientACL() { 
     memset(clients, 0, sizeof(clients));
     num_clients = 0;
+    num_indexed = 0;
+    num_saved = 0;
+    _fs = NULL;
+    _self_id = NULL;
   }
   void load(FILESYSTEM* _fs, const mesh::LocalIdentity& self_id);
+
+  /**
+   * \brief  persists the ACL. Only records which have changed since last load/save are re-written.
+   */
   void save(FILESYSTEM* _fs, bool (*filter)(ClientInfo*)=NULL);
   bool clear();
 
@@ -53,6 +73,21 @@ public:
   ClientInfo* putClient(const mesh::Identity& id, uint8_t init_perms);
   bool applyPermissions(const mesh::LocalIdentity& self_id, const uint8_t* pubkey, int key_len, uint8_t perms);
 
+  /**
+   * \brief  finds clients whose pub_key starts with the given path 'hash'.
+   * \returns  number of matches, with their indexes (for getClientByIdx()) in 'dest'
+   */
+  int searchByHash(const uint8_t* hash, int dest[], int max_matches) const;
+
+  /**
+   * \returns  the ECDH shared secret with client (calculated on first use, then cached)
+   */
+  const uint8_t* getSharedSecret(ClientInfo* client);
+  void setSharedSecret(ClientInfo* client, const uint8_t* secret) {
+    memcpy(client->shared_secret, secret, PUB_KEY_SIZE);
+    client->has_shared_secret = true;
+  }
+
   int getNumClients() const { return num_clients; }
   ClientInfo* getClientByIdx(int idx) { return &clients[idx]; }
 };
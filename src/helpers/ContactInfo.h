@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <Mesh.h>
+#include <helpers/RTTEstimator.h>
 
 struct ContactInfo {
   mesh::Identity id;
@@ -15,6 +16,8 @@ struct ContactInfo {
   uint32_t lastmod;  // by OUR clock
   int32_t gps_lat, gps_lon;    // 6 dec places
   uint32_t sync_since;
+  uint16_t adv_feat1 = 0;   // ADV_FEAT1_* bits from their last advert (NOT persisted)
+  RTTEstimator rtt;   // ACK round trips via out_path
 
   const uint8_t* getSharedSecret(const mesh::LocalIdentity& self_id) const {
     if (!shared_secret_valid) {
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * \brief  A FIFO of variable length frames, packed into a single byte ring (1 byte length prefix per frame).
+ *         Unlike fixed arrays of MAX_FRAME_SIZE slots, small frames only take up the bytes they need, so
+ *         the same RAM holds many more queued frames, and nothing needs shifting when a frame is removed.
+ *
+ *         Safe for ONE producer (push()) and ONE consumer (peek/drop/pop()) in different contexts, eg. a BLE
+ *         callback and the main loop: _tail is only written by the producer, _head only by the consumer. clear()
+ *         must not race with either.
+ */
+class FrameRing {
+  uint8_t* _buf;
+  uint16_t _size;
+  uint16_t _head, _tail;    // read/write positions, in range [0, 2*_size), so full and empty differ
+  uint16_t _frames_in, _frames_out;
+
+  uint16_t loadHead() const { return __atomic_load_n(&_head, __ATOMIC_ACQUIRE); }
+  uint16_t loadTail() const { return __atomic_load_n(&_tail, __ATOMIC_ACQUIRE); }
+  uint16_t advance(uint16_t pos, size_t n) const { return (pos + n) % (2*_size); }
+  uint16_t offsetOf(uint16_t pos) const { return pos < _size ? pos : pos - _size; }
+  uint16_t usedBetween(uint16_t head, uint16_t tail) const { return (tail + 2*_size - head) % (2*_size); }
+
+  void copyIn(uint16_t to, const uint8_t* src, size_t len) {
+    to = offsetOf(to);
+    size_t n = _size - to;     // contiguous space up to end of buffer
+    if (n > len) n = len;
+    memcpy(&_buf[to], src, n);
+    memcpy(_buf, &src[n], len - n);   // wrapped remainder (if any)
+  }
+  void copyOut(uint8_t* dest, uint16_t from, size_t len) const {
+    from = offsetOf(from);
+    size_t n = _size - from;
+    if (n > len) n = len;
+    memcpy(dest, &_buf[from], n);
+    memcpy(&dest[n], _buf, len - n);
+  }
+
+public:
+  FrameRing(int size) {   // NOTE: size must be less than 32K
+    _buf = new uint8_t[size];
+    _size = size;
+    clear();
+  }
+  ~FrameRing() { delete[] _buf; }
+
+  FrameRing(const FrameRing&) = delete;              // owns _buf
+  FrameRing& operator=(const FrameRing&) = delete;
+
+  void clear() { _head = _tail = 0; _frames_in = _frames_out = 0; }
+
+  int count() const { return (uint16_t) (_frames_in - _frames_out); }
+  bool isEmpty() const { return loadHead() == loadTail(); }
+  int bytesUsed() const { return usedBetween(loadHead(), loadTail()); }
+  int bytesFree() const { return _size - bytesUsed(); }
+
+  /**
+   * \returns  true, if a frame of 'len' bytes can currently be queued.
+   */
+  bool canFit(size_t len) const { return len + 1 <= (size_t) bytesFree(); }
+
+  /**
+   * \brief  appends a frame to tail of queue. (producer only)
+   * \returns  false, if there is not enough free space (frame is dropped)
+   */
+  bool push(const uint8_t src[], size_t len) {
+    if (len == 0 || len > 0xFF || !canFit(len)) return false;
+    uint16_t tail = _tail;
+    uint8_t l = len;
+    copyIn(tail, &l, 1);
+    copyIn(advance(tail, 1), src, len);
+    __atomic_store_n(&_tail, advance(tail, 1 + len), __ATOMIC_RELEASE);   // publish, only once frame is written
+
+    _frames_in++;
+    return true;
+  }
+
+  /**
+   * \returns  length of frame at head of queue, or zero if empty.
+   */
+  size_t peekLen() const { return isEmpty() ? 0 : _buf[offsetOf(_head)]; }
+
+  /**
+   * \brief  copies frame at head of queue into 'dest', without removing it.
+   * \returns  the frame length, or zero if empty.
+   */
+  size_t peek(uint8_t dest[]) const {
+    size_t len = peekLen();
+    if (len > 0) copyOut(dest, advance(_head, 1), len);
+    return len;
+  }
+
+  /**
+   * \brief  removes frame at head of queue. (eg. after a successful peek() + send)
+   */
+  void drop() {
+    size_t len = peekLen();
+    if (len == 0) return;
+    __atomic_store_n(&_head, advance(_head, 1 + len), __ATOMIC_RELEASE);   // space can now be re-used by push()
+    _frames_out++;
+  }
+
+  /**
+   * \brief  removes frame at head of queue, copying it into 'dest'.
+   * \returns  the frame length, or zero if empty.
+   */
+  size_t pop(uint8_t dest[]) {
+    size_t len = peek(dest);
+    if (len > 0) drop();
+    return len;
+  }
+};
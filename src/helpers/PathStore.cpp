@@ -0,0 +1,144 @@
+#include "PathStore.h"
+
+// cost weights, lower total cost is better
+#define COST_PER_HOP          100
+#define COST_PER_FAILURE      250
+#define BONUS_PER_SUCCESS      20   // max 4 counted
+#define COST_PER_LATENCY_MS  (1.0f/20)
+#define EST_LATENCY_PER_HOP  1000   // millis, assumed round trip until measured
+#define COST_PER_WEAK_SNR      10   // per 1dB the worst hop is below 0 dB SNR
+#define COST_PER_AGE_MINUTE     1   // tie-breaker, max 60 (ie. prefer fresher)
+
+PathStore::PeerPaths* PathStore::findPeer(const uint8_t* pub_key) {
+  for (int i = 0; i < PATH_STORE_PEERS; i++) {
+    if (_peers[i].last_used && memcmp(_peers[i].key_prefix, pub_key, sizeof(_peers[i].key_prefix)) == 0) return &_peers[i];
+  }
+  return NULL;
+}
+
+PathCandidate* PathStore::findPath(PeerPaths* peer, const uint8_t* path, uint8_t path_len) {
+  for (int i = 0; i < PATH_STORE_PER_PEER; i++) {
+    auto c = &peer->paths[i];
+    if (c->path_len == path_len && memcmp(c->path, path, path_len) == 0) return c;
+  }
+  return NULL;
+}
+
+int PathStore::calcCost(const PathCandidate& c, unsigned long now) {
+  int cost = c.path_len * COST_PER_HOP + c.failures * COST_PER_FAILURE;
+  cost -= (c.successes > 4 ? 4 : c.successes) * BONUS_PER_SUCCESS;
+  uint32_t latency = c.rtt.hasSamples() ? c.rtt.srtt : EST_LATENCY_PER_HOP * (c.path_len + 1);
+  cost += (int) (latency * COST_PER_LATENCY_MS);
+  if (c.min_snr != PATH_SNR_UNKNOWN && c.min_snr < 0) {
+    cost += (-c.min_snr / 4) * COST_PER_WEAK_SNR;
+  }
+  unsigned long age_mins = (now - c.last_update) / 60000;
+  cost += (age_mins > 60 ? 60 : age_mins) * COST_PER_AGE_MINUTE;
+  return cost;
+}
+
+void PathStore::addPath(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len, unsigned long now) {
+  if (path_len > MAX_PATH_SIZE) return;
+
+  PeerPaths* peer = findPeer(pub_key);
+  if (peer == NULL) {   // evict least recently used
+    peer = &_peers[0];
+    for (int i = 1; i < PATH_STORE_PEERS; i++) {
+      if (_peers[i].last_used < peer->last_used) peer = &_peers[i];
+    }
+    memset(peer, 0, sizeof(*peer));
+    memcpy(peer->key_prefix, pub_key, sizeof(peer->key_prefix));
+    for (int i = 0; i < PATH_STORE_PER_PEER; i++) peer->paths[i].path_len = -1;
+  }
+  peer->last_used = now ? now : 1;
+
+  PathCandidate* c = findPath(peer, path, path_len);
+  if (c) {
+    c->failures = 0;   // peer says this path works (again)
+    c->last_update = now;
+    return;
+  }
+
+  // find empty slot, or the worst candidate to replace
+  c = &peer->paths[0];
+  int worst = -0x7FFFFFFF;
+  for (int i = 0; i < PATH_STORE_PER_PEER; i++) {
+    auto p = &peer->paths[i];
+    if (p->path_len < 0) { c = p; break; }
+    int cost = calcCost(*p, now);
+    if (cost > worst) { worst = cost; c = p; }
+  }
+  memcpy(c->path, path, c->path_len = path_len);
+  c->min_snr = PATH_SNR_UNKNOWN;
+  c->successes = c->failures = 0;
+  c->rtt.reset();
+  c->last_update = now;
+}
+
+int PathStore::selectBest(const uint8_t* pub_key, uint8_t* dest_path, unsigned long now) {
+  PeerPaths* peer = findPeer(pub_key);
+  if (peer == NULL) return -1;
+
+  PathCandidate* best = NULL;
+  int best_cost = 0;
+  for (int i = 0; i < PATH_STORE_PER_PEER; i++) {
+    auto p = &peer->paths[i];
+    if (p->path_len < 0 || p->failures >= PATH_MAX_FAILURES) continue;
+
+    int cost = calcCost(*p, now);
+    if (best == NULL || cost < best_cost) { best = p; best_cost = cost; }
+  }
+  if (best == NULL) return -1;
+
+  peer->last_used = now ? now : 1;
+  memcpy(dest_path, best->path, best->path_len);
+  return best->path_len;
+}
+
+void PathStore::onSuccess(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len, uint32_t round_trip_millis, unsigned long now) {
+  PeerPaths* peer = findPeer(pub_key);
+  PathCandidate* c = peer ? findPath(peer, path, path_len) : NULL;
+  if (c == NULL) return;
+
+  if (c->successes < 0xFF) c->successes++;
+  c->failures = 0;
+  c->rtt.addSample(round_trip_millis);
+  c->last_update = now;
+}
+
+RTTEstimator PathStore::getRTT(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len) {
+  PeerPaths* peer = findPeer(pub_key);
+  PathCandidate* c = peer ? findPath(peer, path, path_len) : NULL;
+  return c ? c->rtt : RTTEstimator();
+}
+
+int PathStore::onFailure(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len, uint8_t* dest_path, unsigned long now) {
+  PeerPaths* peer = findPeer(pub_key);
+  PathCandidate* c = peer ? findPath(peer, path, path_len) : NULL;
+  if (c && c->failures < 0xFF) c->failures++;
+
+  return selectBest(pub_key, dest_path, now);
+}
+
+void PathStore::onTraceResult(const uint8_t* path, uint8_t path_len, const int8_t* hop_snrs) {
+  for (int i = 0; i < PATH_STORE_PEERS; i++) {
+    if (_peers[i].last_used == 0) continue;
+
+    for (int k = 0; k < PATH_STORE_PER_PEER; k++) {
+      auto c = &_peers[i].paths[k];
+      // trace is usually a round trip, so match candidates which are a prefix of the traced path
+      if (c->path_len <= 0 || c->path_len > path_len || memcmp(c->path, path, c->path_len) != 0) continue;
+
+      int8_t min_snr = 127;
+      for (int h = 0; h < c->path_len; h++) {
+        if (hop_snrs[h] < min_snr) min_snr = hop_snrs[h];
+      }
+      c->min_snr = min_snr;
+    }
+  }
+}
+
+void PathStore::forget(const uint8_t* pub_key) {
+  PeerPaths* peer = findPeer(pub_key);
+  if (peer) peer->last_used = 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Mesh.h>
+#include <helpers/RTTEstimator.h>
+
+#ifndef PATH_STORE_PEERS
+  #define PATH_STORE_PEERS       8    // peers with candidate paths (least recently used is evicted)
+#endif
+
+#ifndef PATH_STORE_PER_PEER
+  #define PATH_STORE_PER_PEER    3    // candidate paths per peer
+#endif
+
+#define PATH_MAX_FAILURES      2    // consecutive ACK timeouts before a candidate is no longer selected
+#define PATH_SNR_UNKNOWN    -128
+
+struct PathCandidate {
+  int8_t path_len;     // -1 = unused slot
+  uint8_t path[MAX_PATH_SIZE];
+  int8_t min_snr;      // worst hop SNR (x4), from a TRACE along this path, or PATH_SNR_UNKNOWN
+  uint8_t successes;   // ACKs received (saturates)
+  uint8_t failures;    // consecutive ACK timeouts
+  RTTEstimator rtt;    // ACK round trips
+  unsigned long last_update;
+};
+
+/**
+ * \brief  Keeps a few candidate out_paths for recently active peers (contacts or clients), with metrics, so the best
+ *         can be chosen and, on ACK timeout, the next best tried instead of falling straight back to flood.
+ *         The 'current' path still lives in the peer's own out_path[] (persisted as before); this table is RAM only.
+ */
+class PathStore {
+  struct PeerPaths {
+    uint8_t key_prefix[4];
+    unsigned long last_used;   // 0 = unused slot
+    PathCandidate paths[PATH_STORE_PER_PEER];
+  };
+  PeerPaths _peers[PATH_STORE_PEERS];
+
+  PeerPaths* findPeer(const uint8_t* pub_key);
+  PathCandidate* findPath(PeerPaths* peer, const uint8_t* path, uint8_t path_len);
+  static int calcCost(const PathCandidate& c, unsigned long now);
+
+public:
+  PathStore() { memset(_peers, 0, sizeof(_peers)); }
+
+  /**
+   * \brief  add a newly learned path (eg. from a PATH packet), or refresh it if already known.
+   *         May replace the worst candidate if this peer's table is full.
+   */
+  void addPath(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len, unsigned long now);
+
+  /**
+   * \brief  copies the best (lowest cost) usable candidate to 'dest_path'
+   * \returns  path length, or -1 if no usable candidates
+   */
+  int selectBest(const uint8_t* pub_key, uint8_t* dest_path, unsigned long now);
+
+  /**
+   * \brief  record an ACK received via the given path
+   */
+  void onSuccess(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len, uint32_t round_trip_millis, unsigned long now);
+
+  /**
+   * \returns  ACK round trip estimate for the given path (no samples, if unknown)
+   */
+  RTTEstimator getRTT(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len);
+
+  /**
+   * \brief  record an ACK timeout via the given path, then select the next best (same as selectBest())
+   */
+  int onFailure(const uint8_t* pub_key, const uint8_t* path, uint8_t path_len, uint8_t* dest_path, unsigned long now);
+
+  /**
+   * \brief  record per-hop SNRs (x4) from a TRACE along 'path' (1 byte hashes), for all candidates which are a prefix of it
+   */
+  void onTraceResult(const uint8_t* path, uint8_t path_len, const int8_t* hop_snrs);
+
+  /**
+   * \brief  forget all candidates for a peer (eg. when its path is reset)
+   */
+  void forget(const uint8_t* pub_key);
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * \brief  Jacobson/Karels round trip estimator (as in TCP, RFC 6298): smoothed RTT plus mean deviation, from which a
+ *         timeout is derived that adapts to the actual queuing delays along a path, not just its airtime.
+ */
+struct RTTEstimator {
+  uint16_t srtt = 0;     // smoothed round trip (millis), 0 = no samples yet
+  uint16_t rttvar = 0;   // mean deviation (millis)
+
+  bool hasSamples() const { return srtt != 0; }
+  void reset() { srtt = rttvar = 0; }
+
+  void addSample(uint32_t rtt_millis) {
+    if (rtt_millis == 0) rtt_millis = 1;
+    if (rtt_millis > 0xFFFF) rtt_millis = 0xFFFF;
+
+    if (srtt == 0) {   // first sample
+      srtt = rtt_millis;
+      rttvar = rtt_millis / 2;
+    } else {
+      uint32_t err = rtt_millis > srtt ? rtt_millis - srtt : srtt - rtt_millis;
+      rttvar = (rttvar * 3 + err) / 4;        // beta = 1/4
+      srtt = (srtt * 7 + rtt_millis) / 8;     // alpha = 1/8
+    }
+  }
+
+  /**
+   * \returns  srtt + 4 x rttvar, or 0 if no samples yet
+   */
+  uint32_t getTimeout() const { return srtt ? (uint32_t)srtt + 4 * (uint32_t)rttvar : 0; }
+};
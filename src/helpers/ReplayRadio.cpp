@@ -0,0 +1,157 @@
+#include "ReplayRadio.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+ReplayRadio::ReplayRadio(Stream& capture, mesh::MillisecondClock& ms, Stream* tx_log)
+    : _capture(&capture), _tx_log(tx_log), _ms(&ms) {
+  _speed = 1.0f;
+  setParams(250, 10, 5);
+  _has_next = _eof = _started = _sending = false;
+  _last_snr = _last_rssi = 0;
+  n_replayed = n_dropped = n_sent = n_bad_lines = 0;
+  total_tx_airtime = 0;
+}
+
+void ReplayRadio::setParams(float bw, uint8_t sf, uint8_t cr, uint16_t preamble_len) {
+  _bw = bw; _sf = sf; _cr = cr; _preamble_len = preamble_len;
+  _snr_floor = (sf >= 7 && sf <= 12) ? -7.5f - 2.5f*(sf - 7) : 1000.0f;   // same as RadioLibWrapper
+}
+
+void ReplayRadio::begin() {
+  readNextFrame();
+}
+
+static int hexVal(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+bool ReplayRadio::readNextFrame() {
+  char line[REPLAY_MAX_LINE];
+  _has_next = false;
+  while (!_eof) {
+    int len = 0, c;
+    bool truncated = false;
+    while ((c = _capture->read()) >= 0 && c != '\n') {
+      if (len < sizeof(line) - 1) line[len++] = c; else truncated = true;
+    }
+    if (c < 0) _eof = true;
+    line[len] = 0;
+
+    if (len == 0 || line[0] == '#' || line[0] == '\r') continue;   // skip blank and comment lines
+
+    char* sp;
+    _next_time = strtoul(line, &sp, 10);
+    _next_snr = strtod(sp, &sp);
+    _next_rssi = strtod(sp, &sp);
+    while (*sp == ' ') sp++;
+
+    int n = 0;
+    while (n < sizeof(_next_raw)) {
+      int hi = hexVal(sp[0]), lo = hi < 0 ? -1 : hexVal(sp[1]);
+      if (lo < 0) break;
+      _next_raw[n++] = (hi << 4) | lo;
+      sp += 2;
+    }
+    if (truncated || n < 2 || n > MAX_TRANS_UNIT) {
+      n_bad_lines++;
+      continue;
+    }
+    _next_len = n;
+    _has_next = true;
+
+    if (!_started) {   // replay is relative to first frame
+      _started = true;
+      _first_time = _next_time;
+      _start_millis = _ms->getMillis();
+    }
+    break;
+  }
+  return _has_next;
+}
+
+unsigned long ReplayRadio::toClockMillis(unsigned long capture_time) const {
+  return _start_millis + (unsigned long) ((capture_time - _first_time) / _speed);
+}
+
+unsigned long ReplayRadio::getNextEventMillis() {
+  unsigned long t = 0xFFFFFFFF;
+  if (_has_next) t = toClockMillis(_next_time);
+  if (_sending && _tx_end < t) t = _tx_end;
+  return t;
+}
+
+int ReplayRadio::recvRaw(uint8_t* bytes, int sz) {
+  if (!_has_next) return 0;
+
+  unsigned long now = _ms->getMillis();
+  while (_has_next && (long)(now - toClockMillis(_next_time)) >= 0) {   // frame is due
+    if (_sending || _next_len > sz) {
+      n_dropped++;   // can't hear while transmitting
+      readNextFrame();
+      continue;
+    }
+    int len = _next_len;
+    memcpy(bytes, _next_raw, len);
+    _last_snr = _next_snr;
+    _last_rssi = _next_rssi;
+    n_replayed++;
+    readNextFrame();
+    return len;
+  }
+  return 0;
+}
+
+uint32_t ReplayRadio::getEstAirtimeFor(int len_bytes) {
+  // Semtech LoRa time-on-air (explicit header, CRC on)
+  float t_sym = (float)(1UL << _sf) / _bw;   // millis
+  int de = t_sym > 16.0f ? 1 : 0;   // low data rate optimise
+  float num = 8.0f*len_bytes - 4.0f*_sf + 28 + 16;
+  float n_payload = 8 + fmaxf(ceilf(num / (4.0f*(_sf - 2*de))) * _cr, 0);
+  return (uint32_t) ((_preamble_len + 4.25f + n_payload) * t_sym);
+}
+
+float ReplayRadio::packetScore(float snr, int packet_len) {
+  if (snr < _snr_floor) return 0.0f;
+
+  float score = (snr - _snr_floor) * 0.1f * (1.0f - packet_len * (1.0f / 256.0f));
+  return score < 0.0f ? 0.0f : (score > 1.0f ? 1.0f : score);
+}
+
+bool ReplayRadio::startSendRaw(const uint8_t* bytes, int len) {
+  unsigned long now = _ms->getMillis();
+  uint32_t airtime = getEstAirtimeFor(len);
+  _sending = true;
+  _tx_end = now + (unsigned long) (airtime / _speed);
+  n_sent++;
+  total_tx_airtime += airtime;
+
+  if (_tx_log) {
+    char tmp[48];
+    sprintf(tmp, "TX %lu %d %lu ", now, len, (unsigned long) airtime);
+    _tx_log->print(tmp);
+    mesh::Utils::printHex(*_tx_log, bytes, len);
+    _tx_log->println();
+  }
+  return true;
+}
+
+bool ReplayRadio::isSendComplete() {
+  return _sending && (long)(_ms->getMillis() - _tx_end) >= 0;
+}
+
+void ReplayRadio::onSendFinished() {
+  _sending = false;
+}
+
+void ReplayRadio::writeCaptureLine(Stream& out, unsigned long millis, float snr, float rssi, const uint8_t raw[], int len) {
+  char tmp[48];
+  int snr100 = (int) roundf(snr * 100);   // NOTE: avoiding %f, not supported by all printf() impls
+  sprintf(tmp, "%lu %s%d.%02d %d ", millis, snr100 < 0 ? "-" : "", abs(snr100) / 100, abs(snr100) % 100, (int)rssi);
+  out.print(tmp);
+  mesh::Utils::printHex(out, raw, len);
+  out.println();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Mesh.h>
+#include <Stream.h>
+
+#ifndef REPLAY_MAX_LINE
+  #define REPLAY_MAX_LINE   (32 + 2*(MAX_TRANS_UNIT+1))
+#endif
+
+/**
+ * \brief  A MillisecondClock which only moves when told to. For driving a Mesh deterministically, eg. with ReplayRadio.
+ */
+class VirtualMillis : public mesh::MillisecondClock {
+  unsigned long _now;
+public:
+  VirtualMillis(unsigned long start = 0) : _now(start) { }
+
+  unsigned long getMillis() override { return _now; }
+  void set(unsigned long millis) { _now = millis; }
+  void advance(unsigned long millis) { _now += millis; }
+};
+
+/**
+ * \brief  A Radio which replays received frames from a capture, and records every transmit (instead of going on air).
+ *    Capture is text, one frame per line:   <millis> <snr> <rssi> <hex of raw frame>     (lines starting with '#' ignored)
+ *    eg. as produced by writeCaptureLine() from a Dispatcher::logRxRaw() hook.
+ *    Frame times are relative to the first frame, and replayed against the given clock (a VirtualMillis for
+ *    deterministic/accelerated runs, or the real millis clock), optionally sped up by setSpeed().
+ *    Like a real (half-duplex) radio, frames which arrive while transmitting are dropped.
+ *    Each transmit is written to 'tx_log' (if given) as:   TX <millis> <len> <airtime> <hex of raw frame>
+ */
+class ReplayRadio : public mesh::Radio {
+  Stream* _capture;
+  Stream* _tx_log;
+  mesh::MillisecondClock* _ms;
+  float _speed;
+  uint8_t _sf, _cr;
+  float _bw;
+  uint16_t _preamble_len;
+  float _snr_floor;
+
+  // next frame from capture
+  bool _has_next, _eof;
+  unsigned long _next_time;     // as per capture
+  float _next_snr, _next_rssi;
+  uint8_t _next_raw[MAX_TRANS_UNIT+1];
+  int _next_len;
+
+  bool _started;
+  unsigned long _first_time, _start_millis;
+  float _last_snr, _last_rssi;
+
+  bool _sending;
+  unsigned long _tx_end;
+
+  uint32_t n_replayed, n_dropped, n_sent, n_bad_lines;
+  uint32_t total_tx_airtime;
+
+  bool readNextFrame();
+  unsigned long toClockMillis(unsigned long capture_time) const;
+
+public:
+  ReplayRadio(Stream& capture, mesh::MillisecondClock& ms, Stream* tx_log = NULL);
+
+  /**
+   * \brief  modulation params, for airtime estimates and packet scores. (default is sf=10, bw=250, cr=5)
+   */
+  void setParams(float bw, uint8_t sf, uint8_t cr, uint16_t preamble_len = 16);
+
+  /**
+   * \param speed  1.0 is real time, 10.0 is ten times faster, etc.
+   */
+  void setSpeed(float speed) { _speed = speed; }
+
+  /**
+   * \returns  true when capture is exhausted, and no transmit in progress
+   */
+  bool isFinished() const { return _eof && !_has_next && !_sending; }
+
+  /**
+   * \returns  clock millis when next thing will happen (next RX frame due, or TX complete), so a VirtualMillis
+   *           can be advanced straight there. NOTE: the Mesh may have its own timers due before this.
+   */
+  unsigned long getNextEventMillis();
+
+  uint32_t getNumReplayed() const { return n_replayed; }
+  uint32_t getNumDropped() const { return n_dropped; }   // arrived while transmitting
+  uint32_t getNumSent() const { return n_sent; }
+  uint32_t getNumBadLines() const { return n_bad_lines; }
+  uint32_t getTotalTxAirtime() const { return total_tx_airtime; }
+
+  static void writeCaptureLine(Stream& out, unsigned long millis, float snr, float rssi, const uint8_t raw[], int len);
+
+  void begin() override;
+  int recvRaw(uint8_t* bytes, int sz) override;
+  uint32_t getEstAirtimeFor(int len_bytes) override;
+  float packetScore(float snr, int packet_len) override;
+  bool startSendRaw(const uint8_t* bytes, int len) override;
+  bool isSendComplete() override;
+  void onSendFinished() override;
+  bool isInRecvMode() const override { return !_sending; }
+  float getLastRSSI() const override { return _last_rssi; }
+  float getLastSNR() const override { return _last_snr; }
+};
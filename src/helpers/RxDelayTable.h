@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#define RX_DELAY_TABLE_STEPS   32    // resolution of packet score (0.0 .. 1.0)
+
+/**
+ * \brief  Lookup table for the flood RX delay curve:  (base ^ (0.85 - score) - 1) * air_time.
+ *         Avoids a pow() per received flood packet. Table is only re-built when 'base' changes.
+ */
+class RxDelayTable {
+  mutable float _base;
+  mutable float _factor[RX_DELAY_TABLE_STEPS + 1];
+
+public:
+  RxDelayTable() : _base(0.0f) { }
+
+  int calcRxDelay(float base, float score, uint32_t air_time) const {
+    if (base != _base) {
+      _base = base;
+      for (int i = 0; i <= RX_DELAY_TABLE_STEPS; i++) {
+        _factor[i] = pow(base, 0.85f - (float)i / RX_DELAY_TABLE_STEPS) - 1.0f;
+      }
+    }
+    if (score <= 0.0f) return (int) (_factor[0] * air_time);
+    if (score >= 1.0f) return (int) (_factor[RX_DELAY_TABLE_STEPS] * air_time);
+
+    float pos = score * RX_DELAY_TABLE_STEPS;
+    int i = (int) pos;
+    float f = _factor[i] + (_factor[i + 1] - _factor[i]) * (pos - i);   // linear interpolate
+    return (int) (f * air_time);
+  }
+};
@@ -31,12 +31,19 @@ public:
     f.read((uint8_t *) &_next_idx, sizeof(_next_idx));
     f.read((uint8_t *) &_acks[0], sizeof(_acks));
     f.read((uint8_t *) &_next_ack_idx, sizeof(_next_ack_idx));
+
+    // restored hashes are only valid with the same fingerprint key (packets already fingerprinted are re-calculated)
+    uint8_t key[16];
+    if (f.read(key, sizeof(key)) == sizeof(key)) mesh::Packet::setFingerprintKey(key);
   }
   void saveTo(File f) {
     f.write(_hashes, sizeof(_hashes));
     f.write((const uint8_t *) &_next_idx, sizeof(_next_idx));
     f.write((const uint8_t *) &_acks[0], sizeof(_acks));
     f.write((const uint8_t *) &_next_ack_idx, sizeof(_next_ack_idx));
+    // NOTE: the fingerprint key is only kept secret so other nodes can't craft packets which collide in these tables.
+    //   This file is on local flash, with the node's private key, so anyone who can read it already has more than this.
+    f.write(mesh::Packet::getFingerprintKey(), 16);
   }
 #endif
 
@@ -61,7 +68,7 @@ public:
     }
 
     uint8_t hash[MAX_HASH_SIZE];
-    packet->calculatePacketHash(hash);
+    calcFingerprint(packet, hash);
 
     const uint8_t* sp = _hashes;
     for (int i = 0; i < MAX_PACKET_HASHES; i++, sp += MAX_HASH_SIZE) {
@@ -92,7 +99,7 @@ public:
       }
     } else {
       uint8_t hash[MAX_HASH_SIZE];
-      packet->calculatePacketHash(hash);
+      calcFingerprint(packet, hash);
 
       uint8_t* sp = _hashes;
       for (int i = 0; i < MAX_PACKET_HASHES; i++, sp += MAX_HASH_SIZE) {
@@ -0,0 +1,102 @@
+#include "StatsTLV.h"
+
+#define STATS_COUNTER_FIELDS  ((1UL << STATS_UPTIME_SECS) | (1UL << STATS_TX_AIR_SECS) | (1UL << STATS_RX_AIR_SECS) \
+                              | STATS_GROUP_PACKETS | STATS_GROUP_DUPS | STATS_GROUP_ROOM)
+#define STATS_SIGNED_FIELDS   ((1UL << STATS_NOISE_FLOOR) | (1UL << STATS_LAST_RSSI) | (1UL << STATS_LAST_SNR))
+
+StatsTLVEncoder::StatsTLVEncoder() {
+  memset(_snapshots, 0, sizeof(_snapshots));
+  _next_snapshot = 0;
+  _next_id = 1;
+}
+
+bool StatsTLVEncoder::isCounter(int field) {
+  return (STATS_COUNTER_FIELDS & (1UL << field)) != 0;
+}
+
+bool StatsTLVEncoder::isSigned(int field) {
+  return (STATS_SIGNED_FIELDS & (1UL << field)) != 0;
+}
+
+int StatsTLVEncoder::putVarInt(uint8_t* dest, uint32_t value) {
+  int n = 0;
+  while (value >= 0x80) {
+    dest[n++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  dest[n++] = value;
+  return n;
+}
+
+int StatsTLVEncoder::getVarInt(const uint8_t* src, int len, uint32_t& value) {
+  value = 0;
+  for (int i = 0; i < len && i < 5; i++) {
+    value |= (uint32_t)(src[i] & 0x7F) << (7*i);
+    if ((src[i] & 0x80) == 0) return i + 1;
+  }
+  return 0;  // truncated
+}
+
+const StatsTLVEncoder::Snapshot* StatsTLVEncoder::findSnapshot(uint8_t id, const uint8_t* requester) const {
+  if (id == 0) return NULL;
+  for (int i = 0; i < STATS_TLV_SNAPSHOTS; i++) {
+    if (_snapshots[i].id == id && memcmp(_snapshots[i].requester, requester, STATS_TLV_REQUESTER_PREFIX) == 0) {
+      return &_snapshots[i];
+    }
+  }
+  return NULL;   // too old, requester will get full values
+}
+
+int StatsTLVEncoder::encode(const uint32_t values[], uint32_t present, uint32_t field_mask, uint8_t base_id,
+                            const uint8_t* requester, uint8_t dest[], int max_len) {
+  if (max_len < 3) return 0;
+  if (field_mask == 0) field_mask = 0xFFFFFFFF;
+
+  const Snapshot* base = findSnapshot(base_id, requester);
+  if (base) {
+    for (int f = 0; f < STATS_NUM_FIELDS; f++) {
+      if (isCounter(f) && (base->known & (1UL << f)) && values[f] < base->values[f]) {
+        base = NULL;   // stats were cleared since, so increments would be wrong
+        break;
+      }
+    }
+  }
+
+  int len = 0;
+  dest[len++] = STATS_TLV_VERSION;
+  dest[len++] = _next_id;
+  dest[len++] = base ? base->id : 0;
+
+  uint32_t known = 0;   // fields requester will have values for, after this response
+  for (int f = 0; f < STATS_NUM_FIELDS; f++) {
+    if ((present & field_mask & (1UL << f)) == 0) continue;
+
+    uint32_t v = values[f];
+    if (base && (base->known & (1UL << f))) {
+      if (v == base->values[f]) {   // unchanged
+        known |= (1UL << f);
+        continue;
+      }
+      if (isCounter(f)) v -= base->values[f];
+    }
+    if (isSigned(f)) {
+      int32_t s = (int32_t) v;
+      v = ((uint32_t)s << 1) ^ (uint32_t)(s >> 31);   // zigzag
+    }
+    if (len + 1 + 5 > max_len) break;   // no room
+    dest[len++] = f;
+    len += putVarInt(&dest[len], v);
+    known |= (1UL << f);
+  }
+
+  // remember what was sent (after encoding, as this may overwrite the base)
+  Snapshot& snap = _snapshots[_next_snapshot];
+  _next_snapshot = (_next_snapshot + 1) % STATS_TLV_SNAPSHOTS;
+  snap.id = _next_id;
+  memcpy(snap.requester, requester, STATS_TLV_REQUESTER_PREFIX);
+  if (++_next_id == 0) _next_id = 1;   // 0 is reserved
+  snap.known = known;
+  memcpy(snap.values, values, sizeof(snap.values));
+
+  return len;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef STATS_TLV_SNAPSHOTS
+  #define STATS_TLV_SNAPSHOTS   4    // recent responses which can be used as a delta base (eg. a few admins polling)
+#endif
+
+// field tags, grouped as in docs/stats_binary_frames.md
+enum StatsField {
+  // core
+  STATS_BATTERY_MV = 0,
+  STATS_UPTIME_SECS,
+  STATS_ERRORS,
+  STATS_QUEUE_LEN,
+  // radio
+  STATS_NOISE_FLOOR,
+  STATS_LAST_RSSI,
+  STATS_LAST_SNR,         // x 4
+  STATS_TX_AIR_SECS,
+  STATS_RX_AIR_SECS,
+  // packets
+  STATS_RECV,
+  STATS_SENT,
+  STATS_FLOOD_TX,
+  STATS_DIRECT_TX,
+  STATS_FLOOD_RX,
+  STATS_DIRECT_RX,
+  STATS_RECV_ERRORS,
+  // extra
+  STATS_DIRECT_DUPS,
+  STATS_FLOOD_DUPS,
+  STATS_POSTED,           // room server
+  STATS_POST_PUSHES,      // room server
+  STATS_NUM_FIELDS        // keep as last
+};
+
+#define STATS_GROUP_CORE      0x0000000F
+#define STATS_GROUP_RADIO     0x000001F0
+#define STATS_GROUP_PACKETS   0x0000FE00
+#define STATS_GROUP_DUPS      0x00030000
+#define STATS_GROUP_ROOM      0x000C0000
+
+#define STATS_TLV_VERSION     0
+
+#define STATS_TLV_REQUESTER_PREFIX   4   // bytes of requester's pub_key that snapshots are keyed by
+
+/**
+ * \brief  Encodes node stats as compact TLVs (tag byte + varint value) for remote admin responses, instead of
+ *         a fixed struct or CLI text. Requester can select fields, and ask for a delta against one of its previous
+ *         responses (by snapshot id): then unchanged fields are left out, and counters are sent as increments.
+ *         Signed values are zigzag encoded. Snapshots are keyed by requester, so a stale base id from one
+ *         requester can't pick up another's snapshot (which would give wrong increments).
+ */
+class StatsTLVEncoder {
+  struct Snapshot {
+    uint8_t id;          // 0 = unused
+    uint8_t requester[STATS_TLV_REQUESTER_PREFIX];
+    uint32_t known;      // fields the requester has values for
+    uint32_t values[STATS_NUM_FIELDS];
+  };
+
+  Snapshot _snapshots[STATS_TLV_SNAPSHOTS];
+  int _next_snapshot;
+  uint8_t _next_id;
+
+  const Snapshot* findSnapshot(uint8_t id, const uint8_t* requester) const;
+
+public:
+  StatsTLVEncoder();
+
+  static bool isCounter(int field);
+  static bool isSigned(int field);
+
+  static int putVarInt(uint8_t* dest, uint32_t value);
+  static int getVarInt(const uint8_t* src, int len, uint32_t& value);
+
+  /**
+   * \param  values  indexed by StatsField (signed values cast to uint32_t)
+   * \param  present  bit per field which this node has
+   * \param  field_mask  bit per field requested (0 = all)
+   * \param  base_id  snapshot id of a previous response to encode a delta against (0 = send full values)
+   * \param  requester  pub_key of who is asking. 'base_id' must be a response to the same requester
+   * \returns  length written to 'dest', which is:  version(1), snapshot id(1), base id(1, 0 = not a delta), TLVs...
+   */
+  int encode(const uint32_t values[], uint32_t present, uint32_t field_mask, uint8_t base_id,
+             const uint8_t* requester, uint8_t dest[], int max_len);
+};
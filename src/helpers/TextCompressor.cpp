@@ -0,0 +1,147 @@
+#include "TextCompressor.h"
+#include <string.h>
+
+// symbols 0..94 are the printable chars ' '..'~'
+#define SYM_NEWLINE    95
+#define SYM_ESCAPE     96    // next 8 bits are a raw byte
+#define SYM_EOM        97
+#define NUM_SYMBOLS    98
+
+#define MAX_CODE_LEN   13
+
+// code length of each symbol, from char frequencies of English chat text (never change, is the on-air format)
+static const uint8_t code_lens[NUM_SYMBOLS] = {
+   3,  8, 11, 11, 12, 12, 12,  8, 11, 10, 12, 12,  8,  9,  7, 10,   //  !"#$%&'()*+,-./
+   8,  8,  8,  9,  9,  9,  9, 10,  9, 10,  8, 12, 12, 12, 12,  8,   // 0123456789:;<=>?
+  11,  9, 10, 10, 10, 10, 10, 10,  9,  7, 11, 10, 10,  9, 10,  9,   // @ABCDEFGHIJKLMNO
+  10, 12, 10,  9,  9, 11, 11,  9, 12, 11, 12, 12, 13, 12, 13, 11,   // PQRSTUVWXYZ[\]^_
+  13,  4,  7,  6,  5,  4,  6,  6,  5,  4, 10,  7,  5,  6,  4,  4,   // `abcdefghijklmno
+   6, 10,  4,  4,  4,  5,  7,  6,  9,  6, 10, 13, 13, 13, 12,       // pqrstuvwxyz{|}~
+  11, 11,  6                                                        // newline, escape, EOM
+};
+
+// canonical code tables, built on first use
+static uint16_t codes[NUM_SYMBOLS];
+static uint16_t first_code[MAX_CODE_LEN+1];   // code of first symbol with each length
+static uint8_t first_idx[MAX_CODE_LEN+1];     // index of that symbol in sorted_syms[]
+static uint8_t len_count[MAX_CODE_LEN+1];
+static uint8_t sorted_syms[NUM_SYMBOLS];      // by (code length, symbol)
+static bool tables_ready = false;
+
+static void buildTables() {
+  int idx = 0;
+  uint16_t code = 0;
+  for (int n = 1; n <= MAX_CODE_LEN; n++) {
+    first_code[n] = code;
+    first_idx[n] = idx;
+    len_count[n] = 0;
+    for (int s = 0; s < NUM_SYMBOLS; s++) {
+      if (code_lens[s] == n) {
+        codes[s] = code++;
+        sorted_syms[idx++] = s;
+        len_count[n]++;
+      }
+    }
+    code <<= 1;
+  }
+  tables_ready = true;
+}
+
+class BitWriter {
+  uint8_t* _dest;
+  int _max_bits, _pos;
+public:
+  BitWriter(uint8_t* dest, int max_len) : _dest(dest), _max_bits(max_len * 8), _pos(0) { memset(dest, 0, max_len); }
+
+  bool put(uint16_t bits, int n) {   // MSB first
+    if (_pos + n > _max_bits) return false;
+    while (n > 0) {
+      n--;
+      if ((bits >> n) & 1) _dest[_pos >> 3] |= 0x80 >> (_pos & 7);
+      _pos++;
+    }
+    return true;
+  }
+  int getLength() const { return (_pos + 7) >> 3; }
+};
+
+class BitReader {
+  const uint8_t* _src;
+  int _num_bits, _pos;
+public:
+  BitReader(const uint8_t* src, int len) : _src(src), _num_bits(len * 8), _pos(0) { }
+
+  int get() {   // -1 = end of data
+    if (_pos >= _num_bits) return -1;
+    int b = (_src[_pos >> 3] >> (7 - (_pos & 7))) & 1;
+    _pos++;
+    return b;
+  }
+};
+
+static bool putSymbol(BitWriter& out, int sym) {
+  return out.put(codes[sym], code_lens[sym]);
+}
+
+int TextCompressor::compress(const char* text, int text_len, uint8_t dest[], int max_len) {
+  if (!tables_ready) buildTables();
+
+  BitWriter out(dest, max_len);
+  for (int i = 0; i < text_len; i++) {
+    uint8_t c = text[i];
+    bool ok;
+    if (c >= ' ' && c <= '~') {
+      ok = putSymbol(out, c - ' ');
+    } else if (c == '\n') {
+      ok = putSymbol(out, SYM_NEWLINE);
+    } else {
+      ok = putSymbol(out, SYM_ESCAPE) && out.put(c, 8);
+    }
+    if (!ok) return 0;   // too long
+  }
+  if (!putSymbol(out, SYM_EOM)) return 0;
+  return out.getLength();
+}
+
+int TextCompressor::decompress(const uint8_t src[], int src_len, char dest[], int max_len) {
+  if (!tables_ready) buildTables();
+
+  BitReader in(src, src_len);
+  int len = 0;
+  for (;;) {
+    int sym = -1;
+    int code = 0;
+    for (int n = 1; n <= MAX_CODE_LEN; n++) {
+      int b = in.get();
+      if (b < 0) return -1;   // no EOM
+      code = (code << 1) | b;
+      int d = code - first_code[n];
+      if (d >= 0 && d < len_count[n]) {
+        sym = sorted_syms[first_idx[n] + d];
+        break;
+      }
+    }
+    if (sym < 0) return -1;   // invalid code
+    if (sym == SYM_EOM) break;
+
+    uint8_t c;
+    if (sym == SYM_ESCAPE) {
+      int raw = 0;
+      for (int i = 0; i < 8; i++) {
+        int b = in.get();
+        if (b < 0) return -1;
+        raw = (raw << 1) | b;
+      }
+      if (raw == 0) return -1;   // would truncate the C string
+      c = raw;
+    } else if (sym == SYM_NEWLINE) {
+      c = '\n';
+    } else {
+      c = ' ' + sym;
+    }
+    if (len + 1 >= max_len) return -1;   // no room
+    dest[len++] = c;
+  }
+  dest[len] = 0;
+  return len;
+}
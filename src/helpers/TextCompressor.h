@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * \brief  Compresses short chat text for TXT_TYPE_COMPRESSED payloads, with a static (canonical) Huffman code tuned
+ *         for English chat: printable ASCII and '\n' have their own codes (space = 3 bits, common letters 4..6 bits),
+ *         other bytes (eg. UTF-8) are escaped and sent raw. As the cipher pads payloads with zeroes, the stream ends
+ *         with an end-of-message code.
+ *         The code table is fixed, and part of the on-air format, so must NOT be changed.
+ */
+class TextCompressor {
+public:
+  /**
+   * \returns  length of compressed data in 'dest', or 0 if it won't fit in 'max_len'
+   */
+  static int compress(const char* text, int text_len, uint8_t dest[], int max_len);
+
+  /**
+   * \param  dest  receives the text, null terminated
+   * \returns  length of text, or -1 if 'src' is not valid, or text won't fit in 'max_len'
+   */
+  static int decompress(const uint8_t src[], int src_len, char dest[], int max_len);
+};
@@ -0,0 +1,268 @@
+#include "UDPBridge.h"
+
+#ifdef WITH_UDP_BRIDGE
+
+#include <ChaChaPoly.h>
+#include <SHA256.h>
+
+#define MAX_RX_PER_LOOP   4    // don't starve the mesh loop if the LAN is busy
+
+UDPBridge::UDPBridge(NodePrefs *prefs, mesh::PacketManager *mgr, mesh::RTCClock *rtc)
+    : BridgeBase(prefs, mgr, rtc), _udp_open(false), _sender_id(0), _next_seq(0), _tx_len(0), _tx_flush_at(0),
+      _epoch(0), _next_epoch_tick(0), _n_rx_stale(0) {
+  memset(_peers, 0, sizeof(_peers));
+}
+
+void UDPBridge::computeKey() {
+  SHA256 sha;
+  sha.update(_prefs->bridge_secret, strnlen(_prefs->bridge_secret, sizeof(_prefs->bridge_secret)));
+  sha.finalize(_key, sizeof(_key));
+}
+
+void UDPBridge::begin() {
+  BRIDGE_DEBUG_PRINTLN("Initializing...\n");
+
+  computeKey();
+  do {
+    _sender_id = esp_random();
+  } while (_sender_id == 0);   // zero marks an unused peer slot
+  _next_seq = 0;
+  _tx_len = 0;
+  memset(_peers, 0, sizeof(_peers));
+  _epoch = 0;   // until we hear the current one from another bridge
+  _next_epoch_tick = millis() + UDP_BRIDGE_EPOCH_MILLIS;
+  _n_rx_stale = 0;
+
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PWD);   // socket is opened in loop(), once connected
+
+  _initialized = true;
+}
+
+void UDPBridge::end() {
+  BRIDGE_DEBUG_PRINTLN("Stopping...\n");
+
+  if (_udp_open) {
+    _udp.stop();
+    _udp_open = false;
+  }
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+
+  memset(_key, 0, sizeof(_key));
+  _initialized = false;
+}
+
+void UDPBridge::loop() {
+  if (!_initialized) return;
+
+  if ((long)(millis() - _next_epoch_tick) >= 0) {
+    _epoch++;
+    _next_epoch_tick += UDP_BRIDGE_EPOCH_MILLIS;
+  }
+
+  if (WiFi.status() != WL_CONNECTED) {
+    if (_udp_open) {
+      BRIDGE_DEBUG_PRINTLN("WiFi lost\n");
+      _udp.stop();
+      _udp_open = false;
+      _tx_len = 0;   // discard, packets are stale by the time we reconnect
+    }
+    return;
+  }
+  if (!_udp_open) {
+    if (!_udp.beginMulticast(IPAddress(UDP_BRIDGE_GROUP), UDP_BRIDGE_PORT)) {
+      BRIDGE_DEBUG_PRINTLN("Error joining multicast group\n");
+      return;
+    }
+    BRIDGE_DEBUG_PRINTLN("Listening on port %d\n", UDP_BRIDGE_PORT);
+    _udp_open = true;
+  }
+
+  for (int i = 0; i < MAX_RX_PER_LOOP && _udp.parsePacket() > 0; i++) {
+    checkRecv();
+  }
+
+  if (_tx_len > 0 && (long)(millis() - _tx_flush_at) >= 0) {
+    flush();
+  }
+}
+
+static void writeBE32(uint8_t* dest, uint32_t val) {
+  dest[0] = (val >> 24) & 0xFF;
+  dest[1] = (val >> 16) & 0xFF;
+  dest[2] = (val >> 8) & 0xFF;
+  dest[3] = val & 0xFF;
+}
+
+static uint32_t readBE32(const uint8_t* src) {
+  return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+bool UDPBridge::acceptSequence(uint32_t sender_id, uint32_t seq, uint32_t epoch) {
+  PeerWindow *p = NULL;
+  PeerWindow *oldest = &_peers[0];
+  for (int i = 0; i < UDP_BRIDGE_MAX_PEERS; i++) {
+    if (_peers[i].sender_id == sender_id) {
+      p = &_peers[i];
+      break;
+    }
+    if (_peers[i].last_heard < oldest->last_heard) oldest = &_peers[i];
+  }
+  unsigned long now = millis();
+
+  if (p == NULL) {   // new sender (or peer rebooted, or evicted)
+    // nothing to check seq against, so could be a replay of an old datagram. Only accept if recent
+    if (epoch + UDP_BRIDGE_EPOCH_SLACK < _epoch) {
+      _n_rx_stale++;
+      MESH_DEBUG_PRINTLN("UDPBridge: dropped datagram from new sender, stale epoch %u (ours=%u, dropped=%u)", epoch, _epoch, _n_rx_stale);
+      return false;
+    }
+
+    p = oldest;   // evict least recently heard
+    p->sender_id = sender_id;
+    p->max_seq = seq;
+    p->bitmap = 1;
+    p->last_heard = now;
+    return true;
+  }
+
+  if (seq > p->max_seq) {
+    uint32_t shift = seq - p->max_seq;
+    p->bitmap = shift >= 32 ? 1 : (p->bitmap << shift) | 1;
+    p->max_seq = seq;
+  } else {
+    uint32_t age = p->max_seq - seq;
+    if (age >= 32 || (p->bitmap & (1UL << age))) {
+      return false;   // too old, or a replay
+    }
+    p->bitmap |= (1UL << age);
+  }
+  p->last_heard = now;
+  return true;
+}
+
+void UDPBridge::checkRecv() {
+  uint8_t buf[UDP_BRIDGE_MAX_DATAGRAM];
+  int len = _udp.read(buf, sizeof(buf));
+
+  if (len < (int)(HEADER_SIZE + TAG_SIZE + 2)) {
+    BRIDGE_DEBUG_PRINTLN("RX datagram too small, len=%d\n", len);
+    return;
+  }
+
+  uint16_t received_magic = (buf[0] << 8) | buf[1];
+  if (received_magic != BRIDGE_PACKET_MAGIC) {
+    BRIDGE_DEBUG_PRINTLN("RX invalid magic 0x%04X\n", received_magic);
+    return;
+  }
+
+  uint32_t sender_id, seq, epoch;
+  memcpy(&sender_id, &buf[2], 4);
+  seq = readBE32(&buf[6]);
+  epoch = readBE32(&buf[10]);
+  if (sender_id == _sender_id || sender_id == 0) return;   // our own, looped back by multicast
+
+  uint8_t frames[MAX_FRAMES_SIZE];
+  size_t frames_len = len - HEADER_SIZE - TAG_SIZE;
+
+  ChaChaPoly cipher;
+  cipher.setKey(_key, sizeof(_key));
+  cipher.setIV(&buf[2], 8);   // nonce is (sender_id, seq)
+  cipher.addAuthData(buf, HEADER_SIZE);
+  cipher.decrypt(frames, &buf[HEADER_SIZE], frames_len);
+  bool valid = cipher.checkTag(&buf[HEADER_SIZE + frames_len], TAG_SIZE);
+  cipher.clear();
+
+  if (!valid) {
+    // likely from a different network (different secret)
+    BRIDGE_DEBUG_PRINTLN("RX auth failed, len=%d\n", len);
+    return;
+  }
+  if (!acceptSequence(sender_id, seq, epoch)) {
+    BRIDGE_DEBUG_PRINTLN("RX replayed seq=%u\n", seq);
+    return;
+  }
+  if (epoch > _epoch) {
+    _epoch = epoch;   // catch up with the other bridges (authenticated, so can only come from one of them)
+    _next_epoch_tick = millis() + UDP_BRIDGE_EPOCH_MILLIS;
+  }
+
+  size_t i = 0;
+  while (i < frames_len) {
+    uint8_t pkt_len = frames[i++];
+    if (pkt_len == 0 || i + pkt_len > frames_len) break;
+
+    mesh::Packet *pkt = _mgr->allocNew();
+    if (!pkt) break;
+
+    if (pkt->readFrom(&frames[i], pkt_len)) {
+      BRIDGE_DEBUG_PRINTLN("RX, len=%d\n", pkt_len);
+      onPacketReceived(pkt);
+    } else {
+      _mgr->free(pkt);
+    }
+    i += pkt_len;
+  }
+}
+
+void UDPBridge::flush() {
+  uint8_t buf[UDP_BRIDGE_MAX_DATAGRAM];
+
+  buf[0] = (BRIDGE_PACKET_MAGIC >> 8) & 0xFF;
+  buf[1] = BRIDGE_PACKET_MAGIC & 0xFF;
+  memcpy(&buf[2], &_sender_id, 4);
+  writeBE32(&buf[6], _next_seq);
+  writeBE32(&buf[10], _epoch);
+  _next_seq++;
+
+  ChaChaPoly cipher;
+  cipher.setKey(_key, sizeof(_key));
+  cipher.setIV(&buf[2], 8);
+  cipher.addAuthData(buf, HEADER_SIZE);
+  cipher.encrypt(&buf[HEADER_SIZE], _tx_frames, _tx_len);
+  cipher.computeTag(&buf[HEADER_SIZE + _tx_len], TAG_SIZE);
+  cipher.clear();
+
+  size_t total = HEADER_SIZE + _tx_len + TAG_SIZE;
+  _tx_len = 0;
+
+  if (_udp.beginMulticastPacket() && _udp.write(buf, total) == total && _udp.endPacket()) {
+    BRIDGE_DEBUG_PRINTLN("TX, datagram len=%d\n", total);
+  } else {
+    BRIDGE_DEBUG_PRINTLN("TX FAILED!\n");
+  }
+}
+
+void UDPBridge::sendPacket(mesh::Packet *packet) {
+  // Guard against uninitialized state, or not yet connected
+  if (!_initialized || !_udp_open) {
+    return;
+  }
+
+  if (!packet) {
+    BRIDGE_DEBUG_PRINTLN("TX invalid packet pointer\n");
+    return;
+  }
+
+  if (!_seen_packets.hasSeen(packet)) {
+    uint8_t raw[MAX_TRANS_UNIT + 1];
+    uint8_t len = packet->writeTo(raw);
+
+    if (_tx_len + 1 + len > MAX_FRAMES_SIZE) {
+      flush();   // no room, send what we have
+    }
+    if (_tx_len == 0) {
+      _tx_flush_at = millis() + UDP_BRIDGE_COALESCE_MILLIS;
+    }
+    _tx_frames[_tx_len++] = len;
+    memcpy(&_tx_frames[_tx_len], raw, len);
+    _tx_len += len;
+  }
+}
+
+void UDPBridge::onPacketReceived(mesh::Packet *packet) {
+  handleReceivedPacket(packet);
+}
+
+#endif
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "MeshCore.h"
+#include "helpers/bridges/BridgeBase.h"
+
+#ifdef WITH_UDP_BRIDGE
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#ifndef WIFI_SSID
+  #error "UDPBridge needs WIFI_SSID and WIFI_PWD defined"
+#endif
+
+#ifndef UDP_BRIDGE_PORT
+  #define UDP_BRIDGE_PORT   5880
+#endif
+
+#ifndef UDP_BRIDGE_GROUP
+  #define UDP_BRIDGE_GROUP  239, 0, 77, 1     // multicast group all bridges on the LAN join
+#endif
+
+#ifndef UDP_BRIDGE_MAX_DATAGRAM
+  #define UDP_BRIDGE_MAX_DATAGRAM   1200      // stays under typical path MTU, no IP fragmentation
+#endif
+
+#ifndef UDP_BRIDGE_COALESCE_MILLIS
+  #define UDP_BRIDGE_COALESCE_MILLIS   20     // max time a packet waits for others to share its datagram
+#endif
+
+#ifndef UDP_BRIDGE_MAX_PEERS
+  #define UDP_BRIDGE_MAX_PEERS   8
+#endif
+
+#ifndef UDP_BRIDGE_EPOCH_MILLIS
+  #define UDP_BRIDGE_EPOCH_MILLIS   60000     // how often the shared epoch counter ticks
+#endif
+
+#ifndef UDP_BRIDGE_EPOCH_SLACK
+  #define UDP_BRIDGE_EPOCH_SLACK    2         // epochs a new sender can lag behind ours (loop delays, LAN latency)
+#endif
+
+/**
+ * @brief Bridge implementation carrying mesh packets in UDP multicast datagrams over WiFi
+ *
+ * Lets mesh segments on the same LAN (or any network routing the multicast group) be joined,
+ * eg. repeaters at separate sites connected via a VPN.
+ *
+ * Features:
+ * - Several mesh packets coalesced into each datagram (flushed when full, or after UDP_BRIDGE_COALESCE_MILLIS)
+ * - ChaCha20-Poly1305 AEAD, keyed from SHA256(_prefs->bridge_secret), so datagrams from other networks
+ *   (or tampered ones) are rejected, not just scrambled
+ * - Per-sender sequence numbers with a sliding replay window, so re-sent/looped datagrams are dropped
+ *   before any packet is even parsed (ahead of the _seen_packets check)
+ * - Senders not in the replay windows (new, or evicted) must have a recent epoch, so old captured datagrams
+ *   can't be replayed once their window is gone. The epoch is a counter ticking every UDP_BRIDGE_EPOCH_MILLIS,
+ *   and each bridge adopts the highest one it authenticates, so all bridges converge on it without needing
+ *   synced RTC clocks. (a bridge that has only just booted can't tell stale datagrams from current ones, until
+ *   it hears its first one)
+ *
+ * Datagram Structure:
+ * [2 bytes] Magic Header
+ * [4 bytes] Sender ID - random per boot, so (sender, seq) never repeats as a nonce
+ * [4 bytes] Sequence number (big endian)
+ * [4 bytes] Epoch - sender's epoch counter (big endian)
+ * [n bytes] Encrypted frames, each: [1 byte] length, [length bytes] Packet::writeTo() data
+ * [16 bytes] Poly1305 tag, over the header (as associated data) and the encrypted frames
+ *
+ * Configuration:
+ * - Define WITH_UDP_BRIDGE to enable this bridge
+ * - Define WIFI_SSID and WIFI_PWD for the network to join
+ * - Optionally define UDP_BRIDGE_PORT and UDP_BRIDGE_GROUP
+ * - _prefs->bridge_secret sets the network key
+ */
+class UDPBridge : public BridgeBase {
+private:
+  static const size_t HEADER_SIZE = BRIDGE_MAGIC_SIZE + 4 + 4 + 4;
+  static const size_t TAG_SIZE = 16;
+  static const size_t MAX_FRAMES_SIZE = UDP_BRIDGE_MAX_DATAGRAM - HEADER_SIZE - TAG_SIZE;
+
+  struct PeerWindow {
+    uint32_t sender_id;
+    uint32_t max_seq;     // highest sequence number accepted
+    uint32_t bitmap;      // bit N set => (max_seq - N) was accepted
+    unsigned long last_heard;
+  };
+
+  WiFiUDP _udp;
+  bool _udp_open;
+  uint8_t _key[32];
+  uint32_t _sender_id;
+  uint32_t _next_seq;
+
+  /** TX coalescing buffer (plaintext frames) */
+  uint8_t _tx_frames[MAX_FRAMES_SIZE];
+  size_t _tx_len;
+  unsigned long _tx_flush_at;
+
+  PeerWindow _peers[UDP_BRIDGE_MAX_PEERS];
+
+  uint32_t _epoch;
+  unsigned long _next_epoch_tick;
+  uint32_t _n_rx_stale;   // datagrams dropped for having an old epoch
+
+  /**
+   * Encrypts and sends the pending frames (if any) as one datagram
+   */
+  void flush();
+
+  /**
+   * Decrypts and processes the datagram readied by parsePacket()
+   */
+  void checkRecv();
+
+  /**
+   * Checks the sequence number against the sender's replay window, and records it
+   *
+   * @param epoch sender's epoch, only checked if sender has no replay window
+   * @return true if this sequence number is new
+   */
+  bool acceptSequence(uint32_t sender_id, uint32_t seq, uint32_t epoch);
+
+  void computeKey();
+
+public:
+  /**
+   * Constructs a UDPBridge instance
+   *
+   * @param prefs Node preferences for configuration settings
+   * @param mgr PacketManager for allocating and queuing packets
+   * @param rtc RTCClock for timestamping debug messages
+   */
+  UDPBridge(NodePrefs *prefs, mesh::PacketManager *mgr, mesh::RTCClock *rtc);
+
+  /**
+   * Initializes the UDP bridge
+   *
+   * - Derives the AEAD key from bridge_secret
+   * - Starts joining the WiFi network (the multicast socket is opened once connected)
+   */
+  void begin() override;
+
+  /**
+   * Stops the UDP bridge, and turns off WiFi
+   */
+  void end() override;
+
+  /**
+   * Main loop handler
+   * Opens the socket once WiFi is up, receives datagrams and flushes coalesced packets
+   */
+  void loop() override;
+
+  /**
+   * @return number of authentic datagrams dropped, from unknown senders with a stale epoch
+   */
+  uint32_t getStaleRejectCount() const { return _n_rx_stale; }
+
+  /**
+   * Called when a packet is received via UDP
+   * Queues the packet for mesh processing if not seen before
+   *
+   * @param packet The received mesh packet
+   */
+  void onPacketReceived(mesh::Packet *packet) override;
+
+  /**
+   * Called when a packet needs to be transmitted via UDP
+   * Appends the packet to the pending datagram, if not seen before
+   *
+   * @param packet The mesh packet to transmit
+   */
+  void sendPacket(mesh::Packet *packet) override;
+};
+
+#endif
@@ -18,18 +18,10 @@ class SerialBLEInterface : public BaseSerialInterface, BLESecurityCallbacks, BLE
   unsigned long _last_write;
   unsigned long adv_restart_time;
 
-  struct Frame {
-    uint8_t len;
-    uint8_t buf[MAX_FRAME_SIZE];
-  };
+  FrameRing recv_queue;
+  FrameRing send_queue;
 
-  #define FRAME_QUEUE_SIZE  4
-  int recv_queue_len;
-  Frame recv_queue[FRAME_QUEUE_SIZE];
-  int send_queue_len;
-  Frame send_queue[FRAME_QUEUE_SIZE];
-
-  void clearBuffers() { recv_queue_len = 0; send_queue_len = 0; }
+  void clearBuffers() { recv_queue.clear(); send_queue.clear(); }
 
 protected:
   // BLESecurityCallbacks methods
@@ -49,7 +41,7 @@ protected:
   void onWrite(BLECharacteristic* pCharacteristic, esp_ble_gatts_cb_param_t* param) override;
 
 public:
-  SerialBLEInterface() {
+  SerialBLEInterface() : recv_queue(SERIAL_RECV_QUEUE_BYTES), send_queue(SERIAL_SEND_QUEUE_BYTES) {
     pServer = NULL;
     pService = NULL;
     deviceConnected = false;
@@ -58,7 +50,6 @@ public:
     _isEnabled = false;
     _last_write = 0;
     last_conn_id = 0;
-    send_queue_len = recv_queue_len = 0;
   }
 
   /**
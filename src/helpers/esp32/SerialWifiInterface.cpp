@@ -1,6 +1,11 @@
 #include "SerialWifiInterface.h"
 #include <WiFi.h>
 
+// max bytes of (small) frames to coalesce into a single TCP write
+#ifndef WIFI_WRITE_COALESCE_BYTES
+  #define WIFI_WRITE_COALESCE_BYTES  (4*(MAX_FRAME_SIZE+3))
+#endif
+
 void SerialWifiInterface::begin(int port) {
   // wifi setup is handled outside of this class, only starts the server
   server.begin(port);
@@ -25,22 +30,17 @@ size_t SerialWifiInterface::writeFrame(const uint8_t src[], size_t len) {
   }
 
   if (deviceConnected && len > 0) {
-    if (send_queue_len >= FRAME_QUEUE_SIZE) {
+    if (!send_queue.push(src, len)) {   // add to send queue
       WIFI_DEBUG_PRINTLN("writeFrame(), send_queue is full!");
       return 0;
     }
-
-    send_queue[send_queue_len].len = len;  // add to send queue
-    memcpy(send_queue[send_queue_len].buf, src, len);
-    send_queue_len++;
-
     return len;
   }
   return 0;
 }
 
 bool SerialWifiInterface::isWriteBusy() const {
-  return false;
+  return !send_queue.canFit(MAX_FRAME_SIZE);   // back-pressure: no room for another full frame
 }
 
 bool SerialWifiInterface::hasReceivedFrameHeader() {
@@ -82,21 +82,20 @@ size_t SerialWifiInterface::checkRecvFrame(uint8_t dest[]) {
   }
 
   if (deviceConnected) {
-    if (send_queue_len > 0) {   // first, check send queue
-      
+    if (!send_queue.isEmpty()) {   // first, check send queue
       _last_write = millis();
-      int len = send_queue[0].len;
-
-      uint8_t pkt[3+len]; // use same header as serial interface so client can delimit frames
-      pkt[0] = '>';
-      pkt[1] = (len & 0xFF);  // LSB
-      pkt[2] = (len >> 8);    // MSB
-      memcpy(&pkt[3], send_queue[0].buf, send_queue[0].len);
-      client.write(pkt, 3 + len);
-      send_queue_len--;
-      for (int i = 0; i < send_queue_len; i++) {   // delete top item from queue
-        send_queue[i] = send_queue[i + 1];
+
+      // coalesce as many queued frames as will fit into one TCP write
+      uint8_t pkt[WIFI_WRITE_COALESCE_BYTES];
+      int n = 0;
+      while (!send_queue.isEmpty() && n + 3 + send_queue.peekLen() <= sizeof(pkt)) {
+        int len = send_queue.pop(&pkt[n + 3]);
+        pkt[n] = '>';   // use same header as serial interface so client can delimit frames
+        pkt[n + 1] = (len & 0xFF);  // LSB
+        pkt[n + 2] = (len >> 8);    // MSB
+        n += 3 + len;
       }
+      client.write(pkt, n);
     } else {
 
       // check if we are waiting for a frame header
@@ -15,10 +15,7 @@ public:
   float getLastRSSI() const override { return ((CustomSX1262 *)_radio)->getRSSI(); }
   float getLastSNR() const override { return ((CustomSX1262 *)_radio)->getSNR(); }
 
-  float packetScore(float snr, int packet_len) override {
-    int sf = ((CustomSX1262 *)_radio)->spreadingFactor;
-    return packetScoreInt(snr, sf, packet_len);
-  }
+  int getSpreadingFactor() override { return ((CustomSX1262 *)_radio)->spreadingFactor; }
   virtual void powerOff() override {
     ((CustomSX1262 *)_radio)->sleep(false);
   }
@@ -38,6 +38,8 @@ void RadioLibWrapper::begin() {
   // start average out some samples
   _num_floor_samples = 0;
   _floor_sample_sum = 0;
+
+  onParamsChanged();
 }
 
 void RadioLibWrapper::idle() {
@@ -126,6 +128,7 @@ int RadioLibWrapper::recvRaw(uint8_t* bytes, int sz) {
 }
 
 uint32_t RadioLibWrapper::getEstAirtimeFor(int len_bytes) {
+  if (len_bytes >= 0 && len_bytes <= MAX_TRANS_UNIT) return _airtime[len_bytes];   // pre-calculated
   return _radio->getTimeOnAir(len_bytes) / 1000;
 }
 
@@ -179,14 +182,25 @@ static float snr_threshold[] = {
     -17.5,// SF11 needs at least -17.5 dB SNR
     -20   // SF12 needs at least -20 dB SNR
 };
-  
-float RadioLibWrapper::packetScoreInt(float snr, int sf, int packet_len) {
-  if (sf < 7) return 0.0f;
-  
-  if (snr < snr_threshold[sf - 7]) return 0.0f;    // Below threshold, no chance of success
 
-  auto success_rate_based_on_snr = (snr - snr_threshold[sf - 7]) / 10.0;
-  auto collision_penalty = 1 - (packet_len / 256.0);   // Assuming max packet of 256 bytes
+void RadioLibWrapper::onParamsChanged() {
+  _sf = getSpreadingFactor();
+  _snr_floor = (_sf >= 7 && _sf <= 12) ? snr_threshold[_sf - 7] : 1000.0f;   // unsupported SF, so score is always zero
+
+  // RadioLib's getTimeOnAir() is floating point, so pre-calc for all packet lengths
+  for (int len = 0; len <= MAX_TRANS_UNIT; len++) {
+    uint32_t t = _radio->getTimeOnAir(len) / 1000;
+    _airtime[len] = t > 0xFFFF ? 0xFFFF : t;
+  }
+  MESH_DEBUG_PRINTLN("RadioLibWrapper: sf=%d, airtime(%d) = %d millis", (int)_sf, MAX_TRANS_UNIT, (int)_airtime[MAX_TRANS_UNIT]);
+}
+
+float RadioLibWrapper::packetScore(float snr, int packet_len) {
+  if (snr < _snr_floor) return 0.0f;    // Below threshold, no chance of success
+
+  float success_rate_based_on_snr = (snr - _snr_floor) * 0.1f;
+  float collision_penalty = 1.0f - packet_len * (1.0f / 256.0f);   // Assuming max packet of 256 bytes
 
-  return max(0.0, min(1.0, success_rate_based_on_snr * collision_penalty));
+  float score = success_rate_based_on_snr * collision_penalty;
+  return score < 0.0f ? 0.0f : (score > 1.0f ? 1.0f : score);
 }
@@ -12,15 +12,21 @@ protected:
   uint16_t _num_floor_samples;
   int32_t _floor_sample_sum;
 
+  // derived from current modulation params (see onParamsChanged())
+  uint8_t _sf;
+  float _snr_floor;   // min SNR for successful reception, at current SF
+  uint16_t _airtime[MAX_TRANS_UNIT+1];   // est. airtime in millis, by packet length
+
   void idle();
   void startRecv();
-  float packetScoreInt(float snr, int sf, int packet_len);
   virtual bool isReceivingPacket() =0;
+  virtual int getSpreadingFactor() { return 10; }    // if not known, assume sf=10
 
 public:
   RadioLibWrapper(PhysicalLayer& radio, mesh::MainBoard& board) : _radio(&radio), _board(&board) { n_recv = n_sent = 0; }
 
   void begin() override;
+  void onParamsChanged() override;
   virtual void powerOff() { _radio->sleep(); }
   int recvRaw(uint8_t* bytes, int sz) override;
   uint32_t getEstAirtimeFor(int len_bytes) override;
@@ -52,7 +58,7 @@ public:
   virtual float getLastRSSI() const override;
   virtual float getLastSNR() const override;
 
-  float packetScore(float snr, int packet_len) override { return packetScoreInt(snr, 10, packet_len); }  // assume sf=10
+  float packetScore(float snr, int packet_len) override;
 };
 
 /**
@@ -6,6 +6,37 @@
 #define TELEM_WIRE &Wire  // Use default I2C bus for Environment Sensors
 #endif
 
+#ifndef ENV_SAMPLE_MILLIS
+#define ENV_SAMPLE_MILLIS        30000   // background sampling interval, environment sensors
+#endif
+#ifndef ENV_POWER_SAMPLE_MILLIS
+#define ENV_POWER_SAMPLE_MILLIS   5000   // background sampling interval, current/power sensors
+#endif
+#ifndef ENV_SAMPLE_ACTIVE_MILLIS
+#define ENV_SAMPLE_ACTIVE_MILLIS 600000   // sample at above intervals this long after a telemetry request
+#endif
+#ifndef ENV_IDLE_SAMPLE_MILLIS
+#define ENV_IDLE_SAMPLE_MILLIS   300000   // otherwise, only this often (so there's always a recent sample to send)
+#endif
+
+// sensor ids, for the SensorSampler
+enum {
+  ENV_SENSOR_AHTX0 = 1,
+  ENV_SENSOR_BME680,
+  ENV_SENSOR_BME280,
+  ENV_SENSOR_BMP280,
+  ENV_SENSOR_SHTC3,
+  ENV_SENSOR_SHT4X,
+  ENV_SENSOR_LPS22HB,
+  ENV_SENSOR_INA3221,
+  ENV_SENSOR_INA219,
+  ENV_SENSOR_INA260,
+  ENV_SENSOR_INA226,
+  ENV_SENSOR_MLX90614,
+  ENV_SENSOR_VL53L0X,
+  ENV_SENSOR_BMP085
+};
+
 #ifdef ENV_INCLUDE_BME680
 #ifndef TELEM_BME680_ADDRESS
 #define TELEM_BME680_ADDRESS 0x76
@@ -331,9 +362,63 @@ bool EnvironmentSensorManager::begin() {
   }
   #endif
 
+  // schedule background sampling, in telemetry order (at idle rate, until first request)
+  sampler.begin(this);
+  if (!isSampling()) sampler.setMinInterval(ENV_IDLE_SAMPLE_MILLIS);
+  #if ENV_INCLUDE_AHTX0
+  if (AHTX0_initialized) sampler.addSensor(ENV_SENSOR_AHTX0, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_BME680
+  if (BME680_initialized) sampler.addSensor(ENV_SENSOR_BME680, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_BME280
+  if (BME280_initialized) sampler.addSensor(ENV_SENSOR_BME280, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_BMP280
+  if (BMP280_initialized) sampler.addSensor(ENV_SENSOR_BMP280, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_SHTC3
+  if (SHTC3_initialized) sampler.addSensor(ENV_SENSOR_SHTC3, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_SHT4X
+  if (SHT4X_initialized) sampler.addSensor(ENV_SENSOR_SHT4X, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_LPS22HB
+  if (LPS22HB_initialized) sampler.addSensor(ENV_SENSOR_LPS22HB, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_INA3221
+  if (INA3221_initialized) sampler.addSensor(ENV_SENSOR_INA3221, ENV_POWER_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_INA219
+  if (INA219_initialized) sampler.addSensor(ENV_SENSOR_INA219, ENV_POWER_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_INA260
+  if (INA260_initialized) sampler.addSensor(ENV_SENSOR_INA260, ENV_POWER_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_INA226
+  if (INA226_initialized) sampler.addSensor(ENV_SENSOR_INA226, ENV_POWER_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_MLX90614
+  if (MLX90614_initialized) sampler.addSensor(ENV_SENSOR_MLX90614, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_VL53L0X
+  if (VL53L0X_initialized) sampler.addSensor(ENV_SENSOR_VL53L0X, ENV_SAMPLE_MILLIS);
+  #endif
+  #if ENV_INCLUDE_BMP085
+  if (BMP085_initialized) sampler.addSensor(ENV_SENSOR_BMP085, ENV_SAMPLE_MILLIS);
+  #endif
+
   return true;
 }
 
+bool EnvironmentSensorManager::isSampling() const {
+#ifdef ENV_BACKGROUND_SAMPLING
+  return true;   // always at full rate
+#else
+  return sample_until != 0 && (long)(millis() - sample_until) < 0;
+#endif
+}
+
 bool EnvironmentSensorManager::querySensors(uint8_t requester_permissions, CayenneLPP& telemetry) {
   next_available_channel = TELEM_CHANNEL_SELF + 1;
 
@@ -342,153 +427,221 @@ bool EnvironmentSensorManager::querySensors(uint8_t requester_permissions, Cayen
   }
 
   if (requester_permissions & TELEM_PERM_ENVIRONMENT) {
+    if (!isSampling()) {
+      // was sampling at idle rate, so reply with those (at most ENV_IDLE_SAMPLE_MILLIS old), and refresh for next time
+      sampler.setMinInterval(0);
+      sampler.requestAll(millis());
+    }
+    sample_until = millis() + ENV_SAMPLE_ACTIVE_MILLIS;   // others likely to follow, so sample at full rate for a while
+    if (sample_until == 0) sample_until = 1;
+
+    // serialise the latest samples
+    for (int i = 0; i < sampler.getNumSensors(); i++) {
+      int num;
+      const SensorReading* readings = sampler.getReadings(i, num);
+
+      int used_channels = 0;
+      for (int k = 0; k < num; k++) {
+        uint8_t channel = readings[k].channel;
+        if (SENSOR_CH_IS_NEXT(channel)) {
+          int n = channel & 0x7F;
+          channel = next_available_channel + n;
+          if (n + 1 > used_channels) used_channels = n + 1;
+        } else {
+          channel += TELEM_CHANNEL_SELF;
+        }
+
+        float value = readings[k].value;
+        switch (readings[k].type) {
+          case SENSOR_TEMPERATURE: telemetry.addTemperature(channel, value); break;
+          case SENSOR_HUMIDITY:    telemetry.addRelativeHumidity(channel, value); break;
+          case SENSOR_PRESSURE:    telemetry.addBarometricPressure(channel, value); break;
+          case SENSOR_ALTITUDE:    telemetry.addAltitude(channel, value); break;
+          case SENSOR_ANALOG:      telemetry.addAnalogInput(channel, value); break;
+          case SENSOR_VOLTAGE:     telemetry.addVoltage(channel, value); break;
+          case SENSOR_CURRENT:     telemetry.addCurrent(channel, value); break;
+          case SENSOR_POWER:       telemetry.addPower(channel, value); break;
+          case SENSOR_DISTANCE:    telemetry.addDistance(channel, value); break;
+        }
+      }
+      next_available_channel += used_channels;
+    }
+  }
 
-    #if ENV_INCLUDE_AHTX0
-    if (AHTX0_initialized) {
+  return true;
+}
+
+static int putReading(SensorReading dest[], int n, uint8_t type, uint8_t channel, float value) {
+  dest[n].type = type;
+  dest[n].channel = channel;
+  dest[n].value = value;
+  return n + 1;
+}
+
+int EnvironmentSensorManager::startSample(uint8_t sensor_id) {
+  switch (sensor_id) {
+  #if ENV_INCLUDE_BME680
+    case ENV_SENSOR_BME680: {
+      unsigned long ready_at = BME680.beginReading();   // non-blocking, result collected in readSample()
+      if (ready_at == 0) return -1;
+      long wait = (long)(ready_at - millis());
+      return wait > 0 ? wait : 1;
+    }
+  #endif
+  #if ENV_INCLUDE_VL53L0X
+    case ENV_SENSOR_VL53L0X:
+      return VL53L0X.startRange() ? 30 : -1;   // typical single range timing budget
+  #endif
+  }
+  return 0;   // read straight away
+}
+
+int EnvironmentSensorManager::readSample(uint8_t sensor_id, SensorReading dest[]) {
+  int n = 0;
+  switch (sensor_id) {
+  #if ENV_INCLUDE_AHTX0
+    case ENV_SENSOR_AHTX0: {
       sensors_event_t humidity, temp;
       AHTX0.getEvent(&humidity, &temp);
-      telemetry.addTemperature(TELEM_CHANNEL_SELF, temp.temperature);
-      telemetry.addRelativeHumidity(TELEM_CHANNEL_SELF, humidity.relative_humidity);
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), temp.temperature);
+      n = putReading(dest, n, SENSOR_HUMIDITY, SENSOR_CH_SELF(0), humidity.relative_humidity);
+      break;
     }
-    #endif
+  #endif
 
-    #if ENV_INCLUDE_BME680
-    if (BME680_initialized) {
-      if (BME680.performReading()) {
-        telemetry.addTemperature(TELEM_CHANNEL_SELF, BME680.temperature);
-        telemetry.addRelativeHumidity(TELEM_CHANNEL_SELF, BME680.humidity);
-        telemetry.addBarometricPressure(TELEM_CHANNEL_SELF, BME680.pressure / 100);
-        telemetry.addAltitude(TELEM_CHANNEL_SELF, 44330.0 * (1.0 - pow((BME680.pressure / 100) / TELEM_BME680_SEALEVELPRESSURE_HPA, 0.1903)));
-        telemetry.addAnalogInput(next_available_channel, BME680.gas_resistance);
-        next_available_channel++;
+  #if ENV_INCLUDE_BME680
+    case ENV_SENSOR_BME680:
+      if (BME680.endReading()) {
+        n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), BME680.temperature);
+        n = putReading(dest, n, SENSOR_HUMIDITY, SENSOR_CH_SELF(0), BME680.humidity);
+        n = putReading(dest, n, SENSOR_PRESSURE, SENSOR_CH_SELF(0), BME680.pressure / 100);
+        n = putReading(dest, n, SENSOR_ALTITUDE, SENSOR_CH_SELF(0), 44330.0 * (1.0 - pow((BME680.pressure / 100) / TELEM_BME680_SEALEVELPRESSURE_HPA, 0.1903)));
+        n = putReading(dest, n, SENSOR_ANALOG, SENSOR_CH_NEXT(0), BME680.gas_resistance);
       }
-    }
-    #endif
+      break;
+  #endif
 
-    #if ENV_INCLUDE_BME280
-    if (BME280_initialized) {
+  #if ENV_INCLUDE_BME280
+    case ENV_SENSOR_BME280:
       if (BME280.takeForcedMeasurement()) {  // trigger a fresh reading in forced mode
-        telemetry.addTemperature(TELEM_CHANNEL_SELF, BME280.readTemperature());
-        telemetry.addRelativeHumidity(TELEM_CHANNEL_SELF, BME280.readHumidity());
-        telemetry.addBarometricPressure(TELEM_CHANNEL_SELF, BME280.readPressure()/100);
-        telemetry.addAltitude(TELEM_CHANNEL_SELF, BME280.readAltitude(TELEM_BME280_SEALEVELPRESSURE_HPA));
+        n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), BME280.readTemperature());
+        n = putReading(dest, n, SENSOR_HUMIDITY, SENSOR_CH_SELF(0), BME280.readHumidity());
+        n = putReading(dest, n, SENSOR_PRESSURE, SENSOR_CH_SELF(0), BME280.readPressure()/100);
+        n = putReading(dest, n, SENSOR_ALTITUDE, SENSOR_CH_SELF(0), BME280.readAltitude(TELEM_BME280_SEALEVELPRESSURE_HPA));
       }
-    }
-    #endif
+      break;
+  #endif
 
-    #if ENV_INCLUDE_BMP280
-    if (BMP280_initialized) {
-      telemetry.addTemperature(TELEM_CHANNEL_SELF, BMP280.readTemperature());
-      telemetry.addBarometricPressure(TELEM_CHANNEL_SELF, BMP280.readPressure()/100);
-      telemetry.addAltitude(TELEM_CHANNEL_SELF, BMP280.readAltitude(TELEM_BMP280_SEALEVELPRESSURE_HPA));
-    }
-    #endif
+  #if ENV_INCLUDE_BMP280
+    case ENV_SENSOR_BMP280:
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), BMP280.readTemperature());
+      n = putReading(dest, n, SENSOR_PRESSURE, SENSOR_CH_SELF(0), BMP280.readPressure()/100);
+      n = putReading(dest, n, SENSOR_ALTITUDE, SENSOR_CH_SELF(0), BMP280.readAltitude(TELEM_BMP280_SEALEVELPRESSURE_HPA));
+      break;
+  #endif
 
-    #if ENV_INCLUDE_SHTC3
-    if (SHTC3_initialized) {
+  #if ENV_INCLUDE_SHTC3
+    case ENV_SENSOR_SHTC3: {
       sensors_event_t humidity, temp;
       SHTC3.getEvent(&humidity, &temp);
-
-      telemetry.addTemperature(TELEM_CHANNEL_SELF, temp.temperature);
-      telemetry.addRelativeHumidity(TELEM_CHANNEL_SELF, humidity.relative_humidity);
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), temp.temperature);
+      n = putReading(dest, n, SENSOR_HUMIDITY, SENSOR_CH_SELF(0), humidity.relative_humidity);
+      break;
     }
-    #endif
+  #endif
 
-    #if ENV_INCLUDE_SHT4X
-    if (SHT4X_initialized) {
+  #if ENV_INCLUDE_SHT4X
+    case ENV_SENSOR_SHT4X: {
       float sht4x_humidity, sht4x_temperature;
-      int16_t sht4x_error;
-      sht4x_error = SHT4X.measureLowestPrecision(sht4x_temperature, sht4x_humidity);
-      if (sht4x_error == 0) {
-        telemetry.addTemperature(TELEM_CHANNEL_SELF, sht4x_temperature);
-        telemetry.addRelativeHumidity(TELEM_CHANNEL_SELF, sht4x_humidity);
+      if (SHT4X.measureLowestPrecision(sht4x_temperature, sht4x_humidity) == 0) {
+        n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), sht4x_temperature);
+        n = putReading(dest, n, SENSOR_HUMIDITY, SENSOR_CH_SELF(0), sht4x_humidity);
       }
+      break;
     }
-    #endif
+  #endif
 
-    #if ENV_INCLUDE_LPS22HB
-    if (LPS22HB_initialized) {
-      telemetry.addTemperature(TELEM_CHANNEL_SELF, LPS22HB.readTemperature());
-      telemetry.addBarometricPressure(TELEM_CHANNEL_SELF, LPS22HB.readPressure() * 10); // convert kPa to hPa
-    }
-    #endif
+  #if ENV_INCLUDE_LPS22HB
+    case ENV_SENSOR_LPS22HB:
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), LPS22HB.readTemperature());
+      n = putReading(dest, n, SENSOR_PRESSURE, SENSOR_CH_SELF(0), LPS22HB.readPressure() * 10); // convert kPa to hPa
+      break;
+  #endif
 
-    #if ENV_INCLUDE_INA3221
-    if (INA3221_initialized) {
+  #if ENV_INCLUDE_INA3221
+    case ENV_SENSOR_INA3221: {
+      int ch = 0;
       for(int i = 0; i < TELEM_INA3221_NUM_CHANNELS; i++) {
         // add only enabled INA3221 channels to telemetry
         if (INA3221.isChannelEnabled(i)) {
           float voltage = INA3221.getBusVoltage(i);
           float current = INA3221.getCurrentAmps(i);
-          telemetry.addVoltage(next_available_channel, voltage);
-          telemetry.addCurrent(next_available_channel, current);
-          telemetry.addPower(next_available_channel, voltage * current);
-          next_available_channel++;
+          n = putReading(dest, n, SENSOR_VOLTAGE, SENSOR_CH_NEXT(ch), voltage);
+          n = putReading(dest, n, SENSOR_CURRENT, SENSOR_CH_NEXT(ch), current);
+          n = putReading(dest, n, SENSOR_POWER, SENSOR_CH_NEXT(ch), voltage * current);
+          ch++;
         }
       }
+      break;
     }
-    #endif
+  #endif
 
-    #if ENV_INCLUDE_INA219
-    if (INA219_initialized) {
-      telemetry.addVoltage(next_available_channel, INA219.getBusVoltage_V());
-      telemetry.addCurrent(next_available_channel, INA219.getCurrent_mA() / 1000);
-      telemetry.addPower(next_available_channel, INA219.getPower_mW() / 1000);
-      next_available_channel++;
-    }
-    #endif
+  #if ENV_INCLUDE_INA219
+    case ENV_SENSOR_INA219:
+      n = putReading(dest, n, SENSOR_VOLTAGE, SENSOR_CH_NEXT(0), INA219.getBusVoltage_V());
+      n = putReading(dest, n, SENSOR_CURRENT, SENSOR_CH_NEXT(0), INA219.getCurrent_mA() / 1000);
+      n = putReading(dest, n, SENSOR_POWER, SENSOR_CH_NEXT(0), INA219.getPower_mW() / 1000);
+      break;
+  #endif
 
-    #if ENV_INCLUDE_INA260
-    if (INA260_initialized) {
-      telemetry.addVoltage(next_available_channel, INA260.readBusVoltage() / 1000);
-      telemetry.addCurrent(next_available_channel, INA260.readCurrent() / 1000);
-      telemetry.addPower(next_available_channel, INA260.readPower() / 1000);
-      next_available_channel++;
-    }
-    #endif
+  #if ENV_INCLUDE_INA260
+    case ENV_SENSOR_INA260:
+      n = putReading(dest, n, SENSOR_VOLTAGE, SENSOR_CH_NEXT(0), INA260.readBusVoltage() / 1000);
+      n = putReading(dest, n, SENSOR_CURRENT, SENSOR_CH_NEXT(0), INA260.readCurrent() / 1000);
+      n = putReading(dest, n, SENSOR_POWER, SENSOR_CH_NEXT(0), INA260.readPower() / 1000);
+      break;
+  #endif
 
-    #if ENV_INCLUDE_INA226
-    if (INA226_initialized) {
-      telemetry.addVoltage(next_available_channel, INA226.getBusVoltage());
-      telemetry.addCurrent(next_available_channel, INA226.getCurrent_mA() / 1000.0);
-      telemetry.addPower(next_available_channel, INA226.getPower_mW() / 1000.0);
-      next_available_channel++;
-    }
-    #endif
+  #if ENV_INCLUDE_INA226
+    case ENV_SENSOR_INA226:
+      n = putReading(dest, n, SENSOR_VOLTAGE, SENSOR_CH_NEXT(0), INA226.getBusVoltage());
+      n = putReading(dest, n, SENSOR_CURRENT, SENSOR_CH_NEXT(0), INA226.getCurrent_mA() / 1000.0);
+      n = putReading(dest, n, SENSOR_POWER, SENSOR_CH_NEXT(0), INA226.getPower_mW() / 1000.0);
+      break;
+  #endif
 
-    #if ENV_INCLUDE_MLX90614
-    if (MLX90614_initialized) {
-      telemetry.addTemperature(TELEM_CHANNEL_SELF, MLX90614.readObjectTempC());
-      telemetry.addTemperature(TELEM_CHANNEL_SELF + 1, MLX90614.readAmbientTempC());
-    }
-    #endif
+  #if ENV_INCLUDE_MLX90614
+    case ENV_SENSOR_MLX90614:
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), MLX90614.readObjectTempC());
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(1), MLX90614.readAmbientTempC());
+      break;
+  #endif
 
-    #if ENV_INCLUDE_VL53L0X
-    if (VL53L0X_initialized) {
-      VL53L0X_RangingMeasurementData_t measure;
-      VL53L0X.rangingTest(&measure, false); // pass in 'true' to get debug data
-      if (measure.RangeStatus != 4) { // phase failures
-        telemetry.addDistance(TELEM_CHANNEL_SELF, measure.RangeMilliMeter / 1000.0f); // convert mm to m
-      } else {
-        telemetry.addDistance(TELEM_CHANNEL_SELF, 0.0f); // no valid measurement
+  #if ENV_INCLUDE_VL53L0X
+    case ENV_SENSOR_VL53L0X:
+      if (!VL53L0X.isRangeComplete()) return -1;   // poll again
+      {
+        uint16_t range_mm = VL53L0X.readRangeResult();
+        if (VL53L0X.readRangeStatus() != 4) { // phase failures
+          n = putReading(dest, n, SENSOR_DISTANCE, SENSOR_CH_SELF(0), range_mm / 1000.0f); // convert mm to m
+        } else {
+          n = putReading(dest, n, SENSOR_DISTANCE, SENSOR_CH_SELF(0), 0.0f); // no valid measurement
+        }
       }
-    }
-    #endif
-
-    #if ENV_INCLUDE_BMP085
-    if (BMP085_initialized) {
-        telemetry.addTemperature(TELEM_CHANNEL_SELF, BMP085.readTemperature());
-        telemetry.addBarometricPressure(TELEM_CHANNEL_SELF, BMP085.readPressure() / 100);
-        telemetry.addAltitude(TELEM_CHANNEL_SELF, BMP085.readAltitude(TELEM_BMP085_SEALEVELPRESSURE_HPA * 100));
-    }
-    #endif
+      break;
+  #endif
 
+  #if ENV_INCLUDE_BMP085
+    case ENV_SENSOR_BMP085:
+      n = putReading(dest, n, SENSOR_TEMPERATURE, SENSOR_CH_SELF(0), BMP085.readTemperature());
+      n = putReading(dest, n, SENSOR_PRESSURE, SENSOR_CH_SELF(0), BMP085.readPressure() / 100);
+      n = putReading(dest, n, SENSOR_ALTITUDE, SENSOR_CH_SELF(0), BMP085.readAltitude(TELEM_BMP085_SEALEVELPRESSURE_HPA * 100));
+      break;
+  #endif
   }
-
-  return true;
+  return n;
 }
 
-
 int EnvironmentSensorManager::getNumSettings() const {
   int settings = 0;
   #if ENV_INCLUDE_GPS
@@ -703,10 +856,18 @@ void EnvironmentSensorManager::stop_gps() {
   #endif
 }
 
+#endif
+
 void EnvironmentSensorManager::loop() {
-  static long next_gps_update = 0;
+  if (sample_until != 0 && !isSampling()) {   // no recent requests, back to idle rate
+    sample_until = 0;
+    sampler.setMinInterval(ENV_IDLE_SAMPLE_MILLIS);
+  }
+  sampler.loop(millis());
 
   #if ENV_INCLUDE_GPS
+  static long next_gps_update = 0;
+
   _location->loop();
   if (millis() > next_gps_update) {
 
@@ -733,4 +894,3 @@ void EnvironmentSensorManager::loop() {
   }
   #endif
 }
-#endif
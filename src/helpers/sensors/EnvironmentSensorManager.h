@@ -3,10 +3,13 @@
 #include <Mesh.h>
 #include <helpers/SensorManager.h>
 #include <helpers/sensors/LocationProvider.h>
+#include <helpers/sensors/SensorSampler.h>
 
-class EnvironmentSensorManager : public SensorManager {
+class EnvironmentSensorManager : public SensorManager, public SensorSamplerCallbacks {
 protected:
   int next_available_channel = TELEM_CHANNEL_SELF + 1;
+  SensorSampler sampler;   // sensors are read in background (at low rate unless recently asked), querySensors() serialises the latest samples
+  unsigned long sample_until = 0;   // end of full rate sampling, 0 = idle rate
 
   bool AHTX0_initialized = false;
   bool BME280_initialized = false;
@@ -38,6 +41,10 @@ protected:
   #endif
   #endif
 
+  // SensorSamplerCallbacks
+  int startSample(uint8_t sensor_id) override;
+  int readSample(uint8_t sensor_id, SensorReading dest[]) override;
+  bool isSampling() const;
 
 public:
   #if ENV_INCLUDE_GPS
@@ -48,9 +55,7 @@ public:
   #endif
   bool begin() override;
   bool querySensors(uint8_t requester_permissions, CayenneLPP& telemetry) override;
-  #if ENV_INCLUDE_GPS
   void loop() override;
-  #endif
   int getNumSettings() const override;
   const char* getSettingName(int i) const override;
   const char* getSettingValue(int i) const override;
@@ -0,0 +1,67 @@
+#include "SensorSampler.h"
+
+bool SensorSampler::addSensor(uint8_t sensor_id, uint32_t interval_millis) {
+  if (_num_slots >= SENSOR_SAMPLER_MAX_SENSORS) return false;
+
+  Slot& s = _slots[_num_slots++];
+  memset(&s, 0, sizeof(s));
+  s.sensor_id = sensor_id;
+  s.interval = interval_millis;
+  return true;
+}
+
+void SensorSampler::finishSample(Slot& s, int n, const SensorReading* readings, unsigned long now) {
+  if (n > SENSOR_MAX_READINGS) n = SENSOR_MAX_READINGS;
+  memcpy(s.readings, readings, n * sizeof(SensorReading));
+  s.num_readings = n;
+  s.taken_at = now ? now : 1;
+  s.converting = false;
+  s.due = now + (s.interval < _min_interval ? _min_interval : s.interval);
+}
+
+void SensorSampler::loop(unsigned long now) {
+  if (_callbacks == NULL) return;
+
+  for (int k = 0; k < _num_slots; k++) {
+    int i = (_next + k) % _num_slots;
+    Slot& s = _slots[i];
+
+    SensorReading tmp[SENSOR_MAX_READINGS];
+    if (s.converting) {
+      if ((long)(now - s.ready_at) < 0) continue;
+
+      int n = _callbacks->readSample(s.sensor_id, tmp);
+      if (n < 0) {   // not ready yet
+        if ((long)(now - s.started_at) < SENSOR_MAX_CONVERT_MILLIS) {
+          s.ready_at = now + SENSOR_POLL_MILLIS;
+        } else {
+          finishSample(s, 0, tmp, now);   // give up
+        }
+      } else {
+        finishSample(s, n, tmp, now);
+      }
+    } else {
+      if ((long)(now - s.due) < 0) continue;
+
+      int wait = _callbacks->startSample(s.sensor_id);
+      if (wait < 0) {
+        finishSample(s, 0, tmp, now);
+      } else if (wait == 0) {
+        int n = _callbacks->readSample(s.sensor_id, tmp);
+        finishSample(s, n < 0 ? 0 : n, tmp, now);
+      } else {
+        s.converting = true;
+        s.started_at = now;
+        s.ready_at = now + wait;
+      }
+    }
+    _next = (i + 1) % _num_slots;   // round-robin, so one slow sensor can't starve the others
+    return;   // only one step per loop()
+  }
+}
+
+void SensorSampler::requestAll(unsigned long now) {
+  for (int i = 0; i < _num_slots; i++) {
+    if (!_slots[i].converting) _slots[i].due = now;
+  }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef SENSOR_SAMPLER_MAX_SENSORS
+  #define SENSOR_SAMPLER_MAX_SENSORS   8
+#endif
+
+#define SENSOR_MAX_READINGS        9     // per sensor (eg. INA3221: 3 channels x volts/amps/watts)
+#define SENSOR_POLL_MILLIS        10     // re-check interval, while a conversion reports 'not ready'
+#define SENSOR_MAX_CONVERT_MILLIS  1000  // give up on a conversion after this
+
+enum SensorReadingType : uint8_t {
+  SENSOR_TEMPERATURE,
+  SENSOR_HUMIDITY,
+  SENSOR_PRESSURE,
+  SENSOR_ALTITUDE,
+  SENSOR_ANALOG,
+  SENSOR_VOLTAGE,
+  SENSOR_CURRENT,
+  SENSOR_POWER,
+  SENSOR_DISTANCE
+};
+
+#define SENSOR_CH_SELF(n)   (n)            // TELEM_CHANNEL_SELF + n
+#define SENSOR_CH_NEXT(n)   (0x80 | (n))   // this sensor's n'th allocated channel (allocated when serialised)
+#define SENSOR_CH_IS_NEXT(ch)  (((ch) & 0x80) != 0)
+
+struct SensorReading {
+  uint8_t type;       // SensorReadingType
+  uint8_t channel;    // SENSOR_CH_SELF() or SENSOR_CH_NEXT()
+  float value;
+};
+
+/**
+ * \brief  the sensor specific part of sampling. Sensors are identified by an id, chosen by the implementor.
+ */
+class SensorSamplerCallbacks {
+public:
+  /**
+   * \brief  start a conversion (if the sensor has a non-blocking way to)
+   * \returns  millis until result should be ready (0 = read straight away), or -1 if failed
+   */
+  virtual int startSample(uint8_t sensor_id) { return 0; }
+
+  /**
+   * \brief  collect the result of a conversion
+   * \returns  number of readings written to 'dest' (0 = failed), or -1 if not ready yet (will be polled again)
+   */
+  virtual int readSample(uint8_t sensor_id, SensorReading dest[]) = 0;
+};
+
+/**
+ * \brief  Samples sensors in the background, at most one sensor step per loop(), and caches the latest readings.
+ *         So telemetry requests can just serialise the cache, instead of doing (slow) bus I/O at request time.
+ *         No hardware dependencies, so can be driven by mock callbacks on a host.
+ */
+class SensorSampler {
+  struct Slot {
+    uint8_t sensor_id;
+    bool converting;
+    uint8_t num_readings;
+    uint32_t interval;
+    unsigned long due;
+    unsigned long started_at;
+    unsigned long ready_at;
+    unsigned long taken_at;    // 0 = never sampled
+    SensorReading readings[SENSOR_MAX_READINGS];
+  };
+
+  SensorSamplerCallbacks* _callbacks;
+  Slot _slots[SENSOR_SAMPLER_MAX_SENSORS];
+  int _num_slots;
+  int _next;
+  uint32_t _min_interval;
+
+  void finishSample(Slot& s, int n, const SensorReading* readings, unsigned long now);
+
+public:
+  SensorSampler() : _callbacks(NULL), _num_slots(0), _next(0), _min_interval(0) { }
+
+  void begin(SensorSamplerCallbacks* callbacks) { _callbacks = callbacks; _num_slots = 0; _next = 0; }
+
+  /**
+   * \brief  add a sensor to the schedule (first sample is due straight away)
+   * \returns  false if table is full
+   */
+  bool addSensor(uint8_t sensor_id, uint32_t interval_millis);
+
+  /**
+   * \brief  advances the schedule by at most one sensor step (start or collect a conversion)
+   */
+  void loop(unsigned long now);
+
+  /**
+   * \brief  stretches every sensor's interval to at least 'millis' (0 = use their own), eg. to sample at a low rate
+   *         while no one is asking. Takes effect from each sensor's next sample.
+   */
+  void setMinInterval(uint32_t millis) { _min_interval = millis; }
+
+  /**
+   * \brief  makes every sensor (not mid-conversion) due now, eg. when the cache is stale after loop() wasn't called
+   */
+  void requestAll(unsigned long now);
+
+  int getNumSensors() const { return _num_slots; }
+  uint8_t getSensorId(int idx) const { return _slots[idx].sensor_id; }
+  unsigned long getTakenAt(int idx) const { return _slots[idx].taken_at; }
+
+  /**
+   * \returns  the latest readings for sensor at 'idx' (num = 0 if last sample failed, or none yet)
+   */
+  const SensorReading* getReadings(int idx, int& num) const {
+    num = _slots[idx].num_readings;
+    return _slots[idx].readings;
+  }
+};
@@ -85,11 +85,18 @@ public:
     }
     
     int ellipsis_width = getTextWidth(ellipsis);
-    int str_len = strlen(temp_str);
-    
-    while (str_len > 0 && getTextWidth(temp_str) > max_width - ellipsis_width) {
-      temp_str[--str_len] = 0;
+
+    // binary search for longest prefix that fits (width only grows with length), so O(log n) measurements
+    int lo = 0, hi = strlen(temp_str) - 1;
+    while (lo < hi) {
+      int mid = (lo + hi + 1) / 2;
+      char saved = temp_str[mid];
+      temp_str[mid] = 0;
+      bool fits = getTextWidth(temp_str) <= max_width - ellipsis_width;
+      temp_str[mid] = saved;
+      if (fits) lo = mid; else hi = mid - 1;
     }
+    temp_str[lo] = 0;
     strcat(temp_str, ellipsis);
     
     setCursor(x, y);
@@ -97,4 +104,6 @@ public:
   }
   
   virtual void endFrame() = 0;
+
+  virtual uint32_t getBytesPushed() const { return 0; }   // total sent to panel, if driver tracks it
 };
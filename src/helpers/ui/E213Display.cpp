@@ -93,10 +93,14 @@ void E213Display::turnOff() {
 
 void E213Display::clear() {
   display->clear();
+  _tracker.invalidate();
 
 }
 
 void E213Display::startFrame(Color bkg) {
+  _tracker.startSignature();
+  _tracker.sign(bkg);
+
   // Fill screen with white first to ensure clean background
   display->fillRect(0, 0, width(), height(), WHITE);
 
@@ -109,6 +113,7 @@ void E213Display::startFrame(Color bkg) {
 void E213Display::setTextSize(int sz) {
   // The library handles text size internally
     display->setTextSize(sz);
+    _tracker.sign(sz);
 }
 
 void E213Display::setColor(Color c) {
@@ -117,24 +122,41 @@ void E213Display::setColor(Color c) {
 
 void E213Display::setCursor(int x, int y) {
     display->setCursor(x, y);
+    _tracker.sign(x);
+    _tracker.sign(y);
 }
 
 void E213Display::print(const char *str) {
     display->print(str);
+    _tracker.sign(str, strlen(str));
 }
 
 void E213Display::fillRect(int x, int y, int w, int h) {
     display->fillRect(x, y, w, h, BLACK);
+    _tracker.sign(1);
+    _tracker.sign(x);
+    _tracker.sign(y);
+    _tracker.sign(w);
+    _tracker.sign(h);
 }
 
 void E213Display::drawRect(int x, int y, int w, int h) {
     display->drawRect(x, y, w, h, BLACK);
+    _tracker.sign(2);
+    _tracker.sign(x);
+    _tracker.sign(y);
+    _tracker.sign(w);
+    _tracker.sign(h);
 }
 
 void E213Display::drawXbm(int x, int y, const uint8_t *bits, int w, int h) {
   // Width in bytes for bitmap processing
   uint16_t widthInBytes = (w + 7) / 8;
 
+  _tracker.sign(x);
+  _tracker.sign(y);
+  _tracker.sign(bits, widthInBytes * h);
+
   // Process the bitmap row by row
   for (int by = 0; by < h; by++) {
     // Scan across the row bit by bit
@@ -160,5 +182,8 @@ uint16_t E213Display::getTextWidth(const char *str) {
 }
 
 void E213Display::endFrame() {
+  if (_tracker.isSignatureChanged()) {   // skip the (slow) e-paper refresh if nothing was drawn differently
     display->update();
+  }
+  _tracker.endFrame();
 }
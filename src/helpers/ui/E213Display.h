@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DisplayDriver.h"
+#include "FrameTracker.h"
 
 #include <SPI.h>
 #include <Wire.h>
@@ -11,6 +12,7 @@ class E213Display : public DisplayDriver {
   BaseDisplay* display=NULL;
   bool _init = false;
   bool _isOn = false;
+  FrameTracker _tracker;   // signature mode, as frame buffer isn't accessible
 
 public:
   E213Display() : DisplayDriver(250, 122) {}
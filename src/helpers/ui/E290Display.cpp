@@ -47,9 +47,13 @@ void E290Display::turnOff() {
 
 void E290Display::clear() {
   display.clear();
+  _tracker.invalidate();
 }
 
 void E290Display::startFrame(Color bkg) {
+  _tracker.startSignature();
+  _tracker.sign(bkg);
+
   // Fill screen with white first to ensure clean background
   display.fillRect(0, 0, width(), height(), WHITE);
   if (bkg == LIGHT) {
@@ -61,6 +65,7 @@ void E290Display::startFrame(Color bkg) {
 void E290Display::setTextSize(int sz) {
   // The library handles text size internally
   display.setTextSize(sz);
+  _tracker.sign(sz);
 }
 
 void E290Display::setColor(Color c) {
@@ -69,24 +74,41 @@ void E290Display::setColor(Color c) {
 
 void E290Display::setCursor(int x, int y) {
   display.setCursor(x, y);
+  _tracker.sign(x);
+  _tracker.sign(y);
 }
 
 void E290Display::print(const char *str) {
   display.print(str);
+  _tracker.sign(str, strlen(str));
 }
 
 void E290Display::fillRect(int x, int y, int w, int h) {
   display.fillRect(x, y, w, h, BLACK);
+  _tracker.sign(1);
+  _tracker.sign(x);
+  _tracker.sign(y);
+  _tracker.sign(w);
+  _tracker.sign(h);
 }
 
 void E290Display::drawRect(int x, int y, int w, int h) {
   display.drawRect(x, y, w, h, BLACK);
+  _tracker.sign(2);
+  _tracker.sign(x);
+  _tracker.sign(y);
+  _tracker.sign(w);
+  _tracker.sign(h);
 }
 
 void E290Display::drawXbm(int x, int y, const uint8_t *bits, int w, int h) {
   // Width in bytes for bitmap processing
   uint16_t widthInBytes = (w + 7) / 8;
 
+  _tracker.sign(x);
+  _tracker.sign(y);
+  _tracker.sign(bits, widthInBytes * h);
+
   // Process the bitmap row by row
   for (int by = 0; by < h; by++) {
     // Scan across the row bit by bit
@@ -112,5 +134,8 @@ uint16_t E290Display::getTextWidth(const char *str) {
 }
 
 void E290Display::endFrame() {
-  display.update();
+  if (_tracker.isSignatureChanged()) {   // skip the (slow) e-paper refresh if nothing was drawn differently
+    display.update();
+  }
+  _tracker.endFrame();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DisplayDriver.h"
+#include "FrameTracker.h"
 
 #include <SPI.h>
 #include <Wire.h>
@@ -11,6 +12,7 @@ class E290Display : public DisplayDriver {
   EInkDisplay_VisionMasterE290 display;
   bool _init = false;
   bool _isOn = false;
+  FrameTracker _tracker;   // signature mode, as frame buffer isn't accessible
 
 public:
   E290Display() : DisplayDriver(296, 128) {}
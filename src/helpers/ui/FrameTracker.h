@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef FRAME_TRACKER_MAX_BANDS
+  #define FRAME_TRACKER_MAX_BANDS   64
+#endif
+
+#ifndef FRAME_CANVAS_MAX_BYTES     // max RAM a driver should spend on an off-screen frame buffer
+  #ifdef BOARD_HAS_PSRAM
+    #define FRAME_CANVAS_MAX_BYTES   (320*240*2)
+  #else
+    #define FRAME_CANVAS_MAX_BYTES   (160*80*2)
+  #endif
+#endif
+
+/**
+ * \brief  Shared change tracking for DisplayDriver backends, so unchanged parts of a frame aren't pushed to the panel.
+ *         Two modes:
+ *           - bands: driver has a frame buffer, split into bands (eg. OLED pages, or N rows of a canvas). Each band's
+ *             hash is compared with the last one pushed, and only changed bands need sending.
+ *           - signature: driver can't read back its frame buffer (eg. some e-paper libs), so hashes its draw calls
+ *             instead, and skips the whole refresh if the frame is identical to the last.
+ *         Also counts bytes pushed, for measuring bus usage.
+ */
+class FrameTracker {
+  uint32_t _band_hash[FRAME_TRACKER_MAX_BANDS];
+  int _num_bands;
+  uint32_t _sig, _last_sig;
+  bool _invalid;
+  uint32_t _bytes_pushed, _frame_bytes, _last_frame_bytes;
+
+public:
+  static uint32_t hash(const void* data, size_t len, uint32_t h = 2166136261UL) {   // FNV-1a
+    const uint8_t* p = (const uint8_t*) data;
+    while (len--) {
+      h ^= *p++;
+      h *= 16777619UL;
+    }
+    return h;
+  }
+
+  FrameTracker() : _num_bands(0), _sig(0), _last_sig(0), _invalid(true), _bytes_pushed(0), _frame_bytes(0), _last_frame_bytes(0) { }
+
+  void begin(int num_bands) {
+    _num_bands = num_bands > FRAME_TRACKER_MAX_BANDS ? FRAME_TRACKER_MAX_BANDS : num_bands;
+    invalidate();
+  }
+
+  /**
+   * \brief  panel contents are unknown (eg. after power on or a direct clear), so next frame must be pushed in full
+   */
+  void invalidate() { _invalid = true; }
+
+  /**
+   * \returns  true if band differs from what was last pushed (and records it as pushed)
+   */
+  bool isBandDirty(int band, const uint8_t* data, size_t len) {
+    uint32_t h = hash(data, len);
+    if (band >= _num_bands) return true;   // not tracked
+    if (!_invalid && h == _band_hash[band]) return false;
+    _band_hash[band] = h;
+    return true;
+  }
+
+  // signature mode
+  void startSignature() { _sig = 2166136261UL; }
+  void sign(const void* data, size_t len) { _sig = hash(data, len, _sig); }
+  void sign(int v) { sign(&v, sizeof(v)); }
+
+  /**
+   * \returns  true if frame's draw calls differ from last pushed frame (and records it as pushed)
+   */
+  bool isSignatureChanged() {
+    if (!_invalid && _sig == _last_sig) return false;
+    _last_sig = _sig;
+    return true;
+  }
+
+  /**
+   * \brief  call at end of each frame, after all pushes
+   */
+  void endFrame() {
+    _invalid = false;
+    _last_frame_bytes = _frame_bytes;
+    _frame_bytes = 0;
+  }
+
+  void addBytesPushed(uint32_t n) { _bytes_pushed += n; _frame_bytes += n; }
+  uint32_t getBytesPushed() const { return _bytes_pushed; }
+  uint32_t getLastFrameBytes() const { return _last_frame_bytes; }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "TextLayout.h"
+
+#ifndef pgm_read_byte
+  #define pgm_read_byte(addr)  (*(const uint8_t *)(addr))
+#endif
+
+#ifndef GLYPH_METRICS_FONTS
+  #define GLYPH_METRICS_FONTS   2    // fonts with cached widths (eg. the two text sizes a UI switches between)
+#endif
+
+/**
+ * \brief  RAM cache of glyph widths for fonts in the OLEDDisplay (ThingPulse) format, so measuring text doesn't
+ *         walk the font's jump table in flash for every glyph. A font's table is built on first use.
+ */
+class GlyphMetrics : public TextMeasurer {
+  struct Entry {
+    const uint8_t* font;
+    uint32_t last_used;
+    uint8_t widths[256];   // by font table index, 0 = not in font
+  };
+
+  Entry _fonts[GLYPH_METRICS_FONTS];
+  Entry* _curr;
+  const uint8_t* _font;
+  uint32_t _tick;
+  char (*_lookup)(const uint8_t ch);
+
+  Entry* load(const uint8_t* font) {
+    Entry* e = &_fonts[0];
+    for (int i = 0; i < GLYPH_METRICS_FONTS; i++) {
+      if (_fonts[i].font == font) {
+        _fonts[i].last_used = ++_tick;
+        return &_fonts[i];
+      }
+      if (_fonts[i].last_used < e->last_used) e = &_fonts[i];
+    }
+
+    // font header: width, height, first char, num chars, then jump table of 4 bytes per char (width is 4th)
+    e->font = font;
+    e->last_used = ++_tick;
+    memset(e->widths, 0, sizeof(e->widths));
+    uint8_t first = pgm_read_byte(font + 2);
+    int num = pgm_read_byte(font + 3);
+    for (int i = 0; i < num && first + i < 256; i++) {
+      e->widths[first + i] = pgm_read_byte(font + 4 + i*4 + 3);
+    }
+    return e;
+  }
+
+public:
+  GlyphMetrics() : _curr(NULL), _font(NULL), _tick(0), _lookup(NULL) {
+    memset(_fonts, 0, sizeof(_fonts));
+  }
+
+  void setFont(const uint8_t* font) {
+    if (font != _font) {
+      _font = font;
+      _curr = NULL;   // (re)load on next use
+    }
+  }
+
+  /**
+   * \brief  optional UTF-8 to font table index conversion, applied by charWidth()
+   */
+  void setLookup(char (*lookup)(const uint8_t ch)) { _lookup = lookup; }
+
+  /**
+   * \returns  width of glyph, by font table index (ie. after any UTF-8 lookup)
+   */
+  uint8_t glyphWidth(uint8_t code) {
+    if (_curr == NULL) _curr = load(_font);
+    return _curr->widths[code];
+  }
+
+  uint16_t charWidth(uint8_t c) override {
+    if (_lookup) {
+      c = (uint8_t) _lookup(c);
+      if (c == 0) return 0;
+    }
+    return glyphWidth(c);
+  }
+
+  uint32_t getMetricsId() const override { return (uint32_t) (uintptr_t) _font; }
+};
@@ -47,6 +47,8 @@ OLEDDisplay::OLEDDisplay() {
 	textAlignment = TEXT_ALIGN_LEFT;
 	fontData = ArialMT_Plain_10;
 	fontTableLookupFunction = DefaultFontTableLookup;
+	glyphMetrics.setFont(fontData);
+	glyphMetrics.setLookup(fontTableLookupFunction);
 	buffer = NULL;
 #ifdef OLEDDISPLAY_DOUBLE_BUFFER
 	buffer_back = NULL;
@@ -662,7 +664,6 @@ void OLEDDisplay::drawStringf( int16_t x, int16_t y, char* buffer, String format
 }
 
 uint16_t OLEDDisplay::drawStringMaxWidth(int16_t xMove, int16_t yMove, uint16_t maxLineWidth, const String &strUser) {
-  uint16_t firstChar  = pgm_read_byte(fontData + FIRST_CHAR_POS);
   uint16_t lineHeight = pgm_read_byte(fontData + HEIGHT_POS);
 
   const char* text = strUser.c_str();
@@ -681,7 +682,7 @@ uint16_t OLEDDisplay::drawStringMaxWidth(int16_t xMove, int16_t yMove, uint16_t
     char c = (this->fontTableLookupFunction)(text[i]);
     if (c == 0)
       continue;
-    strWidth += pgm_read_byte(fontData + JUMPTABLE_START + (c - firstChar) * JUMPTABLE_BYTES + JUMPTABLE_WIDTH);
+    strWidth += glyphMetrics.glyphWidth(c);
 
     // Always break on newline
     if (text[i] == '\n') {
@@ -731,8 +732,6 @@ uint16_t OLEDDisplay::drawStringMaxWidth(int16_t xMove, int16_t yMove, uint16_t
 }
 
 uint16_t OLEDDisplay::getStringWidth(const char* text, uint16_t length, bool utf8) {
-  uint16_t firstChar        = pgm_read_byte(fontData + FIRST_CHAR_POS);
-
   uint16_t stringWidth = 0;
   uint16_t maxWidth = 0;
 
@@ -743,7 +742,7 @@ uint16_t OLEDDisplay::getStringWidth(const char* text, uint16_t length, bool utf
       if (c == 0)
         continue;
     }
-    stringWidth += pgm_read_byte(fontData + JUMPTABLE_START + (c - firstChar) * JUMPTABLE_BYTES + JUMPTABLE_WIDTH);
+    stringWidth += glyphMetrics.glyphWidth(c);
     if (c == 10) {
       maxWidth = max(maxWidth, stringWidth);
       stringWidth = 0;
@@ -758,12 +757,17 @@ uint16_t OLEDDisplay::getStringWidth(const String &strUser) {
   return width;
 }
 
+uint16_t OLEDDisplay::drawStringRun(int16_t x, int16_t y, const char* text, uint16_t length, uint16_t width) {
+  return drawStringInternal(x, y, text, length, width, true);
+}
+
 void OLEDDisplay::setTextAlignment(OLEDDISPLAY_TEXT_ALIGNMENT textAlignment) {
   this->textAlignment = textAlignment;
 }
 
 void OLEDDisplay::setFont(const uint8_t *fontData) {
   this->fontData = fontData;
+  glyphMetrics.setFont(fontData);
 }
 
 void OLEDDisplay::displayOn(void) {
@@ -1150,6 +1154,7 @@ char* OLEDDisplay::utf8ascii(const String &str) {
 
 void OLEDDisplay::setFontTableLookupFunction(FontTableLookupFunction function) {
   this->fontTableLookupFunction = function;
+  glyphMetrics.setLookup(function);
 }
 
 
@@ -64,6 +64,7 @@ private:
 #endif
 
 #include "OLEDDisplayFonts.h"
+#include "GlyphMetrics.h"
 
 //#define DEBUG_OLEDDISPLAY(...) Serial.printf( __VA_ARGS__ )
 //#define DEBUG_OLEDDISPLAY(...) dprintf("%s",  __VA_ARGS__ )
@@ -265,6 +266,14 @@ class OLEDDisplay : public Stream {
     // Convencience method for the const char version
     uint16_t getStringWidth(const String &text);
 
+    // Draws a run of text which has already been measured (eg. a line from a TextLayout)
+    uint16_t drawStringRun(int16_t x, int16_t y, const char* text, uint16_t length, uint16_t width);
+
+    // Cached glyph widths of the current font, also usable as a TextMeasurer
+    GlyphMetrics& getGlyphMetrics() { return glyphMetrics; }
+
+    uint8_t getFontHeight() { return pgm_read_byte(fontData + HEIGHT_POS); }
+
     // Specifies relative to which anchor point
     // the text is rendered. Available constants:
     // TEXT_ALIGN_LEFT, TEXT_ALIGN_CENTER, TEXT_ALIGN_RIGHT, TEXT_ALIGN_CENTER_BOTH
@@ -390,6 +399,8 @@ class OLEDDisplay : public Stream {
     uint16_t drawStringInternal(int16_t xMove, int16_t yMove, const char* text, uint16_t textLength, uint16_t textWidth, bool utf8);
 
 	FontTableLookupFunction fontTableLookupFunction;
+
+    GlyphMetrics glyphMetrics;
 };
 
 #endif
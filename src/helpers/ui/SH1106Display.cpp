@@ -2,6 +2,9 @@
 #include <Adafruit_GrayOLED.h>
 #include "Adafruit_SH110X.h"
 
+#define SH1106_COLUMN_OFFSET   2     // SH1106 RAM is 132 columns wide, panel is centred
+#define I2C_CHUNK_SIZE        31     // data bytes per I2C transmission (+ 1 control byte, fits 32 byte Wire buffers)
+
 bool SH1106Display::i2c_probe(TwoWire &wire, uint8_t addr)
 {
   wire.beginTransmission(addr);
@@ -11,6 +14,7 @@ bool SH1106Display::i2c_probe(TwoWire &wire, uint8_t addr)
 
 bool SH1106Display::begin()
 {
+  _tracker.begin((height() + 7) / 8);
   return display.begin(DISPLAY_ADDRESS, true) && i2c_probe(Wire, DISPLAY_ADDRESS);
 }
 
@@ -30,6 +34,7 @@ void SH1106Display::clear()
 {
   display.clearDisplay();
   display.display();
+  _tracker.invalidate();
 }
 
 void SH1106Display::startFrame(Color bkg)
@@ -85,7 +90,47 @@ uint16_t SH1106Display::getTextWidth(const char *str)
   return w;
 }
 
+void SH1106Display::pushPage(int page, const uint8_t *data, int len)
+{
+  Wire.beginTransmission(DISPLAY_ADDRESS);
+  Wire.write((uint8_t)0x00);   // Co = 0, D/C = 0 (commands)
+  Wire.write((uint8_t)(SH110X_SETPAGEADDR + page));
+  Wire.write((uint8_t)(0x10 + (SH1106_COLUMN_OFFSET >> 4)));   // column address, high nibble
+  Wire.write((uint8_t)(SH1106_COLUMN_OFFSET & 0x0F));          // column address, low nibble
+  Wire.endTransmission();
+
+  while (len > 0) {
+    int n = len > I2C_CHUNK_SIZE ? I2C_CHUNK_SIZE : len;
+    Wire.beginTransmission(DISPLAY_ADDRESS);
+    Wire.write((uint8_t)0x40);   // Co = 0, D/C = 1 (data)
+    Wire.write(data, n);
+    Wire.endTransmission();
+    data += n;
+    len -= n;
+  }
+}
+
 void SH1106Display::endFrame()
 {
-  display.display();
+  // only push pages which changed since last frame (clearDisplay() in startFrame() marks whole screen dirty in
+  // Adafruit_SH110X, so display() would always send everything)
+  uint8_t *buf = display.getBuffer();
+  int page_len = width();
+  bool any = false;
+  for (int page = 0; page < (height() + 7) / 8; page++)
+  {
+    uint8_t *data = &buf[page * page_len];
+    if (_tracker.isBandDirty(page, data, page_len))
+    {
+      if (!any)
+      {
+        Wire.setClock(400000); // same as Adafruit_SH110X::display()
+        any = true;
+      }
+      pushPage(page, data, page_len);
+      _tracker.addBytesPushed(page_len);
+    }
+  }
+  if (any) Wire.setClock(100000);
+  _tracker.endFrame();
 }
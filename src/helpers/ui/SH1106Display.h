@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DisplayDriver.h"
+#include "FrameTracker.h"
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #define SH110X_NO_SPLASH
@@ -19,8 +20,10 @@ class SH1106Display : public DisplayDriver
   Adafruit_SH1106G display;
   bool _isOn;
   uint8_t _color;
+  FrameTracker _tracker;   // bands = pages (8 pixel rows)
 
   bool i2c_probe(TwoWire &wire, uint8_t addr);
+  void pushPage(int page, const uint8_t *data, int len);
 
 public:
   SH1106Display() : DisplayDriver(128, 64), display(128, 64, &Wire, PIN_OLED_RESET) { _isOn = false; }
@@ -40,4 +43,5 @@ public:
   void drawXbm(int x, int y, const uint8_t *bits, int w, int h) override;
   uint16_t getTextWidth(const char *str) override;
   void endFrame() override;
+  uint32_t getBytesPushed() const override { return _tracker.getBytesPushed(); }
 };
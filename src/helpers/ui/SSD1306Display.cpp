@@ -1,5 +1,7 @@
 #include "SSD1306Display.h"
 
+#define I2C_CHUNK_SIZE   31    // data bytes per I2C transmission (+ 1 control byte, fits 32 byte Wire buffers)
+
 bool SSD1306Display::i2c_probe(TwoWire& wire, uint8_t addr) {
   wire.beginTransmission(addr);
   uint8_t error = wire.endTransmission();
@@ -14,6 +16,7 @@ bool SSD1306Display::begin() {
   #ifdef DISPLAY_ROTATION
   display.setRotation(DISPLAY_ROTATION);
   #endif
+  _tracker.begin((height() + 7) / 8);
   return display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS, true, false) && i2c_probe(Wire, DISPLAY_ADDRESS);
 }
 
@@ -22,6 +25,7 @@ void SSD1306Display::turnOn() {
   if (!_isOn) {
     if (_peripher_power) _peripher_power->claim();
     _isOn = true;
+    _tracker.invalidate();   // panel RAM may have been lost while powered off, so next frame must push all pages
   }
 }
 
@@ -36,6 +40,7 @@ void SSD1306Display::turnOff() {
 void SSD1306Display::clear() {
   display.clearDisplay();
   display.display();
+  _tracker.invalidate();
 }
 
 void SSD1306Display::startFrame(Color bkg) {
@@ -82,6 +87,45 @@ uint16_t SSD1306Display::getTextWidth(const char* str) {
   return w;
 }
 
+void SSD1306Display::pushPage(int page, const uint8_t* data, int len) {
+  // NOTE: not via ssd1306_command(), as that drops the I2C clock back to 100kHz after each byte
+  Wire.beginTransmission(DISPLAY_ADDRESS);
+  Wire.write((uint8_t)0x00);   // Co = 0, D/C = 0 (command stream)
+  Wire.write((uint8_t)SSD1306_PAGEADDR);
+  Wire.write((uint8_t)page);
+  Wire.write((uint8_t)page);
+  Wire.write((uint8_t)SSD1306_COLUMNADDR);
+  Wire.write((uint8_t)0);
+  Wire.write((uint8_t)(len - 1));
+  Wire.endTransmission();
+
+  while (len > 0) {
+    int n = len > I2C_CHUNK_SIZE ? I2C_CHUNK_SIZE : len;
+    Wire.beginTransmission(DISPLAY_ADDRESS);
+    Wire.write((uint8_t)0x40);   // Co = 0, D/C = 1 (data)
+    Wire.write(data, n);
+    Wire.endTransmission();
+    data += n;
+    len -= n;
+  }
+}
+
 void SSD1306Display::endFrame() {
-  display.display();
+  // only push pages which changed since last frame (most frames only change a few, or none)
+  uint8_t* buf = display.getBuffer();
+  int page_len = width();
+  bool any = false;
+  for (int page = 0; page < (height() + 7) / 8; page++) {
+    uint8_t* data = &buf[page * page_len];
+    if (_tracker.isBandDirty(page, data, page_len)) {
+      if (!any) {
+        Wire.setClock(400000);   // same as Adafruit_SSD1306::display()
+        any = true;
+      }
+      pushPage(page, data, page_len);
+      _tracker.addBytesPushed(page_len);
+    }
+  }
+  if (any) Wire.setClock(100000);
+  _tracker.endFrame();
 }
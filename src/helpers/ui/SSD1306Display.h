@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DisplayDriver.h"
+#include "FrameTracker.h"
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #define SSD1306_NO_SPLASH
@@ -20,8 +21,10 @@ class SSD1306Display : public DisplayDriver {
   bool _isOn;
   uint8_t _color;
   RefCountedDigitalPin* _peripher_power;
+  FrameTracker _tracker;   // bands = pages (8 pixel rows)
 
   bool i2c_probe(TwoWire& wire, uint8_t addr);
+  void pushPage(int page, const uint8_t* data, int len);
 public:
   SSD1306Display(RefCountedDigitalPin* peripher_power=NULL) : DisplayDriver(128, 64), 
       display(128, 64, &Wire, PIN_OLED_RESET),
@@ -45,4 +48,5 @@ public:
   void drawXbm(int x, int y, const uint8_t* bits, int w, int h) override;
   uint16_t getTextWidth(const char* str) override;
   void endFrame() override;
+  uint32_t getBytesPushed() const override { return _tracker.getBytesPushed(); }
 };
@@ -1,5 +1,7 @@
 #include "ST7735Display.h"
 
+#define FRAME_BAND_ROWS   8    // rows per band, for change tracking
+
 #ifndef DISPLAY_ROTATION
   #define DISPLAY_ROTATION 2
 #endif
@@ -39,6 +41,16 @@ bool ST7735Display::begin() {
     display.setTextSize(2); 
     display.cp437(true);         // Use full 256 char 'Code Page 437' font
     
+    // off-screen frame buffer, so only changed rows need pushing (else draw straight to panel)
+    if (_canvas == NULL && display.width() * display.height() * 2 <= FRAME_CANVAS_MAX_BYTES) {
+      _canvas = new GFXcanvas16(display.width(), display.height());
+      if (_canvas->getBuffer() == NULL) {
+        delete _canvas;
+        _canvas = NULL;
+      }
+    }
+    _tracker.begin((display.height() + FRAME_BAND_ROWS - 1) / FRAME_BAND_ROWS);
+
     _isOn = true;
   }
   return true;
@@ -62,17 +74,19 @@ void ST7735Display::turnOff() {
 void ST7735Display::clear() {
   //Serial.println("DBG: display.Clear");
   display.fillScreen(ST77XX_BLACK);
+  if (_canvas) _canvas->fillScreen(ST77XX_BLACK);
+  _tracker.invalidate();
 }
 
 void ST7735Display::startFrame(Color bkg) {
-  display.fillScreen(0x00);
-  display.setTextColor(ST77XX_WHITE);
-  display.setTextSize(1);      // This one affects size of Please wait... message
-  display.cp437(true);         // Use full 256 char 'Code Page 437' font
+  gfx().fillScreen(0x00);
+  gfx().setTextColor(ST77XX_WHITE);
+  gfx().setTextSize(1);      // This one affects size of Please wait... message
+  gfx().cp437(true);         // Use full 256 char 'Code Page 437' font
 }
 
 void ST7735Display::setTextSize(int sz) {
-  display.setTextSize(sz);
+  gfx().setTextSize(sz);
 }
 
 void ST7735Display::setColor(Color c) {
@@ -102,36 +116,50 @@ void ST7735Display::setColor(Color c) {
       _color = ST77XX_WHITE;
       break;
   }
-  display.setTextColor(_color);
+  gfx().setTextColor(_color);
 }
 
 void ST7735Display::setCursor(int x, int y) {
-  display.setCursor(x*SCALE_X, y*SCALE_Y);
+  gfx().setCursor(x*SCALE_X, y*SCALE_Y);
 }
 
 void ST7735Display::print(const char* str) {
-  display.print(str);
+  gfx().print(str);
 }
 
 void ST7735Display::fillRect(int x, int y, int w, int h) {
-  display.fillRect(x*SCALE_X, y*SCALE_Y, w*SCALE_X, h*SCALE_Y, _color);
+  gfx().fillRect(x*SCALE_X, y*SCALE_Y, w*SCALE_X, h*SCALE_Y, _color);
 }
 
 void ST7735Display::drawRect(int x, int y, int w, int h) {
-  display.drawRect(x*SCALE_X, y*SCALE_Y, w*SCALE_X, h*SCALE_Y, _color);
+  gfx().drawRect(x*SCALE_X, y*SCALE_Y, w*SCALE_X, h*SCALE_Y, _color);
 }
 
 void ST7735Display::drawXbm(int x, int y, const uint8_t* bits, int w, int h) {
-  display.drawBitmap(x*SCALE_X, y*SCALE_Y, bits, w, h, _color);
+  gfx().drawBitmap(x*SCALE_X, y*SCALE_Y, bits, w, h, _color);
 }
 
 uint16_t ST7735Display::getTextWidth(const char* str) {
   int16_t x1, y1;
   uint16_t w, h;
-  display.getTextBounds(str, 0, 0, &x1, &y1, &w, &h);
+  gfx().getTextBounds(str, 0, 0, &x1, &y1, &w, &h);
   return w / SCALE_X;
 }
 
 void ST7735Display::endFrame() {
-  // display.display();
+  if (_canvas == NULL) return;   // was drawn straight to panel
+
+  // push only the bands of rows which changed since last frame
+  uint16_t* buf = _canvas->getBuffer();
+  int w = _canvas->width();
+  int h = _canvas->height();
+  for (int band = 0, y = 0; y < h; band++, y += FRAME_BAND_ROWS) {
+    int rows = (h - y) < FRAME_BAND_ROWS ? (h - y) : FRAME_BAND_ROWS;
+    uint16_t* data = &buf[y * w];
+    if (_tracker.isBandDirty(band, (const uint8_t *) data, w * rows * 2)) {
+      display.drawRGBBitmap(0, y, data, w, rows);
+      _tracker.addBytesPushed(w * rows * 2);
+    }
+  }
+  _tracker.endFrame();
 }
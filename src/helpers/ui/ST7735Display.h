@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DisplayDriver.h"
+#include "FrameTracker.h"
 #include <Wire.h>
 #include <SPI.h>
 #include <Adafruit_GFX.h>
@@ -12,8 +13,11 @@ class ST7735Display : public DisplayDriver {
   bool _isOn;
   uint16_t _color;
   RefCountedDigitalPin* _peripher_power;
+  GFXcanvas16* _canvas = NULL;   // frame buffer, if enough RAM
+  FrameTracker _tracker;
 
   bool i2c_probe(TwoWire& wire, uint8_t addr);
+  Adafruit_GFX& gfx() { return _canvas ? *(Adafruit_GFX*)_canvas : display; }
 public:
 #ifdef USE_PIN_TFT
   ST7735Display(RefCountedDigitalPin* peripher_power=NULL) : DisplayDriver(128, 64), 
@@ -46,4 +50,5 @@ public:
   void drawXbm(int x, int y, const uint8_t* bits, int w, int h) override;
   uint16_t getTextWidth(const char* str) override;
   void endFrame() override;
+  uint32_t getBytesPushed() const override { return _tracker.getBytesPushed(); }
 };
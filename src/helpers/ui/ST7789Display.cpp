@@ -135,7 +135,17 @@ void ST7789Display::print(const char* str) {
 }
 
 void ST7789Display::printWordWrap(const char* str, int max_width) {
-  display.drawStringMaxWidth(_x, _y, max_width*SCALE_X, str);
+  // lines are cached, so re-rendering the same message doesn't re-measure it
+  const TextLayout& layout = _layouts.get(str, max_width*SCALE_X, display.getGlyphMetrics());
+  int line_height = display.getFontHeight();
+  int bottom = display.getHeight();
+  for (int i = 0; i < layout.getNumLines(); i++) {
+    int y = _y + i*line_height;
+    if (y >= bottom) break;   // rest is off screen
+
+    const TextRun& r = layout.getLine(i);
+    if (r.len > 0) display.drawStringRun(_x, y, &str[r.start], r.len, r.width);   // (blank lines just take up space)
+  }
 }
 
 void ST7789Display::fillRect(int x, int y, int w, int h) {
@@ -5,12 +5,14 @@
 #include <SPI.h>
 #include <Adafruit_GFX.h>
 #include "ST7789Spi.h"
+#include "TextLayout.h"
 
 class ST7789Display : public DisplayDriver {
   ST7789Spi display;
   bool _isOn;
   uint16_t _color;
   int _x=0, _y=0;
+  TextLayoutCache _layouts;
 
   bool i2c_probe(TwoWire& wire, uint8_t addr);
 public:
@@ -1,5 +1,7 @@
 #include "ST7789LCDDisplay.h"
 
+#define FRAME_BAND_ROWS   8    // rows per band, for change tracking
+
 #ifndef DISPLAY_ROTATION
   #define DISPLAY_ROTATION 3
 #endif
@@ -49,6 +51,16 @@ bool ST7789LCDDisplay::begin() {
     display.setTextSize(2 * DISPLAY_SCALE_X); 
     display.cp437(true); // Use full 256 char 'Code Page 437' font
   
+    // off-screen frame buffer, so only changed rows need pushing (else draw straight to panel)
+    if (_canvas == NULL && display.width() * display.height() * 2 <= FRAME_CANVAS_MAX_BYTES) {
+      _canvas = new GFXcanvas16(display.width(), display.height());
+      if (_canvas->getBuffer() == NULL) {
+        delete _canvas;
+        _canvas = NULL;
+      }
+    }
+    _tracker.begin((display.height() + FRAME_BAND_ROWS - 1) / FRAME_BAND_ROWS);
+
     _isOn = true;
   }
 
@@ -78,17 +90,21 @@ void ST7789LCDDisplay::turnOff() {
 
 void ST7789LCDDisplay::clear() {
   display.fillScreen(ST77XX_BLACK);
+  if (_canvas) _canvas->fillScreen(ST77XX_BLACK);
+  _tracker.invalidate();
 }
 
 void ST7789LCDDisplay::startFrame(Color bkg) {
-  display.fillScreen(ST77XX_BLACK);
-  display.setTextColor(ST77XX_WHITE);
-  display.setTextSize(1 * DISPLAY_SCALE_X); // This one affects size of Please wait... message
-  display.cp437(true); // Use full 256 char 'Code Page 437' font
+  gfx().fillScreen(ST77XX_BLACK);
+  gfx().setTextColor(ST77XX_WHITE);
+  _text_size = 1 * DISPLAY_SCALE_X;
+  gfx().setTextSize(_text_size); // This one affects size of Please wait... message
+  gfx().cp437(true); // Use full 256 char 'Code Page 437' font
 }
 
 void ST7789LCDDisplay::setTextSize(int sz) {
-  display.setTextSize(sz * DISPLAY_SCALE_X);
+  _text_size = sz * DISPLAY_SCALE_X;
+  gfx().setTextSize(_text_size);
 }
 
 void ST7789LCDDisplay::setColor(Color c) {
@@ -118,23 +134,35 @@ void ST7789LCDDisplay::setColor(Color c) {
       _color = ST77XX_WHITE;
       break;
   }
-  display.setTextColor(_color);
+  gfx().setTextColor(_color);
 }
 
 void ST7789LCDDisplay::setCursor(int x, int y) {
-  display.setCursor(x * DISPLAY_SCALE_X, y * DISPLAY_SCALE_Y);
+  gfx().setCursor(x * DISPLAY_SCALE_X, y * DISPLAY_SCALE_Y);
 }
 
 void ST7789LCDDisplay::print(const char* str) {
-  display.print(str);
+  gfx().print(str);
+}
+
+void ST7789LCDDisplay::printWordWrap(const char* str, int max_width) {
+  _measurer.setAdvance(6 * _text_size);
+  const TextLayout& layout = _layouts.get(str, max_width * DISPLAY_SCALE_X, _measurer);
+  int16_t x = gfx().getCursorX();
+  int16_t y = gfx().getCursorY();
+  for (int i = 0; i < layout.getNumLines() && y < gfx().height(); i++, y += 8 * _text_size) {
+    const TextRun& r = layout.getLine(i);
+    gfx().setCursor(x, y);
+    for (int j = 0; j < r.len; j++) gfx().write(str[r.start + j]);
+  }
 }
 
 void ST7789LCDDisplay::fillRect(int x, int y, int w, int h) {
-  display.fillRect(x * DISPLAY_SCALE_X, y * DISPLAY_SCALE_Y, w * DISPLAY_SCALE_X, h * DISPLAY_SCALE_Y, _color);
+  gfx().fillRect(x * DISPLAY_SCALE_X, y * DISPLAY_SCALE_Y, w * DISPLAY_SCALE_X, h * DISPLAY_SCALE_Y, _color);
 }
 
 void ST7789LCDDisplay::drawRect(int x, int y, int w, int h) {
-  display.drawRect(x * DISPLAY_SCALE_X, y * DISPLAY_SCALE_Y, w * DISPLAY_SCALE_X, h * DISPLAY_SCALE_Y, _color);
+  gfx().drawRect(x * DISPLAY_SCALE_X, y * DISPLAY_SCALE_Y, w * DISPLAY_SCALE_X, h * DISPLAY_SCALE_Y, _color);
 }
 
 void ST7789LCDDisplay::drawXbm(int x, int y, const uint8_t* bits, int w, int h) {
@@ -148,7 +176,7 @@ void ST7789LCDDisplay::drawXbm(int x, int y, const uint8_t* bits, int w, int h)
       if (pixelOn) {
         for (int dy = 0; dy < DISPLAY_SCALE_X; dy++) {
           for (int dx = 0; dx < DISPLAY_SCALE_X; dx++) {
-            display.drawPixel(x * DISPLAY_SCALE_X + i * DISPLAY_SCALE_X + dx, y * DISPLAY_SCALE_Y + j * DISPLAY_SCALE_X + dy, _color);
+            gfx().drawPixel(x * DISPLAY_SCALE_X + i * DISPLAY_SCALE_X + dx, y * DISPLAY_SCALE_Y + j * DISPLAY_SCALE_X + dy, _color);
           }
         }
       }
@@ -157,13 +185,32 @@ void ST7789LCDDisplay::drawXbm(int x, int y, const uint8_t* bits, int w, int h)
 }
 
 uint16_t ST7789LCDDisplay::getTextWidth(const char* str) {
-  int16_t x1, y1;
-  uint16_t w, h;
-  display.getTextBounds(str, 0, 0, &x1, &y1, &w, &h);
-
-  return w / DISPLAY_SCALE_X;
+  // built-in font is fixed width (6 x 8, scaled), so no need for getTextBounds() to walk every glyph
+  int n = 0, longest = 0;
+  for (const char* p = str; *p; p++) {
+    if (*p == '\n') {
+      n = 0;
+    } else if (*p != '\r' && ++n > longest) {
+      longest = n;
+    }
+  }
+  return longest * 6 * _text_size / DISPLAY_SCALE_X;
 }
 
 void ST7789LCDDisplay::endFrame() {
-  // display.display();
-}
\ No newline at end of file
+  if (_canvas == NULL) return;   // was drawn straight to panel
+
+  // push only the bands of rows which changed since last frame
+  uint16_t* buf = _canvas->getBuffer();
+  int w = _canvas->width();
+  int h = _canvas->height();
+  for (int band = 0, y = 0; y < h; band++, y += FRAME_BAND_ROWS) {
+    int rows = (h - y) < FRAME_BAND_ROWS ? (h - y) : FRAME_BAND_ROWS;
+    uint16_t* data = &buf[y * w];
+    if (_tracker.isBandDirty(band, (const uint8_t *) data, w * rows * 2)) {
+      display.drawRGBBitmap(0, y, data, w, rows);
+      _tracker.addBytesPushed(w * rows * 2);
+    }
+  }
+  _tracker.endFrame();
+}
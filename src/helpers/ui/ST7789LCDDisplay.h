@@ -1,6 +1,8 @@
 #pragma once
 
 #include "DisplayDriver.h"
+#include "FrameTracker.h"
+#include "TextLayout.h"
 #include <Wire.h>
 #include <SPI.h>
 #include <Adafruit_GFX.h>
@@ -15,8 +17,14 @@ class ST7789LCDDisplay : public DisplayDriver {
   bool _isOn;
   uint16_t _color;
   RefCountedDigitalPin* _peripher_power;
+  GFXcanvas16* _canvas = NULL;   // frame buffer, if enough RAM
+  FrameTracker _tracker;
+  uint8_t _text_size = 1;
+  FixedWidthMeasurer _measurer;
+  TextLayoutCache _layouts;
 
   bool i2c_probe(TwoWire& wire, uint8_t addr);
+  Adafruit_GFX& gfx() { return _canvas ? *(Adafruit_GFX*)_canvas : display; }
 public:
 #ifdef USE_PIN_TFT
   ST7789LCDDisplay(RefCountedDigitalPin* peripher_power=NULL) : DisplayDriver(128, 64), 
@@ -52,9 +60,11 @@ public:
   void setColor(Color c) override;
   void setCursor(int x, int y) override;
   void print(const char* str) override;
+  void printWordWrap(const char* str, int max_width) override;
   void fillRect(int x, int y, int w, int h) override;
   void drawRect(int x, int y, int w, int h) override;
   void drawXbm(int x, int y, const uint8_t* bits, int w, int h) override;
   uint16_t getTextWidth(const char* str) override;
   void endFrame() override;
+  uint32_t getBytesPushed() const override { return _tracker.getBytesPushed(); }
 };
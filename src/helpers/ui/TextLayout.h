@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef TEXT_LAYOUT_MAX_LINES
+  #define TEXT_LAYOUT_MAX_LINES    16
+#endif
+
+#ifndef TEXT_LAYOUT_CACHE_SIZE
+  #define TEXT_LAYOUT_CACHE_SIZE    4     // eg. the messages currently in view
+#endif
+
+/**
+ * \brief  measures text for TextLayout, one char at a time, in the driver's own units
+ */
+class TextMeasurer {
+public:
+  /**
+   * \brief  called for each byte of the text, in order (so may keep UTF-8 decoding state)
+   * \returns  advance width of the char (0 = not drawn)
+   */
+  virtual uint16_t charWidth(uint8_t c) = 0;
+
+  /**
+   * \returns  an id which changes whenever widths would (eg. the current font), so stale layouts aren't reused
+   */
+  virtual uint32_t getMetricsId() const = 0;
+};
+
+struct TextRun {
+  uint16_t start;   // offset into text
+  uint16_t len;
+  uint16_t width;
+};
+
+/**
+ * \brief  for fixed width fonts (eg. Adafruit GFX built-in font)
+ */
+class FixedWidthMeasurer : public TextMeasurer {
+  uint16_t _advance;
+public:
+  FixedWidthMeasurer(uint16_t advance = 6) : _advance(advance) { }
+
+  void setAdvance(uint16_t advance) { _advance = advance; }
+  uint16_t charWidth(uint8_t c) override { return _advance; }
+  uint32_t getMetricsId() const override { return _advance; }
+};
+
+/**
+ * \brief  Word-wrapped lines of a text, as runs which can be drawn without re-measuring.
+ *         Lines are broken after a space, dash or slash where possible, else mid-word, and always at '\n'.
+ */
+class TextLayout {
+  uint32_t _key;         // calcKey() of what was laid out, 0 = none
+  uint16_t _text_len;
+  uint8_t _num_lines;
+  bool _truncated;
+  TextRun _lines[TEXT_LAYOUT_MAX_LINES];
+
+  bool addLine(uint16_t start, uint16_t len, uint16_t width) {
+    if (_num_lines >= TEXT_LAYOUT_MAX_LINES) {
+      _truncated = true;
+      return false;
+    }
+    TextRun& r = _lines[_num_lines++];
+    r.start = start; r.len = len; r.width = width;
+    return true;
+  }
+
+public:
+  static uint32_t calcKey(const char* text, int max_width, uint32_t metrics_id) {
+    uint32_t h = 2166136261UL;   // FNV-1a
+    while (*text) {
+      h ^= (uint8_t) *text++;
+      h *= 16777619UL;
+    }
+    h ^= (uint32_t) max_width * 31 + metrics_id;
+    h *= 16777619UL;
+    return h ? h : 1;
+  }
+
+  TextLayout() : _key(0), _text_len(0), _num_lines(0), _truncated(false) { }
+
+  bool matches(uint32_t key, const char* text) const { return _key == key && _text_len == strlen(text); }
+  void reset() { _key = 0; _num_lines = 0; }
+
+  /**
+   * \brief  breaks 'text' into lines no wider than 'max_width'
+   */
+  void layout(const char* text, int max_width, TextMeasurer& m) {
+    _key = calcKey(text, max_width, m.getMetricsId());
+    _text_len = strlen(text);
+    _num_lines = 0;
+    _truncated = false;
+
+    int start = 0, width = 0;
+    int brk = -1, brk_width = 0;   // last preferred break point, and width of line up to it
+    for (int i = 0; i < _text_len; i++) {
+      char c = text[i];
+      if (c == '\n') {
+        if (!addLine(start, i - start, width)) return;
+        start = i + 1; width = 0; brk = -1;
+        continue;
+      }
+      int w = m.charWidth(c);
+      if (width + w > max_width && i > start) {
+        if (brk > start) {   // wrap at last space/dash
+          if (!addLine(start, brk - start, brk_width)) return;
+          start = brk; width -= brk_width;
+        }
+        if (width + w > max_width && i > start) {   // still too long, wrap mid-word
+          if (!addLine(start, i - start, width)) return;
+          start = i; width = 0;
+        }
+        brk = -1;
+      }
+      width += w;
+      if (c == ' ' || c == '-' || c == '/') {
+        brk = i + 1; brk_width = width;
+      }
+    }
+    if (start < _text_len) addLine(start, _text_len - start, width);
+  }
+
+  int getNumLines() const { return _num_lines; }
+  const TextRun& getLine(int i) const { return _lines[i]; }
+  bool isTruncated() const { return _truncated; }   // more than TEXT_LAYOUT_MAX_LINES
+};
+
+/**
+ * \brief  keeps the layouts of the most recently drawn texts, so re-rendering an unchanged screen (or scrolling a
+ *         list) skips the measuring and line-breaking.
+ */
+class TextLayoutCache {
+  TextLayout _entries[TEXT_LAYOUT_CACHE_SIZE];
+  uint32_t _last_used[TEXT_LAYOUT_CACHE_SIZE];
+  uint32_t _tick, _hits, _misses;
+
+public:
+  TextLayoutCache() : _tick(0), _hits(0), _misses(0) { memset(_last_used, 0, sizeof(_last_used)); }
+
+  const TextLayout& get(const char* text, int max_width, TextMeasurer& m) {
+    uint32_t key = TextLayout::calcKey(text, max_width, m.getMetricsId());
+    int lru = 0;
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SIZE; i++) {
+      if (_entries[i].matches(key, text)) {
+        _last_used[i] = ++_tick;
+        _hits++;
+        return _entries[i];
+      }
+      if (_last_used[i] < _last_used[lru]) lru = i;
+    }
+    _misses++;
+    _entries[lru].layout(text, max_width, m);
+    _last_used[lru] = ++_tick;
+    return _entries[lru];
+  }
+
+  void clear() {
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SIZE; i++) _entries[i].reset();
+  }
+
+  uint32_t getHits() const { return _hits; }
+  uint32_t getMisses() const { return _misses; }
+};
@@ -14,12 +14,21 @@
 #define KEY_PREV           0xF2
 #define KEY_CONTEXT_MENU   0xF3
 
+#define UI_RENDER_IDLE   0x7FFFFFFF   // render() result: nothing time based on screen, only re-render when invalidated
+#define UI_DIRTY_ALL     0xFFFFFFFF
+
 class UIScreen {
+  uint32_t _dirty;
 protected:
-  UIScreen() { }
+  UIScreen() { _dirty = UI_DIRTY_ALL; }
 public:
-  virtual int render(DisplayDriver& display) =0;   // return value is number of millis until next render
+  virtual int render(DisplayDriver& display) =0;   // return value is number of millis until time based content is stale (eg. '5s ago'), or UI_RENDER_IDLE
   virtual bool handleInput(char c) { return false; }
-  virtual void poll() { }
+  virtual void poll() { }   // check watched state, and invalidate() parts that changed
+
+  // screen is only re-rendered when some part of it is invalidated (or render() result expires)
+  void invalidate(uint32_t parts = UI_DIRTY_ALL) { _dirty |= parts; }
+  uint32_t getDirty() const { return _dirty; }
+  void clearDirty() { _dirty = 0; }
 };
 